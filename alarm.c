@@ -18,18 +18,92 @@
 
 /*!@file alarm.c
  * @brief Simple alarm application.
- * Calculates the mean of a captured picture and compares it with the mean
- * of the last pictures. If the difference exceeds a threshold, the alarm is
- * activated (GPIO is activated). */
+ * Compares every captured picture pixel by pixel with a background model.
+ * If enough pixels differ from the background, the alarm is activated (GPIO
+ * is activated). Detection continues while the alarm lasts and the baseline
+ * is rebuilt frame by frame. A change of the mean of the picture compared to
+ * the mean of the last pictures together with most pixels changing is
+ * treated as a global lighting change and the background is learned again.
+ * The detection itself is done by the engine in detect.c.
+ * On a colour sensor, the pictures are converted from the Bayer mosaic to
+ * luma first. The mean is taken from a thumbnail gathered by DMA while the
+ * CPU converts the picture. The time taken by each stage is profiled and
+ * reported on SIGUSR1. If the frames take longer than budgeted, the
+ * recording, the background learning and the detection are thinned out
+ * step by step; the watchdog resets the camera if the loop gets too slow
+ * nonetheless. The thresholds, the history length and the shutter are
+ * reloaded from SETTINGS_FILE whenever it is written, without a restart.
+ * With -r, recorded frames are replayed from memory instead of captured,
+ * e.g. to load test the detection on the host. With -w, only the watch
+ * windows are read out while idle; motion in them switches to full frames
+ * until the alarm is over. With -t, the stages of the threads are traced
+ * and written to TRACE_FILE on SIGUSR2 and on every intruder. With -m, the
+ * frames with motion are recorded delta coded to the ring file
+ * RING_FILE_NAME instead of to bitmap files. With -e, the shutter width is
+ * controlled from the histogram of the thumbnail, taken in the pass of the
+ * mean. */
 
 #include "oscar/staging/inc/oscar.h"
+#include "framepool.h"
+#include "capture.h"
+#include "debayer.h"
+#include "thumb.h"
+#include "picstat.h"
+#include "autoexp.h"
+#include "detect.h"
+#include "recorder.h"
+#include "prof.h"
+#include "trace.h"
+#include "deadline.h"
+#include "cfgwatch.h"
+#include "replay.h"
+#include "readout.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
 #include <unistd.h>
 
-#define HISTORY_LENGTH 20
 #define IMAGE_WIDTH 752
 #define IMAGE_HEIGHT 480
-#define THRESHOLD 2
+#define BAYER_INPUT 1 /* Pictures are a Bayer mosaic (colour sensor), 0 on a monochrome sensor */
+#define LUMA_HALF 0 /* Analyse luma at half the resolution (colour sensor only) */
+#define PIC_WIDTH (LUMA_HALF ? IMAGE_WIDTH / 2 : IMAGE_WIDTH) /* Size of the analysed pictures */
+#define PIC_HEIGHT (LUMA_HALF ? IMAGE_HEIGHT / 2 : IMAGE_HEIGHT)
+#define THUMB_STEP 4 /* Distance of the pixels and rows of the thumbnail for the mean */
+/* The detection settings are the defaults of detect.h (DETECT_THRESHOLD etc.) */
+#define POOL_FRAMES 2 /* Frame buffers in the frame pool */
+#define CAPTURE_TIMEOUT 500 /* ms to wait for a picture */
+#define STATS_INTERVAL 100 /* Frames between capture statistics */
+#define RECORD_PRE_ROLL 5 /* Frames recorded before an intruder */
+#define RECORD_POST_ROLL 10 /* Frames recorded from an intruder on */
+#define RECORD_SLOTS 24 /* Frames kept in RAM for recordings */
+#define RECORD_PREFIX "../intruder-" /* Recorded file names */
+#define FRAME_BUDGET_US 40000 /* Processing time budgeted per frame */
+#define MIN_FRAME_RATE 2 /* Frames per second below which the watchdog is not kept alive */
+#define OVERRUN_FRAMES 5 /* Frames over budget in a row before degrading */
+#define RECOVER_FRAMES 50 /* Frames well within budget in a row before recovering */
+#define WATCHDOG 1 /* Reset the camera if the loop gets too slow or stalls */
+#define SHUTTER_WIDTH 50000 /* Exposure time in us (*), the first one with -e */
+#define EXPOSURE_TARGET 100 /* Median grey level kept by the auto exposure (-e) */
+#define MIN_SHUTTER_WIDTH 10 /* Range of the auto exposure in us */
+#define MAX_SHUTTER_WIDTH 100000
+#define EXPOSURE_LATENCY 2 /* Frames until a new shutter width takes effect: the one already exposing and the register latency */
+#define SETTINGS_FILE "alarm.txt" /* Overrides the defaults marked with (*) here and in detect.h */
+#define WATCH_WINDOWS { { IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4, IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2 } } /* Windows read out while idle (-w) */
+#define BURST_FRAMES 50 /* Full frames read at least after motion in a watch window */
+#define REFRESH_FRAMES 250 /* Watch frames between full frames, which keep the background current */
+#define WATCH_MOTION_PIXELS(pDetect) ((pDetect)->motionPixels * (IMAGE_WIDTH / PIC_WIDTH) * (IMAGE_HEIGHT / PIC_HEIGHT)) /* Full frame pixels of motion in the windows */
+#define TRACE_FILE "alarm-trace.json" /* Trace of the stages (-t) */
+#define RING_FILE_NAME "../intruder.ring" /* Recording of the frames with motion (-m) */
+#define RING_FILE_SIZE (32UL << 20) /* Bytes of the recording, the oldest frames are overwritten */
+#define RING_KEY_INTERVAL 50 /* Recorded frames between frames stored whole */
+#define RING_THRESHOLD 6 /* Grey level change of a block recorded again */
+
+#if LUMA_HALF && !BAYER_INPUT
+#error "LUMA_HALF requires BAYER_INPUT"
+#endif
 
 /*! @brief Framework module dependencies. */
 struct OSC_DEPENDENCY deps[] = {
@@ -37,30 +111,378 @@ struct OSC_DEPENDENCY deps[] = {
 	{ "bmp", OscBmpCreate, OscBmpDestroy },
 	{ "cam", OscCamCreate, OscCamDestroy },
 	{ "gpio", OscGpioCreate, OscGpioDestroy },
+	{ "dma", OscDmaCreate, OscDmaDestroy },
 };
 
 /*! @brief Global variables. */
 int led = 0;
 
+/*! @brief Settings reloaded from SETTINGS_FILE, see the defines. */
+struct ALARM_SETTINGS {
+	struct DETECT_SETTINGS detect;
+	uint32 shutterWidth;
+};
+
+/*! @brief Tags of the settings in SETTINGS_FILE and their valid ranges. */
+static const struct SETTING_TAG {
+	const char *tag;
+	size_t offset;
+	int32 min, max;
+} settingTags[] = {
+	{ "THRESHOLD", offsetof(struct ALARM_SETTINGS, detect.threshold), 0, 255 },
+	{ "HISTORY_LENGTH", offsetof(struct ALARM_SETTINGS, detect.historyLength), 1, HISTORY_MAX_LENGTH },
+	{ "PIXEL_THRESHOLD", offsetof(struct ALARM_SETTINGS, detect.pixelThreshold), 0, 255 },
+	{ "MOTION_PIXELS", offsetof(struct ALARM_SETTINGS, detect.motionPixels), 1, PIC_WIDTH * PIC_HEIGHT },
+	{ "COOLDOWN_FRAMES", offsetof(struct ALARM_SETTINGS, detect.cooldownFrames), 1, 100000 },
+	{ "SHUTTER_WIDTH", offsetof(struct ALARM_SETTINGS, shutterWidth), 1, 1000000 },
+};
+
+/*! @brief Watcher of SETTINGS_FILE. */
+static struct CFG_WATCH settingsWatch;
+
+/*! @brief Stage profile, reported when bReport is set by SIGUSR1. */
+static struct PROF prof;
+static volatile sig_atomic_t bReport = 0;
+
+/*! @brief Trace of the stages, written by its writer thread when bDump
+ * is set by SIGUSR2. */
+static struct TRACE trace;
+static struct TRACE_RING *pTrace;
+static volatile sig_atomic_t bDump = 0;
+
+/*! @brief Frame deadline monitor. */
+static struct DEADLINE deadline;
+
+/*! @brief Auto exposure (-e), from the histogram of the thumbnail. */
+static struct AUTO_EXP autoExp;
+static int bAutoExposure = FALSE;
+
+/*! @brief Degradable rates: every recordStep-th frame is recorded and
+ * every diffRowStep-th row compared with the background. */
+static uint8 recordStep = 1, diffRowStep = 1;
+
+/*! @brief Timers of the stages. */
+static struct PROF_TIMER *pFrameTimer, *pCaptureTimer, *pLumaTimer, *pThumbTimer;
+static struct PROF_TIMER *pMeanTimer, *pRecordTimer, *pWatchTimer;
+
+/*! @brief Frame buffers of the frame pool (word aligned). */
+static unsigned long frameBuffers[POOL_FRAMES][IMAGE_WIDTH * IMAGE_HEIGHT / sizeof(unsigned long)];
+
+#if BAYER_INPUT
+/*! @brief Luma of the current picture (word aligned). */
+static unsigned long luma[PIC_WIDTH * PIC_HEIGHT / sizeof(unsigned long)];
+#endif
+
+/*! @brief Thumbnail of the current picture for the mean. */
+static uint8 thumbnail[((IMAGE_WIDTH + THUMB_STEP - 1) / THUMB_STEP) * ((IMAGE_HEIGHT + THUMB_STEP - 1) / THUMB_STEP)];
+
+/*! @brief Background model (word aligned). */
+static unsigned long background[PIC_WIDTH * PIC_HEIGHT / sizeof(unsigned long)];
+static unsigned long backgroundFraction[PIC_WIDTH * PIC_HEIGHT / sizeof(unsigned long)];
+
+/*! @brief Frames kept in RAM for recordings. */
+static uint8 recordBuffer[RECORD_SLOTS][PIC_WIDTH * PIC_HEIGHT];
+
+/*********************************************************************//*!
+ * @brief Take the next picture to analyse.
+ * 
+ * The thumbnail is gathered by DMA. On a colour sensor, the raw picture is
+ * converted to luma in a single pass meanwhile, without an intermediate
+ * colour picture, and its frame buffer is released at once. Otherwise the
+ * picture refers to the frame buffer, which the caller releases when done.
+ * 
+ * @param pCapture Capture pipeline.
+ * @param pDebayer Luma conversion of the raw pictures.
+ * @param pThumb Thumbnail of the raw pictures.
+ * @param pic Picture to analyse, its data points to the luma buffer on a
+ * colour sensor.
+ * @param ppFrame Frame to release by the caller, NULL on a colour sensor.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR nextPicture(struct CAPTURE_PIPELINE *pCapture, const struct DEBAYER *pDebayer, struct THUMB *pThumb, struct OSC_PICTURE *pic, struct FRAME **ppFrame)
+{
+	OSC_ERR err;
+	struct FRAME *pFrame;
+
+	uint32 start;
+
+	start = ProfStart();
+	err = CaptureNext(pCapture, &pFrame);
+	ProfStop(pCaptureTimer, start);
+	TRACE_STOP(pTrace, "capture wait", start);
+	if (err != SUCCESS) {
+		return err;
+	}
+	DeadlineBegin(&deadline);
+
+	err = ThumbStart(pThumb, pFrame->pData);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to start thumbnail! (%d)\n", __func__, err);
+		FrameRelease(pFrame);
+		return err;
+	}
+
+#if BAYER_INPUT
+	start = ProfStart();
+	DebayerLuma(pDebayer, pFrame->pData, pic->data);
+	ProfStop(pLumaTimer, start);
+	TRACE_STOP(pTrace, "luma", start);
+#endif
+
+	/* The frame buffer is read until the thumbnail is done */
+	start = ProfStart();
+	err = ThumbSync(pThumb);
+	ProfStop(pThumbTimer, start);
+	TRACE_STOP(pTrace, "thumbnail wait", start);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to gather thumbnail! (%d)\n", __func__, err);
+		FrameRelease(pFrame);
+		return err;
+	}
+
+#if BAYER_INPUT
+	FrameRelease(pFrame);
+	*ppFrame = NULL;
+#else
+	pic->data = pFrame->pData;
+	*ppFrame = pFrame;
+#endif
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Set the area of interest of the current readout mode.
+ * 
+ * The capture pending still has the area of interest of the old mode and
+ * is discarded.
+ * 
+ * @param pCapture Capture pipeline.
+ * @param pReadout Adaptive readout.
+ * @param bReplay TRUE if the frames are replayed, not captured.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR switchReadout(struct CAPTURE_PIPELINE *pCapture, struct READOUT *pReadout, const int bReplay)
+{
+	OSC_ERR err;
+
+	err = CaptureStop(pCapture);
+	if (err == SUCCESS && !bReplay) {
+		err = ReadoutSetArea(pReadout);
+	}
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to switch the readout! (%d)\n", __func__, err);
+	}
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Take a picture of the watch windows and check them for motion.
+ * 
+ * On motion, or to refresh the background, the readout switches to full
+ * frames.
+ * 
+ * @param pCapture Capture pipeline.
+ * @param pReadout Adaptive readout in watch mode.
+ * @param bReplay TRUE if the frames are replayed full frames.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR watchPicture(struct CAPTURE_PIPELINE *pCapture, struct READOUT *pReadout, const int bReplay)
+{
+	OSC_ERR err;
+	struct FRAME *pFrame;
+	uint32 start;
+	int bSwitch;
+
+	start = ProfStart();
+	err = CaptureNext(pCapture, &pFrame);
+	ProfStop(pCaptureTimer, start);
+	TRACE_STOP(pTrace, "capture wait", start);
+	if (err != SUCCESS) {
+		return err;
+	}
+	DeadlineBegin(&deadline);
+
+	start = ProfStart();
+	bSwitch = ReadoutWatch(pReadout, pFrame->pData, bReplay ? &pReadout->full : &pReadout->area);
+	ProfStop(pWatchTimer, start);
+	TRACE_STOP(pTrace, "watch windows", start);
+	FrameRelease(pFrame);
+
+	if (bSwitch) {
+		err = switchReadout(pCapture, pReadout, bReplay);
+	}
+	DeadlineEnd(&deadline);
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Signal handler: request a report of the stage profile.
+ * 
+ * @param sig Signal number.
+ *//*********************************************************************/
+static void requestReport(int sig)
+{
+	bReport = 1;
+}
+
+/*********************************************************************//*!
+ * @brief Signal handler: request the trace to be written.
+ * 
+ * @param sig Signal number.
+ *//*********************************************************************/
+static void requestDump(int sig)
+{
+	bDump = 1;
+}
+
+/*********************************************************************//*!
+ * @brief Set up the profile and the timers of the stages.
+ * 
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR setupProfile(void)
+{
+	OSC_ERR err;
+
+	err = ProfInit(&prof);
+	if (err != SUCCESS) {
+		return err;
+	}
+	pFrameTimer = ProfTimer(&prof, "frame");
+	pCaptureTimer = ProfTimer(&prof, "capture wait");
+	pLumaTimer = ProfTimer(&prof, "luma");
+	pThumbTimer = ProfTimer(&prof, "thumbnail wait");
+	pMeanTimer = ProfTimer(&prof, "mean");
+	pRecordTimer = ProfTimer(&prof, "record copy");
+	pWatchTimer = ProfTimer(&prof, "watch windows");
+
+	signal(SIGUSR1, requestReport);
+
+	/* The trace shares the cycle count of the profile */
+	err = TraceInit(&trace, &prof);
+	if (err != SUCCESS) {
+		return err;
+	}
+	pTrace = TraceRing(&trace, "main");
+	signal(SIGUSR2, requestDump);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Degradation step: halve or restore a rate.
+ * 
+ * @param pArg Step of the rate (uint8), doubled when degrading.
+ * @param bDegrade TRUE to halve the rate, FALSE to restore it.
+ *//*********************************************************************/
+static void halveRate(void *pArg, const int bDegrade)
+{
+	uint8 *pStep = (uint8 *) pArg;
+
+	*pStep = bDegrade ? *pStep * 2 : *pStep / 2;
+}
+
+/*********************************************************************//*!
+ * @brief Set up the deadline monitor and its degradation steps.
+ * 
+ * @param pBgModel Background model, its learning is thinned out.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR setupDeadline(struct BG_MODEL *pBgModel)
+{
+	OSC_ERR err;
+
+	err = DeadlineInit(&deadline, &prof, FRAME_BUDGET_US, 1000000 / MIN_FRAME_RATE, OVERRUN_FRAMES, RECOVER_FRAMES);
+	if (err == SUCCESS) {
+		err = DeadlineAddStep(&deadline, "recording at half rate", halveRate, &recordStep);
+	}
+	if (err == SUCCESS) {
+		err = DeadlineAddStep(&deadline, "background learning at half rate", halveRate, &pBgModel->interleave);
+	}
+	if (err == SUCCESS) {
+		err = DeadlineAddStep(&deadline, "detection on every second row", halveRate, &diffRowStep);
+	}
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Parse and validate the settings (called by the settings watcher).
+ * 
+ * @param pArg Unused.
+ * @param pStore Store of SETTINGS_FILE.
+ * @param pSettings Settings (struct ALARM_SETTINGS) to fill in.
+ * @return SUCCESS or -EINVALID_PARAMETER if a value is invalid
+ *//*********************************************************************/
+static OSC_ERR parseSettings(void *pArg, const struct CFG_STORE *pStore, void *pSettings)
+{
+	const uint32 nTags = sizeof(settingTags) / sizeof(struct SETTING_TAG);
+	struct CFG_STORE_QUERY queries[sizeof(settingTags) / sizeof(struct SETTING_TAG)];
+	int32 values[sizeof(settingTags) / sizeof(struct SETTING_TAG)];
+	uint32 i;
+
+	for (i = 0; i < nTags; i++) {
+		queries[i].strSection = NULL;
+		queries[i].strTag = settingTags[i].tag;
+		queries[i].type = CFG_STORE_INT32;
+		queries[i].pValue = &values[i];
+	}
+	CfgStoreGetBatch(pStore, queries, nTags);
+
+	for (i = 0; i < nTags; i++) {
+		if (queries[i].err == -ECFG_STORE_NO_KEY) {
+			continue;
+		}
+		if (queries[i].err != SUCCESS || values[i] < settingTags[i].min || values[i] > settingTags[i].max) {
+			fprintf(stderr, "%s: ERROR: %s must be a number from %ld to %ld!\n", __func__,
+					settingTags[i].tag, (long) settingTags[i].min, (long) settingTags[i].max);
+			return -EINVALID_PARAMETER;
+		}
+		*(uint32 *) ((uint8 *) pSettings + settingTags[i].offset) = values[i];
+	}
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Take the mean of a picture and, with auto exposure, correct the
+ * shutter width from the histogram taken in the same pass.
+ * 
+ * @param pThumb Thumbnail of the picture.
+ * @return Mean of the thumbnail
+ *//*********************************************************************/
+static uint32 pictureMean(const struct OSC_PICTURE *pThumb)
+{
+	uint32 m;
+
+	if (!bAutoExposure) {
+		return PicStatMean(pThumb);
+	}
+	m = AutoExpMeasure(&autoExp, pThumb, 1, 0, 0);
+	if (AutoExpUpdate(&autoExp)) {
+		OscCamSetShutterWidth(autoExp.shutter);
+	}
+	return m;
+}
+
 /*********************************************************************//*!
- * @brief Calculate mean of picture.
+ * @brief Apply changed settings between frames.
  * 
- * @param pic OSC_PICTURE
- * @return mean of pic
+ * @param pSettings Latest settings.
+ * @param pApplied Settings applied so far, updated.
+ * @param pDet Detection engine.
+ * @param pReadout Adaptive readout, NULL if not used.
  *//*********************************************************************/
-int mean(struct OSC_PICTURE *pic)
+static void applySettings(const struct ALARM_SETTINGS *pSettings, struct ALARM_SETTINGS *pApplied, struct DETECTOR *pDet,
+		struct READOUT *pReadout)
 {
-	uint16 i,j;
-	uint32 sum = 0;
-	uint8 *p;
-	p = (uint8*)pic->data;
-	for(i = 0; i < pic->height; i++){
-		for(j = 0; j < pic->width; j++){
-			sum += p[i*pic->width + j];
+	if (!bAutoExposure && pSettings->shutterWidth != pApplied->shutterWidth) {
+		OscCamSetShutterWidth(pSettings->shutterWidth);
+	}
+	if (memcmp(&pSettings->detect, &pApplied->detect, sizeof(struct DETECT_SETTINGS)) != 0) {
+		DetectorSetSettings(pDet, &pSettings->detect);
+		if (pReadout != NULL) {
+			ReadoutSetThresholds(pReadout, pSettings->detect.pixelThreshold, WATCH_MOTION_PIXELS(&pSettings->detect));
 		}
 	}
-	sum = sum / (pic->width * pic->height);
-	return sum;
+	*pApplied = *pSettings;
 }
 
 /*********************************************************************//*!
@@ -95,14 +517,71 @@ int main(const int argc, const char* argv[])
 {
 	OSC_ERR err = SUCCESS;
 	void* hFramework;
-	uint8 frameBuffer[IMAGE_WIDTH * IMAGE_HEIGHT];
-	struct OSC_PICTURE pic;
-	uint32 m, n = 0, i, bufferIndex = 0;
-	uint32 meanBuffer[HISTORY_LENGTH];
+	struct FRAME_POOL pool;
+	struct FRAME *pFrame;
+	struct CAPTURE_PIPELINE capture;
+	struct DEBAYER debayer;
+	enum EnBayerOrder enBayerOrder;
+	struct THUMB thumb;
+	uint16 thumbX = 0, thumbY = 0;
+	struct OSC_PICTURE pic, thumbPic;
+	struct RECORDER recorder;
+	struct RING_FILE ringFile;
+	struct DETECTOR detector;
+	struct ALARM_SETTINGS defaults;
+	const struct ALARM_SETTINGS *pSettings;
+	struct ALARM_SETTINGS applied;
+	uint32 m, i, events, start, nAnalysed = 0;
+	unsigned long long frameCycles, lastFrameCycles = 0;
+	struct REPLAY replay;
+	struct READOUT readout;
+	const struct READOUT_WINDOW watchWindows[] = WATCH_WINDOWS;
+	int bWatched;
+	const char *opt_replay = NULL;
+	uint32 opt_fps = 0;
+	int opt_watch = FALSE;
+	int opt_trace = FALSE;
+	int opt_ring = FALSE;
+#if defined(OSC_HOST) || defined(OSC_SIM)
+	/* Handle to file name reader for camera images on the host. */
+	void *hFileNameReader;
+#endif
 	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			opt_replay = argv[++i];
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			opt_fps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0) {
+			opt_watch = TRUE;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			opt_trace = TRUE;
+		} else if (strcmp(argv[i], "-m") == 0) {
+			opt_ring = TRUE;
+		} else if (strcmp(argv[i], "-e") == 0) {
+			bAutoExposure = TRUE;
+		} else if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: alarm [ -h ] [ -w ] [ -t ] [ -m ] [ -e ] [ -r <frames> [ -f <fps> ] ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -w: Reads out only the watch windows until they see motion.\n");
+			printf("    -m: Records the frames with motion to %s instead of bitmaps.\n", RING_FILE_NAME);
+			printf("    -e: Controls the shutter width to keep the median grey level at %d.\n", EXPOSURE_TARGET);
+			printf("    -t: Traces the stages, written to %s on SIGUSR2 and on intruders.\n", TRACE_FILE);
+			printf("    -r <frames>: Replays the bitmaps of a directory or list file instead of capturing.\n");
+			printf("    -f <fps>: Replays at this frame rate instead of as fast as possible.\n");
+			return 0;
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
 
-	/* Wait some time */
-	sleep(5);
+#if defined(OSC_TARGET)
+	/* Wait some time (for the camera) */
+	if (opt_replay == NULL) {
+		sleep(5);
+	}
+#endif
 
 	/* Create framework */
 	err = OscCreate(&hFramework);
@@ -132,75 +611,248 @@ int main(const int argc, const char* argv[])
 	OscGpioWrite(GPIO_OUT1, FALSE);
 	OscGpioWrite(GPIO_OUT2, FALSE);
 
+	/* Setup profiling of the stages */
+	err = setupProfile();
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup profile! (%d)\n", __func__, err);
+		return err;
+	}
+
+	/* Read the settings, which are reloaded when the file is written */
+	DetectDefaults(&defaults.detect, PIC_WIDTH, PIC_HEIGHT);
+	defaults.shutterWidth = SHUTTER_WIDTH;
+	err = CfgWatchStart(&settingsWatch, SETTINGS_FILE, &defaults, sizeof(struct ALARM_SETTINGS), parseSettings, NULL);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to read settings! (%d)\n", __func__, err);
+		return err;
+	}
+	pSettings = CfgWatchAcquire(&settingsWatch);
+	applied = *pSettings;
+
 	/* Setup target picture */
-	pic.width = IMAGE_WIDTH;
-	pic.height = IMAGE_HEIGHT;
+	pic.width = PIC_WIDTH;
+	pic.height = PIC_HEIGHT;
 	pic.type = OSC_PICTURE_GREYSCALE;
+#if BAYER_INPUT
+	pic.data = (uint8*)luma;
+#endif
+
+#if defined(OSC_HOST) || defined(OSC_SIM)
+	/* Setup file name reader (for host compiled version); read constant image */
+	OscFrdCreateConstantReader(&hFileNameReader, "imgCapture.bmp");
+	OscCamSetFileNameReader(hFileNameReader);
+#endif
 
 	/* Configure camera */
 	OscCamPresetRegs();
 	OscCamSetAreaOfInterest(0,0,IMAGE_WIDTH,IMAGE_HEIGHT);
-	OscCamSetFrameBuffer(0, IMAGE_WIDTH * IMAGE_HEIGHT, frameBuffer, TRUE);
-	OscCamSetShutterWidth(50000); /* 50 ms shutter */
+	OscCamSetShutterWidth(pSettings->shutterWidth);
+	if (bAutoExposure) {
+		err = AutoExpInit(&autoExp, pSettings->shutterWidth, EXPOSURE_TARGET, MIN_SHUTTER_WIDTH, MAX_SHUTTER_WIDTH, EXPOSURE_LATENCY);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to setup auto exposure! (%d)\n", __func__, err);
+			return err;
+		}
+	}
+
+	/* Setup luma conversion of the Bayer mosaic */
+	OscCamGetBayerOrder(&enBayerOrder, 0, 0);
+	err = DebayerInit(&debayer, IMAGE_WIDTH, IMAGE_HEIGHT, enBayerOrder, LUMA_HALF);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup luma conversion! (%d)\n", __func__, err);
+		return err;
+	}
+
+	/* Setup thumbnail for the mean, of green pixels on a colour sensor */
+#if BAYER_INPUT
+	ThumbGreenOrigin(enBayerOrder, &thumbX, &thumbY);
+#endif
+	err = ThumbInit(&thumb, IMAGE_WIDTH, IMAGE_HEIGHT, THUMB_STEP, thumbX, thumbY, thumbnail);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup thumbnail! (%d)\n", __func__, err);
+		return err;
+	}
+	thumbPic.width = thumb.width;
+	thumbPic.height = thumb.height;
+	thumbPic.type = OSC_PICTURE_GREYSCALE;
+	thumbPic.data = thumbnail;
+
+	/* Setup frame pool for pipelined capturing */
+	err = FramePoolInit(&pool, POOL_FRAMES, IMAGE_WIDTH * IMAGE_HEIGHT, (uint8*)frameBuffers);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup frame pool! (%d)\n", __func__, err);
+		return err;
+	}
+	err = CaptureInit(&capture, &pool, CAPTURE_TIMEOUT);
+	if (err != SUCCESS) {
+		return err;
+	}
+
+	/* Load the frames to replay */
+	if (opt_replay != NULL) {
+		err = ReplayOpen(&replay, opt_replay, opt_fps);
+		if (err == SUCCESS && (replay.width != IMAGE_WIDTH || replay.height != IMAGE_HEIGHT)) {
+			fprintf(stderr, "%s: ERROR: Replayed frames must be %ux%u pixels!\n", __func__, IMAGE_WIDTH, IMAGE_HEIGHT);
+			err = -EINVALID_PARAMETER;
+		}
+		if (err != SUCCESS) {
+			return err;
+		}
+		printf("Replaying %lu frames of %s.\n", replay.nFrames, opt_replay);
+		CaptureSetReplay(&capture, &replay);
+	}
 
-	/* Initialize mean buffer */
-	for (i = 0; i < HISTORY_LENGTH; i++) {
-		err = OscCamSetupCapture(0);
+	/* Setup adaptive readout */
+	if (opt_watch) {
+		err = ReadoutInit(&readout, IMAGE_WIDTH, IMAGE_HEIGHT, watchWindows, sizeof(watchWindows) / sizeof(struct READOUT_WINDOW),
+				pSettings->detect.pixelThreshold, WATCH_MOTION_PIXELS(&pSettings->detect),
+				BURST_FRAMES, REFRESH_FRAMES);
 		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable setup capture! (%d)\n", __func__, err);
-		  return err;
+			fprintf(stderr, "%s: ERROR: Unable to setup adaptive readout! (%d)\n", __func__, err);
+			return err;
+		}
+	}
+
+	/* Setup event recorder */
+	err = RecorderInit(&recorder, PIC_WIDTH, PIC_HEIGHT, (uint8*)recordBuffer, RECORD_SLOTS, RECORD_PRE_ROLL, RECORD_POST_ROLL, RECORD_PREFIX);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup recorder! (%d)\n", __func__, err);
+		return err;
+	}
+	recorder.pWriteTimer = ProfTimer(&prof, opt_ring ? "ring write" : "bmp write");
+	recorder.pWriteTrace = TraceRing(&trace, "recorder");
+	if (opt_ring) {
+		err = RingFileCreate(&ringFile, RING_FILE_NAME, PIC_WIDTH, PIC_HEIGHT, RING_FILE_SIZE, RING_KEY_INTERVAL, RING_THRESHOLD);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to open %s! (%d)\n", __func__, RING_FILE_NAME, err);
+			return err;
 		}
-		err = OscGpioTriggerImage();
+		recorder.pRingFile = &ringFile;
+	}
+
+	/* Setup detection: background model and mean history */
+	err = DetectorInit(&detector, PIC_WIDTH, PIC_HEIGHT, (uint8*)background, (uint8*)backgroundFraction, &pSettings->detect);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup detection! (%d)\n", __func__, err);
+		return err;
+	}
+	detector.pDiffTimer = ProfTimer(&prof, "background diff");
+	detector.pUpdateTimer = ProfTimer(&prof, "background update");
+
+	/* Setup deadline monitor */
+	err = setupDeadline(&detector.bgModel);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup deadline monitor! (%d)\n", __func__, err);
+		return err;
+	}
+
+	/* Initialize mean history and background */
+	for (i = 0; i < pSettings->detect.historyLength; i++) {
+		err = nextPicture(&capture, &debayer, &thumb, &pic, &pFrame);
 		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable to trigger! (%d)\n", __func__, err);
 		  return err;
 		}
-		err = OscCamReadPicture(0, (void *) &pic.data, 0, 0);
+
+		DetectorFrame(&detector, pic.data, pictureMean(&thumbPic), 1);
+
+		if (pFrame != NULL) {
+		  FrameRelease(pFrame);
+		}
+	}
+
+	/* Watch the windows from now on */
+	if (opt_watch) {
+		err = switchReadout(&capture, &readout, opt_replay != NULL);
 		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable read picture! (%d)\n", __func__, err);
 		  return err;
 		}
+	}
+
+	/* Trace the stages from now on, written in the background */
+	if (opt_trace) {
+		err = TraceStartWriter(&trace, TRACE_FILE);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to start trace writer! (%d)\n", __func__, err);
+			return err;
+		}
+	}
+	TraceEnable(&trace, opt_trace);
 
-		meanBuffer[i] = mean(&pic);
+#if WATCHDOG
+	/* From now on the loop keeps the watchdog alive */
+	err = DeadlineStartWatchdog(&deadline);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to start watchdog! (%d)\n", __func__, err);
+		return err;
 	}
+#endif
 
 	/* Start alarm mode */
 	while (1) {
 
+		/* Pick up reloaded settings between frames */
+		pSettings = CfgWatchAcquire(&settingsWatch);
+		applySettings(pSettings, &applied, &detector, opt_watch ? &readout : NULL);
+
 	    /* Indicate active surveillance */
-	    toggle();
+	    if (detector.cooldown == 0) {
+		  toggle();
+	    }
 
-		/* Take a new picture */
-		err = OscCamSetupCapture(0);
-		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable setup capture! (%d)\n", __func__, err);
-		  return err;
+		/* Take a new picture (the next one is exposed meanwhile), of
+		 * the watch windows only while they see no motion */
+		bWatched = opt_watch && readout.mode == READOUT_WATCH;
+		if (bWatched) {
+		  err = watchPicture(&capture, &readout, opt_replay != NULL);
+		} else {
+		  err = nextPicture(&capture, &debayer, &thumb, &pic, &pFrame);
 		}
-		err = OscGpioTriggerImage();
 		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable to trigger! (%d)\n", __func__, err);
 		  return err;
 		}
-		err = OscCamReadPicture(0, (void *) &pic.data, 0, 0);
-		if (err != SUCCESS) {
-		  fprintf(stderr, "%s: ERROR: Unable read picture! (%d)\n", __func__, err);
-		  return err;
+		if (capture.nFrames >= STATS_INTERVAL) {
+		  CapturePrintStats(&capture);
+		  DeadlinePrintStats(&deadline);
+		  if (opt_watch) {
+			ReadoutPrintStats(&readout);
+		  }
 		}
-		
-		/* Calculate mean of new picture */
-		m = mean(&pic);
-		
-		/* Calculate mean of history */
-		for (i = 0; i < HISTORY_LENGTH; i++) {
-			n += meanBuffer[i];
+
+		/* Time from frame to frame, which also keeps the 64 bit cycle count going */
+		frameCycles = ProfCycles(&prof);
+		if (lastFrameCycles != 0) {
+			ProfRecord(pFrameTimer, frameCycles - lastFrameCycles < 0xFFFFFFFFULL ? (uint32) (frameCycles - lastFrameCycles) : 0xFFFFFFFFUL);
+		}
+		lastFrameCycles = frameCycles;
+		if (bReport) {
+			bReport = 0;
+			ProfReport(&prof, stdout);
+		}
+		if (bDump) {
+			bDump = 0;
+			TraceRequestDump(&trace);
+		}
+		if (bWatched) {
+			continue;
 		}
-		n = n / HISTORY_LENGTH;
 		
-		/* Check if in range and therefore detect intruder */
-		if (m > (n + THRESHOLD) || m <= (n - THRESHOLD)) {
+		/* Calculate mean of new picture (and correct the exposure) */
+		start = ProfStart();
+		m = pictureMean(&thumbPic);
+		ProfStop(pMeanTimer, start);
+		TRACE_STOP(pTrace, "mean", start);
+
+		/* Compare with the background and the mean history */
+		start = ProfStart();
+		events = DetectorFrame(&detector, pic.data, m, diffRowStep);
+		TRACE_STOP(pTrace, "detection", start);
 
+		/* A new intruder, not one still moving during the cooldown */
+		if (events & DETECT_INTRUDER) {
 			/* Indicate detected intruder with LED */
+			start = ProfStart();
 			err = OscGpioWrite(GPIO_OUT2, TRUE);
+			TRACE_STOP(pTrace, "alarm output", start);
 			if (err != SUCCESS) {
 			  fprintf(stderr, "%s: ERROR: GPIO write error! (%d)\n", __func__, err);
 			  return err;
@@ -212,56 +864,72 @@ int main(const int argc, const char* argv[])
 			}
 			led = 0;
 
-			/* Write a picture of the intruder to a file */
-			OscBmpWrite(&pic, "../intruder.bmp");
+			/* Record the pictures before and after the intruder */
+			RecorderTrigger(&recorder);
+			printf("Intruder detected (%lu pixels)!\n", detector.changed);
+			bDump = trace.bEnabled;
+		}
+
+		/* Record the ring file as long as there is motion */
+		if (opt_ring && (events & DETECT_MOTION)) {
+			RecorderTrigger(&recorder);
+		}
 
-			/* Take further actions (we just wait for some time and restart) */
-			/* ------------------------------------------------------------- */
-			sleep(2);
+		/* Keep the picture for recordings (written in the background) */
+		if (nAnalysed++ % recordStep == 0) {
+			start = ProfStart();
+			RecorderAddFrame(&recorder, pic.data);
+			ProfStop(pRecordTimer, start);
+			TRACE_STOP(pTrace, "record copy", start);
+		}
 
+		if (events & DETECT_ALARM_END) {
 			/* Signal alarm end with LED */
 			err = OscGpioWrite(GPIO_OUT2, FALSE);
 			if (err != SUCCESS) {
 			  fprintf(stderr, "%s: ERROR: GPIO write error! (%d)\n", __func__, err);
 			  return err;
 			}
+		}
 
-			/* Re-Initialize mean buffer */
-			for (i = 0; i < HISTORY_LENGTH; i++) {
-			  err = OscCamSetupCapture(0);
-			  if (err != SUCCESS) {
-				fprintf(stderr, "%s: ERROR: Unable setup capture! (%d)\n", __func__, err);
-				return err;
-			  }
-			  err = OscGpioTriggerImage();
-			  if (err != SUCCESS) {
-				fprintf(stderr, "%s: ERROR: Unable to trigger! (%d)\n", __func__, err);
-				return err;
-			  }
-			  err = OscCamReadPicture(0, (void *) &pic.data, 0, 0);
-			  if (err != SUCCESS) {
-				fprintf(stderr, "%s: ERROR: Unable read picture! (%d)\n", __func__, err);
-				return err;
-			  }
-			  
-			  meanBuffer[i] = mean(&pic);
-			}
-
-			/* Reset buffer index */
-			bufferIndex = 0;
-		}else{
-		    /* Add new mean to meanBuffer */
-		    meanBuffer[bufferIndex++] = m;
-		  
-			/* Update buffer index */
-			bufferIndex = bufferIndex % HISTORY_LENGTH;
+		/* Hand the frame buffer back to the pool */
+		if (pFrame != NULL) {
+			FrameRelease(pFrame);
 		}
 
-		/* Reset mean history */
-		n = 0;
+		/* Back to the watch windows once the burst and the alarm are over */
+		if (opt_watch && ReadoutFull(&readout, detector.cooldown > 0)) {
+			err = switchReadout(&capture, &readout, opt_replay != NULL);
+			if (err != SUCCESS) {
+			  return err;
+			}
+		}
+		DeadlineEnd(&deadline);
 	}
 	
 
+	/* Write pending recordings */
+	RecorderDestroy(&recorder);
+	if (opt_ring) {
+		RingFileClose(&ringFile);
+	}
+
+	/* Release the frame buffers */
+	CaptureStop(&capture);
+	FramePoolDestroy(&pool);
+	if (opt_replay != NULL) {
+		ReplayClose(&replay);
+	}
+	if (opt_watch) {
+		ReadoutDestroy(&readout);
+	}
+
+	DeadlineDestroy(&deadline);
+	CfgWatchStop(&settingsWatch);
+	ProfReport(&prof, stdout);
+	TraceDestroy(&trace);
+	ProfDestroy(&prof);
+
 	/* Destroy modules */
 	OscUnloadDependencies(hFramework, deps, sizeof(deps)/sizeof(struct OSC_DEPENDENCY));
 	
@@ -0,0 +1,697 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file analyze.c
+ * @brief Offline intruder analysis of recorded frames.
+ * Runs the detection engine of alarm.c over a directory or list of
+ * recorded frames, as bitmaps or raw files, and prints the intruders,
+ * lighting changes and alarm ends found. The frames are split into chunks
+ * of consecutive frames, which a pool of threads analyses in parallel;
+ * each thread takes the next chunk not yet analysed until none is left.
+ * The engine of a chunk first runs over the frames before the chunk (the
+ * overlap) without reporting, so that it starts the chunk with a learned
+ * background and history. The events are printed in frame order.
+ * The overlap only approximates the state the engine would have reached
+ * running over all frames before the chunk, so events near the start of
+ * a chunk may differ from a sequential run. With -v the frames are also
+ * run sequentially by one engine and the differences are printed.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "detect.h"
+#include "debayer.h"
+#include "thumb.h"
+#include "picstat.h"
+#include "bmpmap.h"
+#include "framelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+/* Size of raw frames */
+#define RAW_WIDTH 752
+#define RAW_HEIGHT 480
+/* Distance of the pixels and rows averaged for the mean, as the thumbnail
+ * of alarm.c */
+#define THUMB_STEP 4
+/* Default frames per chunk and frames run before a chunk */
+#define CHUNK_FRAMES 500
+#define OVERLAP_FRAMES 200
+/* Maximum number of threads */
+#define MAX_THREADS 64
+
+/*! @brief Reported events of a frame. */
+struct ANALYZE_EVENT {
+	/*! @brief Frame number. */
+	uint32 frame;
+	/*! @brief Events (EnDetectEvents). */
+	uint32 events;
+	/*! @brief Moving pixels. */
+	uint32 changed;
+};
+
+/*! @brief A chunk of consecutive frames. */
+struct ANALYZE_CHUNK {
+	/*! @brief First frame and first frame after the chunk. */
+	uint32 first, end;
+	/*! @brief Reported events of the chunk, in frame order. */
+	struct ANALYZE_EVENT *pEvents;
+	uint32 nEvents, maxEvents;
+	/*! @brief Frames with motion. */
+	uint32 nMotion;
+	/*! @brief Result of the analysis. */
+	OSC_ERR err;
+};
+
+/*! @brief Work shared by the threads. */
+struct ANALYZE_JOB {
+	/*! @brief Frame files. */
+	const struct FRAME_LIST *pList;
+	/*! @brief Frame size. */
+	uint16 width, height;
+	/*! @brief TRUE if the frames are a Bayer mosaic, and its order. */
+	int bBayer;
+	enum EnBayerOrder enBayerOrder;
+	/*! @brief Frames run before a chunk without reporting. */
+	uint32 overlap;
+	/*! @brief Detection settings. */
+	struct DETECT_SETTINGS settings;
+	/*! @brief Chunks. */
+	struct ANALYZE_CHUNK *pChunks;
+	uint32 nChunks;
+	/*! @brief Next chunk to analyse, protected by the lock. */
+	uint32 iNext;
+	pthread_mutex_t lock;
+};
+
+/*! @brief A thread of the pool and its buffers. */
+struct ANALYZE_WORKER {
+	struct ANALYZE_JOB *pJob;
+	pthread_t thread;
+	/*! @brief Frame as loaded and as analysed (the same on greyscale input). */
+	uint8 *pFrame, *pLuma;
+	/*! @brief Background model buffers. */
+	uint8 *pBackground, *pFraction;
+	/*! @brief Luma conversion of Bayer input. */
+	struct DEBAYER debayer;
+	/*! @brief Detection engine. */
+	struct DETECTOR detector;
+	/*! @brief Frames run, including the overlaps. */
+	uint32 nFrames;
+};
+
+/*********************************************************************//*!
+ * @brief Load a frame.
+ *
+ * @param pJob Job.
+ * @param fileName Bitmap or raw file.
+ * @param pFrame Buffer of width * height bytes.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR loadFrame(const struct ANALYZE_JOB *pJob, const char *fileName, uint8 *pFrame)
+{
+	const uint32 size = (uint32) pJob->width * pJob->height;
+	struct BMP_MAP map;
+	ssize_t n;
+	uint32 done = 0;
+	uint16 y;
+	int fd;
+	OSC_ERR err;
+
+	if (FrameListIsRaw(fileName)) {
+		fd = open(fileName, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "%s: ERROR: Unable to open %s!\n", __func__, fileName);
+			return -EUNABLE_TO_OPEN_FILE;
+		}
+		while (done < size && (n = read(fd, pFrame + done, size - done)) > 0)
+			done += n;
+		close(fd);
+		if (done < size) {
+			fprintf(stderr, "%s: ERROR: %s has less than %ux%u pixels!\n", __func__,
+					fileName, pJob->width, pJob->height);
+			return -EINVALID_PARAMETER;
+		}
+		return SUCCESS;
+	}
+
+	err = BmpMapOpen(&map, fileName);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to open %s! (%d)\n", __func__, fileName, err);
+		return err;
+	}
+	if (map.pic.type != OSC_PICTURE_GREYSCALE || map.pic.width != pJob->width || map.pic.height != pJob->height) {
+		fprintf(stderr, "%s: ERROR: %s is no 8 bit bitmap of %ux%u pixels!\n", __func__,
+				fileName, pJob->width, pJob->height);
+		BmpMapClose(&map);
+		return -EINVALID_PARAMETER;
+	}
+	for (y = 0; y < pJob->height; y++)
+		memcpy(pFrame + (uint32) y * pJob->width, BmpMapRow(&map, y), pJob->width);
+	BmpMapClose(&map);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Add an event to a chunk.
+ *
+ * @param pChunk Chunk.
+ * @param frame Frame number.
+ * @param events Events of the frame.
+ * @param changed Moving pixels of the frame.
+ * @return SUCCESS or -EOUT_OF_MEMORY
+ *//*********************************************************************/
+static OSC_ERR addEvent(struct ANALYZE_CHUNK *pChunk,
+		const uint32 frame,
+		const uint32 events,
+		const uint32 changed)
+{
+	struct ANALYZE_EVENT *pGrown;
+
+	if (pChunk->nEvents == pChunk->maxEvents) {
+		pGrown = realloc(pChunk->pEvents, (2 * pChunk->maxEvents + 16) * sizeof(struct ANALYZE_EVENT));
+		if (pGrown == NULL)
+			return -EOUT_OF_MEMORY;
+		pChunk->pEvents = pGrown;
+		pChunk->maxEvents = 2 * pChunk->maxEvents + 16;
+	}
+
+	pChunk->pEvents[pChunk->nEvents].frame = frame;
+	pChunk->pEvents[pChunk->nEvents].events = events;
+	pChunk->pEvents[pChunk->nEvents++].changed = changed;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Analyse a chunk, starting with its overlap.
+ *
+ * @param pWorker Thread.
+ * @param pChunk Chunk.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR analyzeChunk(struct ANALYZE_WORKER *pWorker, struct ANALYZE_CHUNK *pChunk)
+{
+	const struct ANALYZE_JOB *pJob = pWorker->pJob;
+	const uint32 reported = DETECT_LIGHTING | DETECT_INTRUDER | DETECT_ALARM_END;
+	struct OSC_PICTURE frame;
+	uint32 i, events, mean;
+	uint16 x0 = 0, y0 = 0;
+	OSC_ERR err;
+
+	err = DetectorInit(&pWorker->detector, pJob->width, pJob->height,
+			pWorker->pBackground, pWorker->pFraction, &pJob->settings);
+	if (err != SUCCESS)
+		return err;
+
+	/* The mean of alarm.c: of green pixels on a Bayer mosaic */
+	if (pJob->bBayer)
+		ThumbGreenOrigin(pJob->enBayerOrder, &x0, &y0);
+	frame.width = pJob->width;
+	frame.height = pJob->height;
+	frame.type = OSC_PICTURE_GREYSCALE;
+	frame.data = pWorker->pFrame;
+
+	for (i = pChunk->first > pJob->overlap ? pChunk->first - pJob->overlap : 0; i < pChunk->end; i++) {
+		err = loadFrame(pJob, pJob->pList->ppNames[i], pWorker->pFrame);
+		if (err != SUCCESS)
+			return err;
+
+		mean = PicStatMeanSampled(&frame, THUMB_STEP, x0, y0);
+		if (pJob->bBayer)
+			DebayerLuma(&pWorker->debayer, pWorker->pFrame, pWorker->pLuma);
+		events = DetectorFrame(&pWorker->detector, pWorker->pLuma, mean, 1);
+		pWorker->nFrames++;
+
+		if (i < pChunk->first)
+			continue;
+		if (events & DETECT_MOTION)
+			pChunk->nMotion++;
+		if (events & reported) {
+			err = addEvent(pChunk, i, events, pWorker->detector.changed);
+			if (err != SUCCESS)
+				return err;
+		}
+	}
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Thread of the pool: analyse chunks until none is left.
+ *
+ * @param pArg Worker.
+ * @return NULL
+ *//*********************************************************************/
+static void * workerThread(void *pArg)
+{
+	struct ANALYZE_WORKER *pWorker = (struct ANALYZE_WORKER *) pArg;
+	struct ANALYZE_JOB *pJob = pWorker->pJob;
+	uint32 iChunk;
+
+	for (;;) {
+		pthread_mutex_lock(&pJob->lock);
+		iChunk = pJob->iNext;
+		if (iChunk < pJob->nChunks)
+			pJob->iNext++;
+		pthread_mutex_unlock(&pJob->lock);
+		if (iChunk >= pJob->nChunks)
+			break;
+
+		pJob->pChunks[iChunk].err = analyzeChunk(pWorker, &pJob->pChunks[iChunk]);
+	}
+
+	return NULL;
+}
+
+/*********************************************************************//*!
+ * @brief Allocate the buffers of a thread.
+ *
+ * @param pWorker Worker to set up.
+ * @param pJob Job.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR setupWorker(struct ANALYZE_WORKER *pWorker, struct ANALYZE_JOB *pJob)
+{
+	const uint32 size = (uint32) pJob->width * pJob->height;
+
+	memset(pWorker, 0, sizeof(struct ANALYZE_WORKER));
+	pWorker->pJob = pJob;
+	pWorker->pFrame = malloc(size);
+	pWorker->pLuma = pJob->bBayer ? malloc(size) : pWorker->pFrame;
+	pWorker->pBackground = malloc(size);
+	pWorker->pFraction = malloc(size);
+	if (pWorker->pFrame == NULL || pWorker->pLuma == NULL || pWorker->pBackground == NULL || pWorker->pFraction == NULL)
+		return -EOUT_OF_MEMORY;
+
+	if (pJob->bBayer)
+		return DebayerInit(&pWorker->debayer, pJob->width, pJob->height, pJob->enBayerOrder, FALSE);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Free the buffers of a thread.
+ *
+ * @param pWorker Worker.
+ *//*********************************************************************/
+static void destroyWorker(struct ANALYZE_WORKER *pWorker)
+{
+	if (pWorker->pLuma != pWorker->pFrame)
+		free(pWorker->pLuma);
+	free(pWorker->pFrame);
+	free(pWorker->pBackground);
+	free(pWorker->pFraction);
+}
+
+/*********************************************************************//*!
+ * @brief Get the size of the frames from the first frame.
+ *
+ * @param pJob Job whose size to set.
+ * @param opt_width Width of raw frames.
+ * @param opt_height Height of raw frames.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR frameSize(struct ANALYZE_JOB *pJob, const uint16 opt_width, const uint16 opt_height)
+{
+	struct BMP_MAP map;
+	OSC_ERR err;
+
+	if (FrameListIsRaw(pJob->pList->ppNames[0])) {
+		pJob->width = opt_width;
+		pJob->height = opt_height;
+		return SUCCESS;
+	}
+
+	err = BmpMapOpen(&map, pJob->pList->ppNames[0]);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to open %s! (%d)\n", __func__, pJob->pList->ppNames[0], err);
+		return err;
+	}
+	pJob->width = map.pic.width;
+	pJob->height = map.pic.height;
+	BmpMapClose(&map);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Parse the order of a Bayer mosaic.
+ *
+ * @param str Order of the first row: BGBG, GBGB, RGRG or GRGR.
+ * @param pOrder Order to set.
+ * @return SUCCESS or -EINVALID_PARAMETER
+ *//*********************************************************************/
+static OSC_ERR parseBayerOrder(const char *str, enum EnBayerOrder *pOrder)
+{
+	static const char *names[] = { "BGBG", "GBGB", "RGRG", "GRGR" };
+	static const enum EnBayerOrder orders[] = { ROW_BGBG, ROW_GBGB, ROW_RGRG, ROW_GRGR };
+	uint32 i;
+
+	for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+		if (strcmp(str, names[i]) == 0) {
+			*pOrder = orders[i];
+			return SUCCESS;
+		}
+	}
+	return -EINVALID_PARAMETER;
+}
+
+/*********************************************************************//*!
+ * @brief Analyse the chunks of a job with a pool of threads.
+ *
+ * @param pJob Job with its chunks set up.
+ * @param nThreads Threads of the pool.
+ * @param pFrames Frames run by all threads, including the overlaps.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR runPool(struct ANALYZE_JOB *pJob, const uint32 nThreads, uint32 *pFrames)
+{
+	static struct ANALYZE_WORKER workers[MAX_THREADS];
+	uint32 i, nStarted = 0;
+	OSC_ERR err = SUCCESS;
+
+	for (i = 0; i < nThreads; i++) {
+		err = setupWorker(&workers[i], pJob);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to setup thread %lu! (%d)\n", __func__, (unsigned long) i, err);
+			destroyWorker(&workers[i]);
+			break;
+		}
+		if (pthread_create(&workers[i].thread, NULL, workerThread, &workers[i]) != 0) {
+			fprintf(stderr, "%s: ERROR: Unable to start thread %lu!\n", __func__, (unsigned long) i);
+			destroyWorker(&workers[i]);
+			err = -EDEVICE;
+			break;
+		}
+		nStarted++;
+	}
+
+	/* The threads started take over the chunks of the others. */
+	*pFrames = 0;
+	for (i = 0; i < nStarted; i++) {
+		pthread_join(workers[i].thread, NULL);
+		*pFrames += workers[i].nFrames;
+		destroyWorker(&workers[i]);
+	}
+
+	return nStarted > 0 ? SUCCESS : err;
+}
+
+/*********************************************************************//*!
+ * @brief Describe the reported events of a frame.
+ *
+ * @param events Events (EnDetectEvents), 0 for none.
+ * @param text Buffer of 48 characters.
+ * @return The description
+ *//*********************************************************************/
+static const char * describeEvents(const uint32 events, char *text)
+{
+	text[0] = '\0';
+	if (events & DETECT_LIGHTING)
+		strcat(text, " lighting change");
+	if (events & DETECT_INTRUDER)
+		strcat(text, " intruder");
+	if (events & DETECT_ALARM_END)
+		strcat(text, " alarm end");
+	return text[0] != '\0' ? text + 1 : "nothing";
+}
+
+/*********************************************************************//*!
+ * @brief Print where the events of the chunks differ from those of a
+ * sequential run.
+ *
+ * @param pJob Job analysed in chunks.
+ * @param pSequential Events of all frames analysed as one chunk.
+ * @return Number of frames whose events differ
+ *//*********************************************************************/
+static uint32 compareEvents(const struct ANALYZE_JOB *pJob, const struct ANALYZE_CHUNK *pSequential)
+{
+	const uint32 reported = DETECT_LIGHTING | DETECT_INTRUDER | DETECT_ALARM_END;
+	const struct ANALYZE_EVENT *pChunked, *pSeq;
+	uint32 i = 0, j = 0, k = 0, frame, chunked, seq, nDiffs = 0;
+	char chunkedText[48], seqText[48];
+
+	/* Walk both lists of events in frame order */
+	while (1) {
+		while (i < pJob->nChunks && k >= pJob->pChunks[i].nEvents) {
+			i++;
+			k = 0;
+		}
+		pChunked = i < pJob->nChunks ? &pJob->pChunks[i].pEvents[k] : NULL;
+		pSeq = j < pSequential->nEvents ? &pSequential->pEvents[j] : NULL;
+		if (pChunked == NULL && pSeq == NULL)
+			break;
+
+		chunked = seq = 0;
+		if (pSeq == NULL || (pChunked != NULL && pChunked->frame <= pSeq->frame)) {
+			frame = pChunked->frame;
+			chunked = pChunked->events & reported;
+			k++;
+		} else {
+			frame = pSeq->frame;
+		}
+		if (pSeq != NULL && pSeq->frame == frame) {
+			seq = pSeq->events & reported;
+			j++;
+		}
+
+		if (chunked != seq) {
+			printf("%s: %s in chunks, %s sequentially\n", pJob->pList->ppNames[frame],
+					describeEvents(chunked, chunkedText), describeEvents(seq, seqText));
+			nDiffs++;
+		}
+	}
+
+	return nDiffs;
+}
+
+/*********************************************************************//*!
+ * @brief Print the events of the chunks in frame order.
+ *
+ * @param pJob Job analysed.
+ * @return SUCCESS or the error of the first chunk that failed
+ *//*********************************************************************/
+static OSC_ERR printEvents(const struct ANALYZE_JOB *pJob)
+{
+	const struct ANALYZE_EVENT *pEvent;
+	const char *name;
+	uint32 i, j, nMotion = 0, nIntruders = 0;
+
+	for (i = 0; i < pJob->nChunks; i++) {
+		if (pJob->pChunks[i].err != SUCCESS)
+			return pJob->pChunks[i].err;
+
+		nMotion += pJob->pChunks[i].nMotion;
+		for (j = 0; j < pJob->pChunks[i].nEvents; j++) {
+			pEvent = &pJob->pChunks[i].pEvents[j];
+			name = pJob->pList->ppNames[pEvent->frame];
+			if (pEvent->events & DETECT_LIGHTING)
+				printf("%s: lighting change, background learned again\n", name);
+			if (pEvent->events & DETECT_INTRUDER) {
+				printf("%s: intruder (%lu pixels changed)\n", name, (unsigned long) pEvent->changed);
+				nIntruders++;
+			}
+			if (pEvent->events & DETECT_ALARM_END)
+				printf("%s: alarm end\n", name);
+		}
+	}
+
+	printf("%lu intruders, %lu frames with motion.\n", (unsigned long) nIntruders, (unsigned long) nMotion);
+	return SUCCESS;
+}
+
+int main(const int argc, const char * argv[])
+{
+	void *hFramework;
+	struct ANALYZE_JOB job, sequential;
+	struct ANALYZE_CHUNK all;
+	struct FRAME_LIST list;
+	uint32 i, nThreads, nFrames = 0, nDiffs = 0;
+	struct timeval start, end;
+	unsigned long long us;
+	long nCpus;
+	OSC_ERR err;
+	
+	uint32 opt_threads = 0, opt_chunk = CHUNK_FRAMES, opt_overlap = OVERLAP_FRAMES;
+	uint16 opt_width = RAW_WIDTH, opt_height = RAW_HEIGHT;
+	const char *opt_bayer = NULL, *opt_path = NULL;
+	int opt_verify = FALSE;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: analyze [ -h ] [ -j <n> ] [ -c <n> ] [ -o <n> ] [ -v ] [ -s <w>x<h> ] [ -b <order> ] <frames>\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -j <n>: Threads (default one per processor).\n");
+			printf("    -c <n>: Frames per chunk (default %d).\n", CHUNK_FRAMES);
+			printf("    -o <n>: Frames run before a chunk (default %d, at least %d). They approximate the\n", OVERLAP_FRAMES, DETECT_HISTORY_LENGTH);
+			printf("            frames before, so the events may differ near the start of a chunk.\n");
+			printf("    -v: Also runs all frames sequentially and prints where the events differ (exit code 2).\n");
+			printf("    -s <w>x<h>: Size of raw frames (default %dx%d).\n", RAW_WIDTH, RAW_HEIGHT);
+			printf("    -b <order>: Frames are a Bayer mosaic starting with BGBG, GBGB, RGRG or GRGR.\n");
+			printf("    <frames>: Directory or list of .bmp and .raw files, in time order.\n");
+			return 0;
+		} else if (strcmp(argv[i], "-v") == 0) {
+			opt_verify = TRUE;
+		} else if (argv[i][0] == '-' && strchr("jcosb", argv[i][1]) != NULL && argv[i][2] == '\0') {
+			if (i + 1 >= argc) {
+				printf("Error: %s needs an argument.\n", argv[i]);
+				return 1;
+			}
+			switch (argv[i][1]) {
+			case 'j':
+				opt_threads = atoi(argv[i + 1]);
+				break;
+			case 'c':
+				opt_chunk = atoi(argv[i + 1]);
+				break;
+			case 'o':
+				opt_overlap = atoi(argv[i + 1]);
+				break;
+			case 's':
+				if (sscanf(argv[i + 1], "%hux%hu", &opt_width, &opt_height) != 2) {
+					printf("Error: Invalid size: %s\n", argv[i + 1]);
+					return 1;
+				}
+				break;
+			default:
+				opt_bayer = argv[i + 1];
+				break;
+			}
+			i++;
+		} else if (argv[i][0] != '-' && opt_path == NULL) {
+			opt_path = argv[i];
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (opt_path == NULL) {
+		printf("Error: No frames given.\n");
+		return 1;
+	}
+	if (opt_chunk == 0 || opt_overlap < DETECT_HISTORY_LENGTH || opt_width == 0 || opt_height == 0) {
+		printf("Error: Chunks must not be empty, the overlap must be at least %d frames.\n", DETECT_HISTORY_LENGTH);
+		return 1;
+	}
+	
+	memset(&job, 0, sizeof(struct ANALYZE_JOB));
+	if (opt_bayer != NULL) {
+		if (parseBayerOrder(opt_bayer, &job.enBayerOrder) != SUCCESS) {
+			printf("Error: Invalid Bayer order: %s\n", opt_bayer);
+			return 1;
+		}
+		job.bBayer = TRUE;
+	}
+	nThreads = opt_threads;
+	if (nThreads == 0) {
+		nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nThreads = nCpus > 0 ? nCpus : 1;
+	}
+	if (nThreads > MAX_THREADS)
+		nThreads = MAX_THREADS;
+	
+	/* Create framework */
+	OscCreate(&hFramework);
+	
+	/* Load modules */
+	OscSupCreate(hFramework);
+	
+	err = FrameListLoad(&list, opt_path);
+	if (err == SUCCESS) {
+		job.pList = &list;
+		err = frameSize(&job, opt_width, opt_height);
+	}
+	
+	/* Split the frames into chunks */
+	if (err == SUCCESS) {
+		job.nChunks = (list.nNames + opt_chunk - 1) / opt_chunk;
+		job.pChunks = calloc(job.nChunks, sizeof(struct ANALYZE_CHUNK));
+		if (job.pChunks == NULL)
+			err = -EOUT_OF_MEMORY;
+	}
+	
+	if (err == SUCCESS) {
+		for (i = 0; i < job.nChunks; i++) {
+			job.pChunks[i].first = i * opt_chunk;
+			job.pChunks[i].end = i + 1 < job.nChunks ? (i + 1) * opt_chunk : list.nNames;
+		}
+		if (nThreads > job.nChunks)
+			nThreads = job.nChunks;
+		
+		job.overlap = opt_overlap;
+		DetectDefaults(&job.settings, job.width, job.height);
+		pthread_mutex_init(&job.lock, NULL);
+		
+		printf("Analysing %lu frames of %ux%u pixels in %lu chunks with %lu threads ...\n",
+				(unsigned long) list.nNames, job.width, job.height,
+				(unsigned long) job.nChunks, (unsigned long) nThreads);
+		
+		/* Timed by the clock, the 32 bit cycle count wraps within seconds */
+		gettimeofday(&start, NULL);
+		err = runPool(&job, nThreads, &nFrames);
+		gettimeofday(&end, NULL);
+		us = (unsigned long long) (end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec;
+		
+		if (err == SUCCESS)
+			err = printEvents(&job);
+		if (err == SUCCESS) {
+			printf("%lu frames (%lu run with the overlaps) in %lu ms, %lu frames/s.\n",
+					(unsigned long) list.nNames, (unsigned long) nFrames, (unsigned long) (us / 1000),
+					(unsigned long) (us > 0 ? (unsigned long long) list.nNames * 1000000 / us : 0));
+		}
+		
+		/* Check the chunks against one engine running over all frames */
+		if (err == SUCCESS && opt_verify) {
+			sequential = job;
+			memset(&all, 0, sizeof(struct ANALYZE_CHUNK));
+			all.end = list.nNames;
+			sequential.pChunks = &all;
+			sequential.nChunks = 1;
+			sequential.iNext = 0;
+			sequential.overlap = 0;
+			pthread_mutex_init(&sequential.lock, NULL);
+			err = runPool(&sequential, 1, &nFrames);
+			if (err == SUCCESS)
+				err = all.err;
+			if (err == SUCCESS) {
+				nDiffs = compareEvents(&job, &all);
+				printf("%lu frames with other events than in a sequential run.\n", (unsigned long) nDiffs);
+			}
+			pthread_mutex_destroy(&sequential.lock);
+			free(all.pEvents);
+		}
+		
+		pthread_mutex_destroy(&job.lock);
+		for (i = 0; i < job.nChunks; i++)
+			free(job.pChunks[i].pEvents);
+		free(job.pChunks);
+	}
+	FrameListFree(&list);
+	
+	/* Unload modules */
+	OscSupDestroy(hFramework);
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	if (err != SUCCESS)
+		return 1;
+	return nDiffs > 0 ? 2 : 0;
+}
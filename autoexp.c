@@ -0,0 +1,148 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file autoexp.c
+ * @brief Auto exposure from a histogram of the picture.
+ * The shutter width requested at each update is kept for latency + 1
+ * updates: the picture measured now was exposed with the one requested
+ * that many updates ago. Only pictures exposed with the shutter width
+ * requested last are used to predict a new one. The first latency
+ * pictures were exposed with whatever the sensor was left with, so they
+ * are marked as exposed with 0 and not used.
+ */
+
+#include "autoexp.h"
+#include <string.h>
+
+OSC_ERR AutoExpInit(struct AUTO_EXP *pExp,
+		const uint32 shutter,
+		const uint8 target,
+		const uint32 minShutter,
+		const uint32 maxShutter,
+		const uint8 latency)
+{
+	uint8 i;
+
+	if (target == 0 || target >= AUTO_EXP_SATURATED || shutter == 0 || minShutter == 0 ||
+			minShutter > maxShutter || latency > AUTO_EXP_MAX_LATENCY) {
+		return -EINVALID_PARAMETER;
+	}
+
+	memset(pExp, 0, sizeof(struct AUTO_EXP));
+	pExp->target = target;
+	pExp->tolerance = target / 8 > 0 ? target / 8 : 1;
+	pExp->minShutter = minShutter;
+	pExp->maxShutter = maxShutter;
+	pExp->shutter = shutter;
+	pExp->latency = latency;
+	for (i = 0; i < latency; i++)
+		pExp->requested[i] = 0;
+	pExp->requested[latency] = shutter;
+	return SUCCESS;
+}
+
+uint32 AutoExpMeasure(struct AUTO_EXP *pExp,
+		const struct OSC_PICTURE *pic,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0)
+{
+	uint32 *pHistogram = pExp->histogram;
+	uint32 sum = 0, n = 0;
+	const uint8 *pRow;
+	uint16 x, y;
+
+	memset(pHistogram, 0, sizeof(pExp->histogram));
+	for (y = y0; y < pic->height; y += step) {
+		pRow = (const uint8 *) pic->data + (uint32) y * pic->width;
+		for (x = x0; x < pic->width; x += step) {
+			sum += pRow[x];
+			pHistogram[pRow[x]]++;
+		}
+		n += (pic->width - x0 + step - 1) / step;
+	}
+	pExp->nPixels = n;
+	return n > 0 ? sum / n : 0;
+}
+
+/*********************************************************************//*!
+ * @brief Get the median of the histogram.
+ *
+ * @param pExp Controller with a measured picture.
+ * @return Median grey level
+ *//*********************************************************************/
+static uint8 median(const struct AUTO_EXP *pExp)
+{
+	uint32 count = 0;
+	uint16 value;
+
+	for (value = 0; value < 255; value++) {
+		count += pExp->histogram[value];
+		if (2 * count >= pExp->nPixels)
+			break;
+	}
+	return value;
+}
+
+int AutoExpUpdate(struct AUTO_EXP *pExp)
+{
+	uint8 iRequested = pExp->nUpdates % (pExp->latency + 1);
+	uint32 shutter = pExp->shutter;
+	int diff;
+
+	pExp->frameShutter = pExp->requested[iRequested];
+	pExp->median = median(pExp);
+	pExp->nUpdates++;
+	diff = (int) pExp->median - pExp->target;
+	pExp->bSettled = FALSE;
+
+	/* A change still on its way is not corrected again. */
+	if (pExp->frameShutter == pExp->shutter && pExp->nPixels > 0) {
+		if (diff <= pExp->tolerance && -diff <= pExp->tolerance) {
+			pExp->bSettled = TRUE;
+		} else if (pExp->median >= AUTO_EXP_SATURATED) {
+			/* The true brightness is unknown, take the largest step. */
+			shutter = pExp->shutter / AUTO_EXP_MAX_STEP;
+		} else if (pExp->median == 0) {
+			shutter = pExp->shutter * AUTO_EXP_MAX_STEP;
+		} else {
+			/* The grey level is proportional to the exposure time. */
+			shutter = (uint32) ((unsigned long long) pExp->shutter * pExp->target / pExp->median);
+			if (shutter > pExp->shutter * AUTO_EXP_MAX_STEP)
+				shutter = pExp->shutter * AUTO_EXP_MAX_STEP;
+			if (shutter < pExp->shutter / AUTO_EXP_MAX_STEP)
+				shutter = pExp->shutter / AUTO_EXP_MAX_STEP;
+		}
+		if (shutter < pExp->minShutter)
+			shutter = pExp->minShutter;
+		if (shutter > pExp->maxShutter)
+			shutter = pExp->maxShutter;
+
+		/* At the limit of the range nothing better is possible. */
+		if (shutter == pExp->shutter)
+			pExp->bSettled = TRUE;
+	}
+
+	pExp->requested[iRequested] = shutter;
+	if (shutter == pExp->shutter)
+		return FALSE;
+
+	pExp->shutter = shutter;
+	pExp->nChanges++;
+	return TRUE;
+}
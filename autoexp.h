@@ -0,0 +1,116 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file autoexp.h
+ * @brief Auto exposure from a histogram of the picture.
+ * The histogram is gathered from the pixels the mean is taken from, in
+ * the same pass, so no extra traversal of the frame is needed. The
+ * shutter width bringing the median to the target grey level is predicted
+ * in closed form, assuming the grey level grows linearly with the
+ * exposure time. A new shutter width takes effect only some frames later;
+ * the controller knows which shutter width each frame was exposed with
+ * and waits for a change to arrive instead of correcting it again, so it
+ * settles within a few frames without overshooting.
+ */
+
+#ifndef AUTOEXP_H_
+#define AUTOEXP_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Maximum number of frames a new shutter width takes to arrive. */
+#define AUTO_EXP_MAX_LATENCY 4
+/*! @brief Largest factor the shutter width changes by at once. */
+#define AUTO_EXP_MAX_STEP 8
+/*! @brief Median grey level from which a picture is taken as saturated. */
+#define AUTO_EXP_SATURATED 250
+
+/*! @brief State of an auto exposure controller. */
+struct AUTO_EXP {
+	/*! @brief Histogram of the last picture measured. */
+	uint32 histogram[256];
+	uint32 nPixels;
+	/*! @brief Grey level the median is brought to, and the distance from
+	 * it which is left alone. */
+	uint8 target, tolerance;
+	/*! @brief Range of the shutter width [us]. */
+	uint32 minShutter, maxShutter;
+	/*! @brief Shutter width requested last [us]. */
+	uint32 shutter;
+	/*! @brief Shutter widths requested at the last latency + 1 updates. */
+	uint32 requested[AUTO_EXP_MAX_LATENCY + 1];
+	uint8 latency;
+	/*! @brief Number of updates. */
+	uint32 nUpdates;
+	/*! @brief Shutter width and median of the last picture measured. */
+	uint32 frameShutter;
+	uint8 median;
+	/*! @brief TRUE if the last picture was exposed right. */
+	int bSettled;
+	/*! @brief Number of changes of the shutter width. */
+	uint32 nChanges;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize an auto exposure controller.
+ *
+ * @param pExp Controller to initialize.
+ * @param shutter Shutter width just set on the camera [us]; the first
+ * latency pictures are taken as exposed with an unknown one.
+ * @param target Grey level the median is brought to (1 .. 254).
+ * @param minShutter Shortest shutter width [us].
+ * @param maxShutter Longest shutter width [us].
+ * @param latency Frames captured with the old shutter width after a
+ * change (0 .. AUTO_EXP_MAX_LATENCY).
+ * @return SUCCESS or -EINVALID_PARAMETER
+ *//*********************************************************************/
+OSC_ERR AutoExpInit(struct AUTO_EXP *pExp,
+		const uint32 shutter,
+		const uint8 target,
+		const uint32 minShutter,
+		const uint32 maxShutter,
+		const uint8 latency);
+
+/*********************************************************************//*!
+ * @brief Take the histogram of every step-th pixel and row of a picture.
+ *
+ * @param pExp Controller.
+ * @param pic Greyscale picture.
+ * @param step Distance of the pixels and rows.
+ * @param x0 First column.
+ * @param y0 First row.
+ * @return Mean of the pixels, as PicStatMeanSampled
+ *//*********************************************************************/
+uint32 AutoExpMeasure(struct AUTO_EXP *pExp,
+		const struct OSC_PICTURE *pic,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0);
+
+/*********************************************************************//*!
+ * @brief Predict the shutter width from the picture measured last.
+ *
+ * Call once per captured frame, after AutoExpMeasure.
+ *
+ * @param pExp Controller.
+ * @return TRUE if the shutter width changed and is to be set to
+ * pExp->shutter
+ *//*********************************************************************/
+int AutoExpUpdate(struct AUTO_EXP *pExp);
+
+#endif /* AUTOEXP_H_ */
@@ -0,0 +1,583 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+	
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+	
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+	
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/*!@file bench.c
+ * @brief Benchmark of the tutorial kernels.
+ * Times the hot paths of the samples on imgCapture.bmp: the picture mean
+ * of alarm.c, debayering, the background difference, bitmap reading and
+ * writing, a 2D DMA move and config lookups in config.txt. Each case is
+ * warmed up and then timed over a number of repetitions. The results are
+ * written to a file, one line per case, which serves as a baseline that
+ * later runs are compared against.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "picstat.h"
+#include "debayer.h"
+#include "bgmodel.h"
+#include "dmaplan.h"
+#include "cfgstore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Input picture, greyscale or a raw Bayer mosaic */
+#define BENCH_INPUT "imgCapture.bmp"
+/* Bitmap written by the write case */
+#define BENCH_OUTPUT "bench.bmp"
+/* Config file of the lookup cases */
+#define BENCH_CONFIG "config.txt"
+/* Default output file */
+#define BENCH_RESULTS "bench.txt"
+/* Calls per sample of the config lookups, which are too fast to time
+ * one by one */
+#define LOOKUP_CALLS 100
+/* Maximum number of repetitions */
+#define MAX_REPS 100000
+
+/*! @brief Data shared by the cases. */
+struct BENCH_DATA {
+	/*! @brief Input picture. */
+	struct OSC_PICTURE pic;
+	/*! @brief Colour, luma and copied pictures. */
+	uint8 *pColor, *pLuma, *pCopy;
+	/*! @brief Luma conversion. */
+	struct DEBAYER debayer;
+	/*! @brief Background model learned from the input picture. */
+	struct BG_MODEL bgModel;
+	uint8 *pBackground, *pFraction;
+	/*! @brief DMA plan and its move. */
+	struct DMA_PLAN plan;
+	struct DMA_MOVE move;
+	/*! @brief Picture read by the read case. */
+	struct OSC_PICTURE readPic;
+	/*! @brief Config file registered with the config module and its store. */
+	CFG_FILE_CONTENT_HANDLE hCfg;
+	struct CFG_STORE store;
+	/*! @brief Results, so that no call is optimized away. */
+	uint32 sink;
+};
+
+/*! @brief A benchmark case, returns SUCCESS or an error code. */
+typedef OSC_ERR (*BENCH_FUNC)(struct BENCH_DATA *pData);
+
+/*! @brief Statistics of a case in ns per call. */
+struct BENCH_RESULT {
+	char name[32];
+	uint32 calls, reps;
+	uint32 mean, min, p50, p90, p99, max;
+};
+
+/*********************************************************************//*!
+ * @brief Case: mean of the picture (alarm.c).
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS
+ *//*********************************************************************/
+static OSC_ERR benchMean(struct BENCH_DATA *pData)
+{
+	pData->sink += PicStatMean(&pData->pic);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Case: debayer the full frame with the vision module.
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchVisDebayer(struct BENCH_DATA *pData)
+{
+	return OscVisDebayer(pData->pic.data, pData->pic.width, pData->pic.height, ROW_BGBG, pData->pColor);
+}
+
+/*********************************************************************//*!
+ * @brief Case: convert the Bayer mosaic to luma (debayer.c).
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS
+ *//*********************************************************************/
+static OSC_ERR benchLuma(struct BENCH_DATA *pData)
+{
+	DebayerLuma(&pData->debayer, pData->pic.data, pData->pLuma);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Case: count the pixels differing from the background (bgmodel.c).
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS
+ *//*********************************************************************/
+static OSC_ERR benchBgDiff(struct BENCH_DATA *pData)
+{
+	pData->sink += BgModelDiff(&pData->bgModel, pData->pic.data, NULL);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Case: read the input bitmap with the bitmap module.
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchBmpRead(struct BENCH_DATA *pData)
+{
+	return OscBmpRead(&pData->readPic, BENCH_INPUT);
+}
+
+/*********************************************************************//*!
+ * @brief Case: write the input picture with the bitmap module.
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchBmpWrite(struct BENCH_DATA *pData)
+{
+	return OscBmpWrite(&pData->pic, BENCH_OUTPUT);
+}
+
+/*********************************************************************//*!
+ * @brief Case: copy the picture with a 2D DMA move (dma.c).
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchDma(struct BENCH_DATA *pData)
+{
+	OSC_ERR err;
+	
+	err = DmaPlanStart(&pData->plan, &pData->move, 1);
+	if (err != SUCCESS)
+		return err;
+	return DmaPlanSync(&pData->plan);
+}
+
+/*********************************************************************//*!
+ * @brief Case: look up a tag of a section with the config module.
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchCfgGetStr(struct BENCH_DATA *pData)
+{
+	struct CFG_KEY key;
+	struct CFG_VAL_STR val;
+	OSC_ERR err;
+	
+	key.strSection = "SECTION";
+	key.strTag = "NAME";
+	err = OscCfgGetStr(pData->hCfg, &key, &val);
+	pData->sink += val.str[0];
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Case: look up a tag of a section in the config store (cfgstore.c).
+ * 
+ * @param pData Benchmark data.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchCfgStoreGetStr(struct BENCH_DATA *pData)
+{
+	const char *value;
+	OSC_ERR err;
+	
+	err = CfgStoreGetStr(&pData->store, "SECTION", "NAME", &value);
+	if (err == SUCCESS)
+		pData->sink += value[0];
+	return err;
+}
+
+/*! @brief The cases with their calls per sample. */
+static const struct BENCH_CASE {
+	const char *name;
+	BENCH_FUNC run;
+	uint32 calls;
+} cases[] = {
+	{ "PicStatMean", benchMean, 1 },
+	{ "OscVisDebayer", benchVisDebayer, 1 },
+	{ "DebayerLuma", benchLuma, 1 },
+	{ "BgModelDiff", benchBgDiff, 1 },
+	{ "OscBmpRead", benchBmpRead, 1 },
+	{ "OscBmpWrite", benchBmpWrite, 1 },
+	{ "DmaPlan2DMove", benchDma, 1 },
+	{ "OscCfgGetStr", benchCfgGetStr, LOOKUP_CALLS },
+	{ "CfgStoreGetStr", benchCfgStoreGetStr, LOOKUP_CALLS },
+};
+
+/*********************************************************************//*!
+ * @brief Read the input picture and set up the data of the cases.
+ * 
+ * @param pData Benchmark data to set up.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR setup(struct BENCH_DATA *pData)
+{
+	uint32 size;
+	OSC_ERR err;
+	
+	memset(pData, 0, sizeof(struct BENCH_DATA));
+	err = OscBmpRead(&pData->pic, BENCH_INPUT);
+	if (err != SUCCESS || pData->pic.type != OSC_PICTURE_GREYSCALE) {
+		fprintf(stderr, "%s: ERROR: Unable to read greyscale picture %s! (%d)\n", __func__, BENCH_INPUT, err);
+		return err != SUCCESS ? err : -EINVALID_PARAMETER;
+	}
+	size = (uint32) pData->pic.width * pData->pic.height;
+	
+	pData->pColor = malloc(3 * size);
+	pData->pLuma = malloc(size);
+	pData->pCopy = malloc(size);
+	pData->pBackground = malloc(size);
+	pData->pFraction = malloc(size);
+	if (pData->pColor == NULL || pData->pLuma == NULL || pData->pCopy == NULL ||
+			pData->pBackground == NULL || pData->pFraction == NULL)
+		return -EOUT_OF_MEMORY;
+	
+	err = DebayerInit(&pData->debayer, pData->pic.width, pData->pic.height, ROW_BGBG, FALSE);
+	if (err != SUCCESS)
+		return err;
+	
+	/* A background which differs a bit from the picture */
+	err = BgModelInit(&pData->bgModel, pData->pic.width, pData->pic.height, pData->pBackground, pData->pFraction, 4, 20, 1);
+	if (err != SUCCESS)
+		return err;
+	BgModelReset(&pData->bgModel, pData->pic.data);
+	memset(pData->pBackground, 128, size / 2);
+	
+	err = DmaPlanInit(&pData->plan);
+	if (err != SUCCESS)
+		return err;
+	pData->move.pSrc = pData->pic.data;
+	pData->move.srcStride = pData->pic.width;
+	pData->move.srcStep = 1;
+	pData->move.pDst = pData->pCopy;
+	pData->move.dstStride = pData->pic.width;
+	pData->move.width = pData->pic.width;
+	pData->move.height = pData->pic.height;
+	
+	err = OscCfgRegisterFile(&pData->hCfg, BENCH_CONFIG, 1024);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to register %s! (%d)\n", __func__, BENCH_CONFIG, err);
+		return err;
+	}
+	return CfgStoreLoad(&pData->store, BENCH_CONFIG);
+}
+
+/*********************************************************************//*!
+ * @brief Free the data of the cases.
+ * 
+ * @param pData Benchmark data.
+ *//*********************************************************************/
+static void cleanup(struct BENCH_DATA *pData)
+{
+	CfgStoreDestroy(&pData->store);
+	free(pData->pic.data);
+	free(pData->readPic.data);
+	free(pData->pColor);
+	free(pData->pLuma);
+	free(pData->pCopy);
+	free(pData->pBackground);
+	free(pData->pFraction);
+	remove(BENCH_OUTPUT);
+}
+
+/*********************************************************************//*!
+ * @brief Convert cycles to nanoseconds.
+ * 
+ * @param cycles Cycles.
+ * @return Nanoseconds
+ *//*********************************************************************/
+static uint32 cyclesToNanoSecs(const uint32 cycles)
+{
+	/* Keep the precision of short samples. */
+	if (cycles < 0xFFFFFFFFUL / 1000)
+		return OscSupCycToMicroSecs(cycles * 1000);
+	return OscSupCycToMicroSecs(cycles) * 1000;
+}
+
+/*********************************************************************//*!
+ * @brief Compare function of qsort for uint32.
+ * 
+ * @param pA First value.
+ * @param pB Second value.
+ * @return Negative, 0 or positive if the first is smaller, equal or larger
+ *//*********************************************************************/
+static int compareSamples(const void *pA, const void *pB)
+{
+	uint32 a = *(const uint32 *) pA, b = *(const uint32 *) pB;
+	
+	return a < b ? -1 : a > b;
+}
+
+/*********************************************************************//*!
+ * @brief Time a case.
+ * 
+ * @param pCase Case.
+ * @param pData Benchmark data.
+ * @param warmup Untimed repetitions.
+ * @param reps Timed repetitions.
+ * @param pSamples Buffer for reps samples.
+ * @param pResult Result to fill in.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR runCase(const struct BENCH_CASE *pCase,
+		struct BENCH_DATA *pData,
+		const uint32 warmup,
+		const uint32 reps,
+		uint32 *pSamples,
+		struct BENCH_RESULT *pResult)
+{
+	unsigned long long sum = 0;
+	uint32 i, j, cycles;
+	OSC_ERR err = SUCCESS;
+	
+	for (i = 0; i < warmup && err == SUCCESS; i++) {
+		err = pCase->run(pData);
+	}
+	
+	for (i = 0; i < reps && err == SUCCESS; i++) {
+		cycles = OscSupCycGet();
+		for (j = 0; j < pCase->calls && err == SUCCESS; j++) {
+			err = pCase->run(pData);
+		}
+		pSamples[i] = cyclesToNanoSecs(OscSupCycGet() - cycles) / pCase->calls;
+		sum += pSamples[i];
+	}
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: %s failed! (%d)\n", __func__, pCase->name, err);
+		return err;
+	}
+	
+	qsort(pSamples, reps, sizeof(uint32), compareSamples);
+	memset(pResult, 0, sizeof(struct BENCH_RESULT));
+	strncpy(pResult->name, pCase->name, sizeof(pResult->name) - 1);
+	pResult->calls = pCase->calls;
+	pResult->reps = reps;
+	pResult->mean = (uint32) (sum / reps);
+	pResult->min = pSamples[0];
+	pResult->p50 = pSamples[(reps - 1) * 50 / 100];
+	pResult->p90 = pSamples[(reps - 1) * 90 / 100];
+	pResult->p99 = pSamples[(reps - 1) * 99 / 100];
+	pResult->max = pSamples[reps - 1];
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Print a result as a line of the results file.
+ * 
+ * @param pFile File.
+ * @param pResult Result.
+ *//*********************************************************************/
+static void printResult(FILE *pFile, const struct BENCH_RESULT *pResult)
+{
+	fprintf(pFile, "%-16s %5lu %6lu %10lu %10lu %10lu %10lu %10lu %10lu\n", pResult->name,
+			(unsigned long) pResult->calls, (unsigned long) pResult->reps,
+			(unsigned long) pResult->mean, (unsigned long) pResult->min,
+			(unsigned long) pResult->p50, (unsigned long) pResult->p90,
+			(unsigned long) pResult->p99, (unsigned long) pResult->max);
+}
+
+/*********************************************************************//*!
+ * @brief Compare results with a baseline results file.
+ * 
+ * A case is flagged as a regression if its median is slower than the one
+ * of the baseline by more than the tolerance.
+ * 
+ * @param fileName Baseline results file.
+ * @param pResults Results.
+ * @param nResults Number of results.
+ * @param tolerance Tolerance in percent.
+ * @param pnRegressions Set to the number of regressions.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR compare(const char *fileName,
+		const struct BENCH_RESULT *pResults,
+		const uint32 nResults,
+		const uint32 tolerance,
+		uint32 *pnRegressions)
+{
+	FILE *pFile;
+	char line[256];
+	struct BENCH_RESULT base;
+	unsigned long v[8];
+	uint32 i;
+	
+	pFile = fopen(fileName, "r");
+	if (pFile == NULL) {
+		fprintf(stderr, "%s: ERROR: Unable to open baseline %s!\n", __func__, fileName);
+		return -EUNABLE_TO_OPEN_FILE;
+	}
+	
+	*pnRegressions = 0;
+	printf("%-16s %10s %10s %8s\n", "case", "base p50", "p50", "change");
+	while (fgets(line, sizeof(line), pFile) != NULL) {
+		if (line[0] == '#' || sscanf(line, "%31s %lu %lu %lu %lu %lu %lu %lu %lu", base.name,
+				&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) != 9) {
+			continue;
+		}
+		base.p50 = v[4];
+		
+		for (i = 0; i < nResults && strcmp(pResults[i].name, base.name) != 0; i++);
+		if (i == nResults || base.p50 == 0) {
+			continue;
+		}
+		
+		printf("%-16s %10lu %10lu %+7ld%%", base.name, (unsigned long) base.p50, (unsigned long) pResults[i].p50,
+				((long) pResults[i].p50 - (long) base.p50) * 100 / (long) base.p50);
+		if ((unsigned long long) pResults[i].p50 * 100 > (unsigned long long) base.p50 * (100 + tolerance)) {
+			printf("  REGRESSION");
+			(*pnRegressions)++;
+		}
+		printf("\n");
+	}
+	
+	fclose(pFile);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Program entry.
+ * 
+ * @param argc Command line argument count.
+ * @param argv Command line argument string.
+ * @return 0 on success, 2 if a case regressed against the baseline
+ *//*********************************************************************/
+int main(const int argc, const char * argv[])
+{
+	void *hFramework;
+	static struct BENCH_DATA data;
+	const uint32 nCases = sizeof(cases) / sizeof(struct BENCH_CASE);
+	struct BENCH_RESULT results[sizeof(cases) / sizeof(struct BENCH_CASE)];
+	uint32 i, nResults = 0, nRegressions = 0, *pSamples;
+	FILE *pFile;
+	OSC_ERR err;
+	
+	uint32 opt_reps = 100, opt_warmup = 5, opt_tolerance = 10;
+	const char *opt_output = BENCH_RESULTS, *opt_baseline = NULL, *opt_filter = NULL;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: bench [ -h ] [ -n <n> ] [ -w <n> ] [ -o <file> ] [ -c <file> ] [ -t <percent> ] [ <case> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -n <n>: Timed repetitions per case (default 100).\n");
+			printf("    -w <n>: Untimed warm-up repetitions per case (default 5).\n");
+			printf("    -o <file>: Results file (default " BENCH_RESULTS ").\n");
+			printf("    -c <file>: Compares the medians with a baseline results file.\n");
+			printf("    -t <percent>: Slowdown flagged as a regression (default 10).\n");
+			printf("    <case>: Runs only the cases whose name contains this.\n");
+			return 0;
+		} else if (argv[i][0] == '-' && strchr("nwoct", argv[i][1]) != NULL && argv[i][2] == '\0') {
+			if (i + 1 >= argc) {
+				printf("Error: %s needs an argument.\n", argv[i]);
+				return 1;
+			}
+			switch (argv[i][1]) {
+			case 'n':
+				opt_reps = atoi(argv[i + 1]);
+				break;
+			case 'w':
+				opt_warmup = atoi(argv[i + 1]);
+				break;
+			case 'o':
+				opt_output = argv[i + 1];
+				break;
+			case 'c':
+				opt_baseline = argv[i + 1];
+				break;
+			default:
+				opt_tolerance = atoi(argv[i + 1]);
+				break;
+			}
+			i++;
+		} else if (argv[i][0] != '-' && opt_filter == NULL) {
+			opt_filter = argv[i];
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (opt_reps == 0 || opt_reps > MAX_REPS) {
+		printf("Error: The repetitions must be from 1 to %d.\n", MAX_REPS);
+		return 1;
+	}
+	
+	/* Create framework */
+	OscCreate(&hFramework);
+	
+	/* Load modules */
+	OscBmpCreate(hFramework);
+	OscVisCreate(hFramework);
+	OscDmaCreate(hFramework);
+	OscCfgCreate(hFramework);
+	OscSupCreate(hFramework);
+	
+	pSamples = malloc(opt_reps * sizeof(uint32));
+	err = pSamples != NULL ? setup(&data) : -EOUT_OF_MEMORY;
+	
+	/* Time the cases */
+	printf("# case calls reps mean min p50 p90 p99 max (ns per call)\n");
+	for (i = 0; i < nCases && err == SUCCESS; i++) {
+		if (opt_filter != NULL && strstr(cases[i].name, opt_filter) == NULL) {
+			continue;
+		}
+		err = runCase(&cases[i], &data, opt_warmup, opt_reps, pSamples, &results[nResults]);
+		if (err == SUCCESS) {
+			printResult(stdout, &results[nResults++]);
+		}
+	}
+	
+	/* Write the results */
+	if (err == SUCCESS) {
+		pFile = fopen(opt_output, "w");
+		if (pFile == NULL) {
+			fprintf(stderr, "%s: ERROR: Unable to write %s!\n", __func__, opt_output);
+			err = -EUNABLE_TO_OPEN_FILE;
+		} else {
+			fprintf(pFile, "# case calls reps mean min p50 p90 p99 max (ns per call)\n");
+			for (i = 0; i < nResults; i++) {
+				printResult(pFile, &results[i]);
+			}
+			fclose(pFile);
+		}
+	}
+	
+	/* Compare them with the baseline */
+	if (err == SUCCESS && opt_baseline != NULL) {
+		err = compare(opt_baseline, results, nResults, opt_tolerance, &nRegressions);
+	}
+	
+	cleanup(&data);
+	free(pSamples);
+	
+	/* Unload modules */
+	OscSupDestroy(hFramework);
+	OscCfgDestroy(hFramework);
+	OscDmaDestroy(hFramework);
+	OscVisDestroy(hFramework);
+	OscBmpDestroy(hFramework);
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	if (err != SUCCESS) {
+		return 1;
+	}
+	return nRegressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,281 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file bgmodel.c
+ * @brief Per-pixel background model for motion detection.
+ * The difference kernel processes a machine word of pixels per operation
+ * (four on the Blackfin) by splitting it into its even and odd bytes, each
+ * widened to 16 bit lanes. On the host, 16 pixels are processed at once
+ * using SSE2.
+ */
+
+#include "bgmodel.h"
+#include <string.h>
+
+#if defined(OSC_HOST) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*! @brief Bit 0 of all 16 bit lanes of a machine word. */
+#define LANES_ONE (~0UL / 0xffff)
+/*! @brief Mask of the low bytes of all 16 bit lanes of a machine word. */
+#define LANES (LANES_ONE * 0xff)
+/*! @brief Bit 9 of all 16 bit lanes of a machine word. */
+#define LANES_BIT9 (LANES_ONE << 9)
+/*! @brief Words processed before the 16 bit lane counters may overflow. */
+#define LANE_COUNT_WORDS 16384
+
+OSC_ERR BgModelInit(struct BG_MODEL *pModel,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBackground,
+		uint8 *pFraction,
+		const uint8 learnShift,
+		const uint8 threshold,
+		const uint8 interleave)
+{
+	if (((unsigned long) pBackground) % sizeof(unsigned long) != 0 ||
+			((unsigned long) pFraction) % sizeof(unsigned long) != 0 ||
+			learnShift < 1 || learnShift > 8 || interleave < 1) {
+		return -EINVALID_PARAMETER;
+	}
+
+	pModel->width = width;
+	pModel->height = height;
+	pModel->pBackground = pBackground;
+	pModel->pFraction = pFraction;
+	pModel->learnShift = learnShift;
+	pModel->threshold = threshold;
+	pModel->interleave = interleave;
+	pModel->phase = 0;
+
+	return SUCCESS;
+}
+
+void BgModelReset(struct BG_MODEL *pModel, const uint8 *pFrame)
+{
+	uint32 size = (uint32) pModel->width * pModel->height;
+
+	memcpy(pModel->pBackground, pFrame, size);
+	memset(pModel->pFraction, 0, size);
+}
+
+/*********************************************************************//*!
+ * @brief Blend a span of pixels into the background.
+ *
+ * Computes v = v - (v >> shift) + ((in << 8) >> shift) on the 8.8
+ * fixed-point background v, which stays within 16 bits. Word aligned parts
+ * of the span are processed a machine word of pixels at a time.
+ *
+ * @param pIn Greyscale pixels.
+ * @param pBg Integer part of the background.
+ * @param pFrac Fractional part of the background.
+ * @param n Number of pixels.
+ * @param shift Learning rate is 2^-shift.
+ *//*********************************************************************/
+static void updateSpan(const uint8 *pIn,
+		uint8 *pBg,
+		uint8 *pFrac,
+		uint32 n,
+		const uint8 shift)
+{
+	const unsigned long keep = LANES_ONE * (0xffff >> shift);
+	const unsigned long *pInW;
+	unsigned long *pBgW, *pFracW;
+	unsigned long in, ve, vo;
+	uint32 value, nWords;
+	int bAligned;
+
+	/* Pixels up to the first word boundary. */
+	bAligned = ((unsigned long) pIn) % sizeof(unsigned long) == ((unsigned long) pBg) % sizeof(unsigned long) &&
+			((unsigned long) pFrac) % sizeof(unsigned long) == ((unsigned long) pBg) % sizeof(unsigned long);
+	while (n > 0 && (!bAligned || ((unsigned long) pBg) % sizeof(unsigned long) != 0)) {
+		value = (*pBg << 8) | *pFrac;
+		value = value - (value >> shift) + ((*pIn++ << 8) >> shift);
+		*pBg++ = (uint8) (value >> 8);
+		*pFrac++ = (uint8) value;
+		n--;
+	}
+
+	/* Even and odd pixels in 16 bit lanes. */
+	pInW = (const unsigned long *) pIn;
+	pBgW = (unsigned long *) pBg;
+	pFracW = (unsigned long *) pFrac;
+	for (nWords = n / sizeof(unsigned long); nWords > 0; nWords--) {
+		in = *pInW++;
+		ve = ((*pBgW & LANES) << 8) | (*pFracW & LANES);
+		vo = (*pBgW & ~LANES) | ((*pFracW >> 8) & LANES);
+
+		ve = ve - ((ve >> shift) & keep) + ((in & LANES) << (8 - shift));
+		vo = vo - ((vo >> shift) & keep) + ((in & ~LANES) >> shift);
+
+		*pBgW++ = ((ve >> 8) & LANES) | (vo & ~LANES);
+		*pFracW++ = (ve & LANES) | ((vo & LANES) << 8);
+	}
+
+	/* Remaining pixels not filling a word. */
+	pIn = (const uint8 *) pInW;
+	pBg = (uint8 *) pBgW;
+	pFrac = (uint8 *) pFracW;
+	for (n = n % sizeof(unsigned long); n > 0; n--) {
+		value = (*pBg << 8) | *pFrac;
+		value = value - (value >> shift) + ((*pIn++ << 8) >> shift);
+		*pBg++ = (uint8) (value >> 8);
+		*pFrac++ = (uint8) value;
+	}
+}
+
+void BgModelUpdate(struct BG_MODEL *pModel, const uint8 *pFrame)
+{
+	uint16 y;
+	uint32 offset;
+
+	for (y = pModel->phase; y < pModel->height; y += pModel->interleave) {
+		offset = (uint32) y * pModel->width;
+		updateSpan(pFrame + offset,
+				pModel->pBackground + offset,
+				pModel->pFraction + offset,
+				pModel->width,
+				pModel->learnShift);
+	}
+
+	pModel->phase = (pModel->phase + 1) % pModel->interleave;
+}
+
+/*********************************************************************//*!
+ * @brief Compare consecutive pixels of a frame with the background.
+ *
+ * @param pFrame Greyscale pixels, should be word aligned.
+ * @param pBackground Background of the pixels.
+ * @param pMask Motion mask of the pixels (may be NULL).
+ * @param size Number of pixels.
+ * @param threshold Pixels differing by more than this are moving.
+ * @return Number of moving pixels
+ *//*********************************************************************/
+static uint32 diffSpan(const uint8 *pFrame,
+		const uint8 *pBackground,
+		uint8 *pMask,
+		const uint32 size,
+		const uint8 threshold)
+{
+	uint32 i = 0, nWords, nBlock, count = 0;
+	unsigned long bias, a, b, ae, ao, be, bo, me, mo, laneCount;
+	const unsigned long *pA, *pB;
+	unsigned long *pM = NULL;
+	uint8 d;
+
+#if defined(OSC_HOST) && defined(__SSE2__)
+	__m128i va, vb, vd, vm, vSum = _mm_setzero_si128();
+	const __m128i vZero = _mm_setzero_si128();
+	const __m128i vOne = _mm_set1_epi8(1);
+	const __m128i vThreshold = _mm_set1_epi8((char) threshold);
+
+	for (; i + 16 <= size; i += 16) {
+		va = _mm_loadu_si128((const __m128i *) (pFrame + i));
+		vb = _mm_loadu_si128((const __m128i *) (pBackground + i));
+
+		/* |a - b| > threshold <=> saturated |a - b| - threshold != 0 */
+		vd = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+		vm = _mm_cmpeq_epi8(_mm_subs_epu8(vd, vThreshold), vZero);
+		vm = _mm_andnot_si128(vm, _mm_set1_epi8((char) BG_MODEL_MOTION));
+
+		if (pMask != NULL)
+			_mm_storeu_si128((__m128i *) (pMask + i), vm);
+		vSum = _mm_add_epi64(vSum, _mm_sad_epu8(_mm_and_si128(vm, vOne), vZero));
+	}
+	count = (uint32) _mm_cvtsi128_si32(vSum) +
+			(uint32) _mm_cvtsi128_si32(_mm_srli_si128(vSum, 8));
+#endif
+
+	/* Each 16 bit lane holds 0x200 - (threshold + 1) + a - b, which is
+	 * positive and has bit 9 set exactly if a - b > threshold. */
+	bias = LANES_BIT9 - (threshold + 1) * LANES_ONE;
+
+	pA = (const unsigned long *) (pFrame + i);
+	pB = (const unsigned long *) (pBackground + i);
+	if (pMask != NULL)
+		pM = (unsigned long *) (pMask + i);
+	nWords = (size - i) / sizeof(unsigned long);
+	if (((unsigned long) pFrame) % sizeof(unsigned long) != 0 ||
+			((unsigned long) pMask) % sizeof(unsigned long) != 0) {
+		nWords = 0;
+	}
+	i += nWords * sizeof(unsigned long);
+
+	while (nWords > 0) {
+		nBlock = nWords < LANE_COUNT_WORDS ? nWords : LANE_COUNT_WORDS;
+		nWords -= nBlock;
+		laneCount = 0;
+
+		for (; nBlock > 0; nBlock--) {
+			a = *pA++;
+			b = *pB++;
+			ae = a & LANES;
+			be = b & LANES;
+			ao = (a >> 8) & LANES;
+			bo = (b >> 8) & LANES;
+
+			me = ((((ae + bias) - be) | ((be + bias) - ae)) & LANES_BIT9) >> 9;
+			mo = ((((ao + bias) - bo) | ((bo + bias) - ao)) & LANES_BIT9) >> 9;
+
+			if (pM != NULL)
+				*pM++ = (me | (mo << 8)) * BG_MODEL_MOTION;
+			laneCount += me + mo;
+		}
+
+		for (; laneCount != 0; laneCount >>= 16)
+			count += laneCount & 0xffff;
+	}
+
+	/* Remaining pixels not filling a word. */
+	for (; i < size; i++) {
+		d = pFrame[i] > pBackground[i] ?
+				pFrame[i] - pBackground[i] :
+				pBackground[i] - pFrame[i];
+		if (pMask != NULL)
+			pMask[i] = d > threshold ? BG_MODEL_MOTION : 0;
+		if (d > threshold)
+			count++;
+	}
+
+	return count;
+}
+
+uint32 BgModelDiff(const struct BG_MODEL *pModel,
+		const uint8 *pFrame,
+		uint8 *pMask)
+{
+	return diffSpan(pFrame, pModel->pBackground, pMask,
+			(uint32) pModel->width * pModel->height, pModel->threshold);
+}
+
+uint32 BgModelDiffRows(const struct BG_MODEL *pModel,
+		const uint8 *pFrame,
+		const uint8 rowStep)
+{
+	uint32 offset, count = 0;
+	uint16 y;
+
+	for (y = 0; y < pModel->height; y += rowStep) {
+		offset = (uint32) y * pModel->width;
+		count += diffSpan(pFrame + offset, pModel->pBackground + offset, NULL,
+				pModel->width, pModel->threshold);
+	}
+
+	return count * rowStep;
+}
@@ -0,0 +1,122 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file bgmodel.h
+ * @brief Per-pixel background model for motion detection.
+ * The background is a fixed-point running average of the greyscale frames.
+ * Pixels differing more than a threshold from it form the motion mask.
+ */
+
+#ifndef BGMODEL_H_
+#define BGMODEL_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Value of a moving pixel in the motion mask. */
+#define BG_MODEL_MOTION 0xff
+
+/*! @brief State of a background model. */
+struct BG_MODEL {
+	/*! @brief Width of the frames. */
+	uint16 width;
+	/*! @brief Height of the frames. */
+	uint16 height;
+	/*! @brief Integer part of the background (word aligned). */
+	uint8 *pBackground;
+	/*! @brief Fractional part of the background (word aligned). */
+	uint8 *pFraction;
+	/*! @brief Learning rate of the running average is 2^-learnShift. */
+	uint8 learnShift;
+	/*! @brief Pixels differing more than this are moving. */
+	uint8 threshold;
+	/*! @brief Only every interleave-th row is updated per frame. */
+	uint8 interleave;
+	/*! @brief Row offset of the next update. */
+	uint8 phase;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize a background model on caller supplied buffers.
+ *
+ * @param pModel Model to initialize.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @param pBackground Word aligned buffer of width * height bytes.
+ * @param pFraction Word aligned buffer of width * height bytes.
+ * @param learnShift Learning rate is 2^-learnShift (1 .. 8).
+ * @param threshold Pixels differing by more than this are moving.
+ * @param interleave Update one of interleave rows per frame (>= 1).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BgModelInit(struct BG_MODEL *pModel,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBackground,
+		uint8 *pFraction,
+		const uint8 learnShift,
+		const uint8 threshold,
+		const uint8 interleave);
+
+/*********************************************************************//*!
+ * @brief Set the background to a frame.
+ *
+ * @param pModel Model.
+ * @param pFrame Greyscale frame.
+ *//*********************************************************************/
+void BgModelReset(struct BG_MODEL *pModel, const uint8 *pFrame);
+
+/*********************************************************************//*!
+ * @brief Blend a frame into the background.
+ *
+ * Only the rows of the current interleave phase are updated, which
+ * amortizes the cost of the update over interleave frames.
+ *
+ * @param pModel Model.
+ * @param pFrame Greyscale frame.
+ *//*********************************************************************/
+void BgModelUpdate(struct BG_MODEL *pModel, const uint8 *pFrame);
+
+/*********************************************************************//*!
+ * @brief Compare a frame with the background.
+ *
+ * @param pModel Model.
+ * @param pFrame Greyscale frame, should be word aligned.
+ * @param pMask Motion mask of width * height bytes, set to
+ * BG_MODEL_MOTION for moving and 0 for static pixels (may be NULL).
+ * @return Number of moving pixels
+ *//*********************************************************************/
+uint32 BgModelDiff(const struct BG_MODEL *pModel,
+		const uint8 *pFrame,
+		uint8 *pMask);
+
+/*********************************************************************//*!
+ * @brief Estimate the moving pixels of a frame from some of its rows.
+ *
+ * Compares every rowStep-th row with the background, which takes a
+ * fraction of the time of BgModelDiff.
+ *
+ * @param pModel Model.
+ * @param pFrame Greyscale frame, should be word aligned.
+ * @param rowStep Distance of the compared rows (>= 1).
+ * @return Number of moving pixels of the compared rows times rowStep
+ *//*********************************************************************/
+uint32 BgModelDiffRows(const struct BG_MODEL *pModel,
+		const uint8 *pFrame,
+		const uint8 rowStep);
+
+#endif /* BGMODEL_H_ */
@@ -18,12 +18,99 @@
 
 /*!@file bmp.c
  * @brief Bitmap module example.
- * Demonstrates how to read and write bitmap files.
+ * Demonstrates how to read and write bitmap files, either with the bitmap
+ * module or memory mapped and row by row (bmpmap.c). With -b <n> both
+ * round trips are timed n times.
  */
 
 #include "oscar/staging/inc/oscar.h"
+#include "bmpmap.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/*********************************************************************//*!
+ * @brief Copy a bitmap file using the bitmap module.
+ * 
+ * @param pic Picture buffer, allocated by the first call.
+ * @param src Source file name.
+ * @param dst Destination file name.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR copyModule(struct OSC_PICTURE *pic, const char *src, const char *dst)
+{
+	OSC_ERR err;
+	
+	err = OscBmpRead(pic, src);
+	if (err != SUCCESS)
+		return err;
+	return OscBmpWrite(pic, dst);
+}
+
+/*********************************************************************//*!
+ * @brief Copy a bitmap file memory mapped, without a picture buffer.
+ * 
+ * @param src Source file name.
+ * @param dst Destination file name.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR copyMapped(const char *src, const char *dst)
+{
+	OSC_ERR err;
+	struct BMP_MAP map;
+	struct BMP_WRITER writer;
+	
+	err = BmpMapOpen(&map, src);
+	if (err != SUCCESS)
+		return err;
+	
+	err = BmpWriterOpen(&writer, dst, map.pic.width, map.pic.height, map.pic.type);
+	if (err == SUCCESS) {
+		/* Stream the rows straight from the mapping to the file */
+		err = BmpWriterPutTile(&writer, 0, 0, map.pic.width, map.pic.height, BmpMapRow(&map, 0), map.rowStep);
+		BmpWriterClose(&writer);
+	}
+	
+	BmpMapClose(&map);
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Time both round trips.
+ * 
+ * @param n Number of repetitions.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchmark(const uint32 n)
+{
+	OSC_ERR err = SUCCESS;
+	struct OSC_PICTURE pic;
+	uint32 i, cycles, usModule = 0, usMapped = 0;
+	
+	memset(&pic, 0, sizeof(struct OSC_PICTURE));
+	
+	for (i = 0; i < n && err == SUCCESS; i++) {
+		cycles = OscSupCycGet();
+		err = copyModule(&pic, "imgCapture.bmp", "modified.bmp");
+		usModule += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		if (err == SUCCESS)
+			err = copyMapped("imgCapture.bmp", "mapped.bmp");
+		usMapped += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+	}
+	free(pic.data);
+	if (err != SUCCESS) {
+		printf("%s: Round trip failed (%d)!\n", __func__, err);
+		return err;
+	}
+	
+	printf("OscBmpRead/OscBmpWrite: %lu us per round trip\n", usModule / n);
+	printf("BmpMapOpen/BmpWriterPutTile: %lu us per round trip\n", usMapped / n);
+	
+	return SUCCESS;
+}
+
 /*********************************************************************//*!
  * @brief Program entry.
  * 
@@ -38,27 +125,58 @@ int main(const int argc, const char * argv[])
 	
 	/* Picture data structure. */
 	struct OSC_PICTURE pic;
+	
+	/* Memory mapped bitmap. */
+	struct BMP_MAP map;
+	
+	/* Round trips of the benchmark. */
+	int n;
+	OSC_ERR err = SUCCESS;
 	memset(&pic, 0, sizeof(struct OSC_PICTURE));
 	
 	/* Create framework */
 	OscCreate(&hFramework);
 	
-	/* Load bitmap module */
+	/* Load bitmap and support module */
 	OscBmpCreate(hFramework);
+	OscSupCreate(hFramework);
 	
-	/* Read picture from file */
-	OscBmpRead(&pic, "imgCapture.bmp");
-	
-	/* Process picture */
-	/* -------------- */
-	
-	/* Setup target picture */
-	pic.width = OSC_CAM_MAX_IMAGE_WIDTH;
-	pic.height = OSC_CAM_MAX_IMAGE_HEIGHT;
-	pic.type = OSC_PICTURE_GREYSCALE;
+	if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+		n = atoi(argv[2]);
+		if (n <= 0) {
+			fprintf(stderr, "Invalid number of round trips: %s\n", argv[2]);
+			err = -EINVALID_PARAMETER;
+		} else {
+			err = benchmark(n);
+		}
+	} else {
+		/* Read picture from file */
+		OscBmpRead(&pic, "imgCapture.bmp");
+		
+		/* Process picture */
+		/* -------------- */
+		
+		/* Setup target picture */
+		pic.width = OSC_CAM_MAX_IMAGE_WIDTH;
+		pic.height = OSC_CAM_MAX_IMAGE_HEIGHT;
+		pic.type = OSC_PICTURE_GREYSCALE;
+		
+		/* Write picture to file */
+		OscBmpWrite(&pic, "modified.bmp");
+		
+		/* Map picture file: rows are accessed in place, no copy is made. The
+		 * data pointer is only set if the rows are stored top-down. */
+		if (BmpMapOpen(&map, "imgCapture.bmp") == SUCCESS) {
+			printf("Mapped %ux%u picture, top row starts with %u\n", map.pic.width, map.pic.height, BmpMapRow(&map, 0)[0]);
+			BmpMapClose(&map);
+		}
+		
+		/* Write picture file row by row as the rows are produced */
+		copyMapped("imgCapture.bmp", "mapped.bmp");
+	}
 	
-	/* Write picture to file */
-	OscBmpWrite(&pic, "modified.bmp");
+	/* Destroy support module */
+	OscSupDestroy(hFramework);
 	
 	/* Destroy bitmap module */
 	OscBmpDestroy(hFramework);
@@ -66,5 +184,5 @@ int main(const int argc, const char * argv[])
 	/* Destroy framework */
 	OscDestroy(hFramework);
 	
-	return 0;
+	return err == SUCCESS ? 0 : 1;
 }
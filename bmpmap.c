@@ -0,0 +1,283 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file bmpmap.c
+ * @brief Memory mapped bitmap reader and streaming bitmap writer.
+ * The writer sizes the file up front, so every row is written once at its
+ * final position. Consecutive full rows are gathered in reverse order into
+ * one writev call, which also flips them to the bottom-up row order of the
+ * file without a copy.
+ */
+
+#include "bmpmap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/*! @brief Size of the file header and the info header. */
+#define BMP_HEADER_SIZE (14 + 40)
+/*! @brief Size of the palette of a greyscale bitmap. */
+#define BMP_PALETTE_SIZE (256 * 4)
+/*! @brief Maximum number of rows written with one system call. */
+#define BMP_WRITER_BATCH_ROWS 64
+
+/*! @brief Read a little endian 16 bit value. */
+#define GET16(p) ((uint32) (p)[0] | ((uint32) (p)[1] << 8))
+/*! @brief Read a little endian 32 bit value. */
+#define GET32(p) (GET16(p) | (GET16((p) + 2) << 16))
+
+/*********************************************************************//*!
+ * @brief Store a little endian 32 bit value.
+ *
+ * @param p Destination.
+ * @param value Value.
+ *//*********************************************************************/
+static void put32(uint8 *p, const uint32 value)
+{
+	p[0] = (uint8) value;
+	p[1] = (uint8) (value >> 8);
+	p[2] = (uint8) (value >> 16);
+	p[3] = (uint8) (value >> 24);
+}
+
+OSC_ERR BmpMapOpen(struct BMP_MAP *pMap, const char *strFileName)
+{
+	struct stat st;
+	int fd;
+	uint32 offset, stride, bytesPerPixel, height;
+	int bTopDown;
+	uint8 *p;
+
+	memset(pMap, 0, sizeof(struct BMP_MAP));
+
+	fd = open(strFileName, O_RDONLY);
+	if (fd < 0)
+		return -EUNABLE_TO_OPEN_FILE;
+	if (fstat(fd, &st) != 0 || st.st_size < BMP_HEADER_SIZE) {
+		close(fd);
+		return -EFILE_ERROR;
+	}
+	pMap->size = st.st_size;
+
+	pMap->pFile = mmap(NULL, pMap->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (pMap->pFile != MAP_FAILED) {
+		pMap->bMapped = TRUE;
+	} else {
+		/* No mapping available, read the file in one piece. */
+		pMap->pFile = malloc(pMap->size);
+		if (pMap->pFile == NULL) {
+			close(fd);
+			return -EOUT_OF_MEMORY;
+		}
+		if (read(fd, pMap->pFile, pMap->size) != (ssize_t) pMap->size) {
+			free(pMap->pFile);
+			close(fd);
+			return -EFILE_ERROR;
+		}
+	}
+	close(fd);
+
+	p = pMap->pFile;
+	offset = GET32(p + 10);
+	height = GET32(p + 22);
+	bTopDown = (height & 0x80000000UL) != 0;
+	if (bTopDown)
+		height = (~height + 1) & 0xffffffffUL;
+	bytesPerPixel = GET16(p + 28) / 8;
+	if (p[0] != 'B' || p[1] != 'M' || GET32(p + 30) != 0 ||
+			(bytesPerPixel != 1 && bytesPerPixel != 3)) {
+		BmpMapClose(pMap);
+		return -EFILE_ERROR;
+	}
+
+	pMap->pic.width = (uint16) GET32(p + 18);
+	pMap->pic.height = (uint16) height;
+	pMap->pic.type = bytesPerPixel == 1 ? OSC_PICTURE_GREYSCALE : OSC_PICTURE_BGR_24;
+
+	stride = (pMap->pic.width * bytesPerPixel + 3) & ~3UL;
+	if (offset + stride * pMap->pic.height > pMap->size) {
+		BmpMapClose(pMap);
+		return -EFILE_ERROR;
+	}
+
+	if (bTopDown) {
+		/* Top-down rows. */
+		pMap->pTop = p + offset;
+		pMap->rowStep = stride;
+		if (stride == pMap->pic.width * bytesPerPixel)
+			pMap->pic.data = pMap->pTop;
+	} else {
+		/* Bottom-up rows, the usual case. */
+		pMap->pTop = p + offset + stride * (pMap->pic.height - 1);
+		pMap->rowStep = -(long) stride;
+	}
+
+	return SUCCESS;
+}
+
+const uint8 * BmpMapRow(const struct BMP_MAP *pMap, const uint16 y)
+{
+	return pMap->pTop + pMap->rowStep * y;
+}
+
+void BmpMapClose(struct BMP_MAP *pMap)
+{
+	if (pMap->pFile == NULL)
+		return;
+
+	if (pMap->bMapped)
+		munmap(pMap->pFile, pMap->size);
+	else
+		free(pMap->pFile);
+	pMap->pFile = NULL;
+	pMap->pic.data = NULL;
+}
+
+OSC_ERR BmpWriterOpen(struct BMP_WRITER *pWriter,
+		const char *strFileName,
+		const uint16 width,
+		const uint16 height,
+		const enum EnOscPictureType type)
+{
+	uint8 header[BMP_HEADER_SIZE + BMP_PALETTE_SIZE];
+	uint32 headerSize, fileSize, i;
+
+	if (type == OSC_PICTURE_GREYSCALE)
+		pWriter->bytesPerPixel = 1;
+	else if (type == OSC_PICTURE_BGR_24)
+		pWriter->bytesPerPixel = 3;
+	else
+		return -EINVALID_PARAMETER;
+
+	pWriter->width = width;
+	pWriter->height = height;
+	pWriter->stride = (width * pWriter->bytesPerPixel + 3) & ~3UL;
+	headerSize = BMP_HEADER_SIZE;
+	if (pWriter->bytesPerPixel == 1)
+		headerSize += BMP_PALETTE_SIZE;
+	pWriter->dataOffset = headerSize;
+	fileSize = headerSize + pWriter->stride * height;
+
+	memset(header, 0, headerSize);
+	header[0] = 'B';
+	header[1] = 'M';
+	put32(header + 2, fileSize);
+	put32(header + 10, headerSize);
+	put32(header + 14, 40);
+	put32(header + 18, width);
+	put32(header + 22, height);
+	put32(header + 26, 1 | ((uint32) pWriter->bytesPerPixel * 8) << 16);
+	put32(header + 34, pWriter->stride * height);
+	if (pWriter->bytesPerPixel == 1) {
+		put32(header + 46, 256);
+		for (i = 0; i < 256; i++)
+			put32(header + BMP_HEADER_SIZE + 4 * i, i * 0x010101);
+	}
+
+	pWriter->fd = open(strFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (pWriter->fd < 0)
+		return -EUNABLE_TO_OPEN_FILE;
+
+	/* Size the file up front; the padding bytes read as zero. */
+	if (ftruncate(pWriter->fd, fileSize) != 0 ||
+			pwrite(pWriter->fd, header, headerSize, 0) != (ssize_t) headerSize) {
+		close(pWriter->fd);
+		return -EFILE_ERROR;
+	}
+
+	return SUCCESS;
+}
+
+OSC_ERR BmpWriterPutRows(struct BMP_WRITER *pWriter,
+		const uint16 y,
+		const uint16 nRows,
+		const uint8 *pData)
+{
+	return BmpWriterPutTile(pWriter, 0, y, pWriter->width, nRows, pData,
+			(uint32) pWriter->width * pWriter->bytesPerPixel);
+}
+
+OSC_ERR BmpWriterPutTile(struct BMP_WRITER *pWriter,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height,
+		const uint8 *pData,
+		const long stride)
+{
+	static const uint8 padding[4] = { 0, 0, 0, 0 };
+	struct iovec iov[2 * BMP_WRITER_BATCH_ROWS];
+	uint32 row, rowSize = (uint32) width * pWriter->bytesPerPixel;
+	uint32 padSize = 0, batchSize, nBatch, i, n;
+	const uint8 *pRow;
+	off_t offset;
+
+	if ((uint32) x + width > pWriter->width || (uint32) y + height > pWriter->height)
+		return -EINVALID_PARAMETER;
+
+	/* Full rows are contiguous in the file together with their padding. */
+	if (x == 0 && width == pWriter->width)
+		padSize = pWriter->stride - rowSize;
+
+	for (row = 0; row < height; row += nBatch) {
+		nBatch = height - row;
+		if (padSize == 0 && width != pWriter->width)
+			nBatch = 1;
+		else if (nBatch > BMP_WRITER_BATCH_ROWS)
+			nBatch = BMP_WRITER_BATCH_ROWS;
+
+		/* Bitmap rows are stored bottom-up: the last row of the batch
+		 * comes first in the file. */
+		batchSize = 0;
+		n = 0;
+		for (i = nBatch; i > 0; i--) {
+			pRow = pData + stride * (long) (row + i - 1);
+			iov[n].iov_base = (void *) pRow;
+			iov[n].iov_len = rowSize;
+			n++;
+			if (padSize > 0) {
+				iov[n].iov_base = (void *) padding;
+				iov[n].iov_len = padSize;
+				n++;
+			}
+			batchSize += rowSize + padSize;
+		}
+
+		offset = pWriter->dataOffset +
+				(off_t) (pWriter->height - y - row - nBatch) * pWriter->stride +
+				(off_t) x * pWriter->bytesPerPixel;
+		if (lseek(pWriter->fd, offset, SEEK_SET) != offset ||
+				writev(pWriter->fd, iov, n) != (ssize_t) batchSize) {
+			return -EFILE_ERROR;
+		}
+	}
+
+	return SUCCESS;
+}
+
+OSC_ERR BmpWriterClose(struct BMP_WRITER *pWriter)
+{
+	if (close(pWriter->fd) != 0)
+		return -EFILE_ERROR;
+
+	return SUCCESS;
+}
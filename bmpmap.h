@@ -0,0 +1,148 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file bmpmap.h
+ * @brief Memory mapped bitmap reader and streaming bitmap writer.
+ * Uncompressed 8 bit greyscale and 24 bit BGR bitmaps are supported. The
+ * reader maps the file and gives access to its rows without copying them,
+ * the writer stores rows or tiles as they are produced.
+ */
+
+#ifndef BMPMAP_H_
+#define BMPMAP_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <stddef.h>
+
+/*! @brief A bitmap file opened for reading. */
+struct BMP_MAP {
+	/*! @brief Start and size of the mapping or the buffer read. */
+	uint8 *pFile;
+	size_t size;
+	/*! @brief TRUE if pFile is a mapping, FALSE if it was read to memory. */
+	int bMapped;
+	/*! @brief Top row of the picture in the file. */
+	uint8 *pTop;
+	/*! @brief Distance in bytes from one row to the one below it. */
+	long rowStep;
+	/*! @brief Picture dimensions and type. The data pointer refers into
+	 * the file if the rows are stored top-down without padding, otherwise
+	 * it is NULL and the rows must be accessed with BmpMapRow. */
+	struct OSC_PICTURE pic;
+};
+
+/*! @brief A bitmap file opened for writing. */
+struct BMP_WRITER {
+	/*! @brief File descriptor. */
+	int fd;
+	/*! @brief Offset of the pixel data in the file. */
+	uint32 dataOffset;
+	/*! @brief Bytes per row in the file, including padding. */
+	uint32 stride;
+	/*! @brief Picture dimensions and type. */
+	uint16 width, height;
+	uint8 bytesPerPixel;
+};
+
+/*********************************************************************//*!
+ * @brief Open a bitmap file and map it to memory.
+ *
+ * If the file can't be mapped (e.g. on a system without MMU), it is read
+ * to memory in one piece instead.
+ *
+ * @param pMap Bitmap to open.
+ * @param strFileName File name.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BmpMapOpen(struct BMP_MAP *pMap, const char *strFileName);
+
+/*********************************************************************//*!
+ * @brief Get a row of an opened bitmap.
+ *
+ * @param pMap Opened bitmap.
+ * @param y Row, 0 is the top row.
+ * @return Pointer to the pixels of the row in the file
+ *//*********************************************************************/
+const uint8 * BmpMapRow(const struct BMP_MAP *pMap, const uint16 y);
+
+/*********************************************************************//*!
+ * @brief Unmap a bitmap file.
+ *
+ * @param pMap Opened bitmap.
+ *//*********************************************************************/
+void BmpMapClose(struct BMP_MAP *pMap);
+
+/*********************************************************************//*!
+ * @brief Create a bitmap file and write its header.
+ *
+ * @param pWriter Writer to initialize.
+ * @param strFileName File name.
+ * @param width Picture width.
+ * @param height Picture height.
+ * @param type OSC_PICTURE_GREYSCALE or OSC_PICTURE_BGR_24.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BmpWriterOpen(struct BMP_WRITER *pWriter,
+		const char *strFileName,
+		const uint16 width,
+		const uint16 height,
+		const enum EnOscPictureType type);
+
+/*********************************************************************//*!
+ * @brief Write consecutive full rows.
+ *
+ * @param pWriter Opened writer.
+ * @param y First row, 0 is the top row.
+ * @param nRows Number of rows.
+ * @param pData Pixels of the rows, without padding.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BmpWriterPutRows(struct BMP_WRITER *pWriter,
+		const uint16 y,
+		const uint16 nRows,
+		const uint8 *pData);
+
+/*********************************************************************//*!
+ * @brief Write a rectangular tile.
+ *
+ * @param pWriter Opened writer.
+ * @param x Left column of the tile.
+ * @param y Top row of the tile.
+ * @param width Tile width.
+ * @param height Tile height.
+ * @param pData Pixels of the top row of the tile.
+ * @param stride Bytes from one row of pData to the next (may be negative).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BmpWriterPutTile(struct BMP_WRITER *pWriter,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height,
+		const uint8 *pData,
+		const long stride);
+
+/*********************************************************************//*!
+ * @brief Close a bitmap file.
+ *
+ * @param pWriter Opened writer.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BmpWriterClose(struct BMP_WRITER *pWriter);
+
+#endif /* BMPMAP_H_ */
@@ -0,0 +1,194 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file burst.c
+ * @brief Burst capture into preallocated memory.
+ * The camera module knows few frame buffers, so its buffer IDs are pointed
+ * at the next frames of the arena in turn instead of registering every
+ * frame; this only stores a pointer. The frames are flushed with writev
+ * in batches, so the raw file is written sequentially in few calls.
+ */
+
+#include "burst.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/*! @brief Frames written with one system call. */
+#define BURST_WRITE_BATCH 16
+
+OSC_ERR BurstInit(struct BURST *pBurst,
+		const uint16 width,
+		const uint16 height,
+		const uint32 nFrames,
+		const uint16 timeout)
+{
+	uint32 i;
+
+	memset(pBurst, 0, sizeof(struct BURST));
+	if (width == 0 || height == 0 || nFrames == 0)
+		return -EINVALID_PARAMETER;
+
+	pBurst->width = width;
+	pBurst->height = height;
+	pBurst->frameSize = (uint32) width * height;
+	pBurst->stride = (pBurst->frameSize + BURST_ALIGN - 1) & ~(uint32) (BURST_ALIGN - 1);
+	pBurst->nFrames = nFrames;
+	pBurst->timeout = timeout;
+
+	/* One contiguous arena, touched once so no page is faulted in while
+	 * capturing. */
+	pBurst->pMemory = malloc((size_t) pBurst->stride * nFrames + BURST_ALIGN);
+	pBurst->pFrames = malloc(nFrames * sizeof(struct BURST_FRAME));
+	if (pBurst->pMemory == NULL || pBurst->pFrames == NULL) {
+		BurstDestroy(pBurst);
+		return -EOUT_OF_MEMORY;
+	}
+	pBurst->pArena = (uint8 *) (((unsigned long) pBurst->pMemory + BURST_ALIGN - 1) & ~(unsigned long) (BURST_ALIGN - 1));
+	memset(pBurst->pArena, 0, (size_t) pBurst->stride * nFrames);
+
+	for (i = 0; i < nFrames; i++)
+		pBurst->pFrames[i].pData = pBurst->pArena + (size_t) pBurst->stride * i;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Set up and trigger the capture of a frame.
+ *
+ * @param pBurst Burst.
+ * @param i Frame number.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR startFrame(struct BURST *pBurst, const uint32 i)
+{
+	const uint8 id = i % BURST_BUFFER_IDS;
+	OSC_ERR err;
+
+	err = OscCamSetFrameBuffer(id, pBurst->frameSize, pBurst->pFrames[i].pData, TRUE);
+	if (err == SUCCESS)
+		err = OscCamSetupCapture(id);
+	if (err == SUCCESS)
+		err = OscGpioTriggerImage();
+	return err;
+}
+
+OSC_ERR BurstCapture(struct BURST *pBurst)
+{
+	struct BURST_FRAME *pFrame;
+	uint32 i, cycles, lastCycles = 0;
+	unsigned long long microSecs = 0;
+	uint8 *pData;
+	uint8 retry;
+	OSC_ERR err;
+
+	pBurst->nCaptured = 0;
+	pBurst->nDropped = 0;
+
+	err = startFrame(pBurst, 0);
+	for (i = 0; i < pBurst->nFrames && err == SUCCESS; i++) {
+		pFrame = &pBurst->pFrames[i];
+		for (retry = 0; retry < BURST_MAX_RETRIES; retry++) {
+			err = OscCamReadPicture(i % BURST_BUFFER_IDS, &pData, 0, pBurst->timeout);
+			if (err == SUCCESS)
+				break;
+
+			/* The frame is lost, capture it again. */
+			pBurst->nDropped++;
+			err = startFrame(pBurst, i);
+			if (err != SUCCESS)
+				break;
+		}
+		if (err != SUCCESS)
+			break;
+
+		/* Expose the next frame first, then stamp this one. */
+		cycles = OscSupCycGet();
+		if (i + 1 < pBurst->nFrames)
+			err = startFrame(pBurst, i + 1);
+
+		if (i > 0)
+			microSecs += OscSupCycToMicroSecs(cycles - lastCycles);
+		lastCycles = cycles;
+		gettimeofday(&pFrame->time, NULL);
+		pFrame->microSecs = (uint32) microSecs;
+		pBurst->nCaptured++;
+	}
+
+	if (err != SUCCESS)
+		fprintf(stderr, "%s: ERROR: Burst stopped after %lu frames! (%d)\n", __func__, (unsigned long) pBurst->nCaptured, err);
+	return err;
+}
+
+OSC_ERR BurstFlush(const struct BURST *pBurst, const char *fileName, const char *indexName)
+{
+	struct iovec iov[BURST_WRITE_BATCH];
+	const struct BURST_FRAME *pFrame;
+	uint32 i, n;
+	ssize_t batchSize;
+	FILE *pIndex;
+	int fd;
+	OSC_ERR err = SUCCESS;
+
+	fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return -EUNABLE_TO_OPEN_FILE;
+
+	for (i = 0; i < pBurst->nCaptured && err == SUCCESS; i += n) {
+		batchSize = 0;
+		for (n = 0; n < BURST_WRITE_BATCH && i + n < pBurst->nCaptured; n++) {
+			iov[n].iov_base = pBurst->pFrames[i + n].pData;
+			iov[n].iov_len = pBurst->frameSize;
+			batchSize += pBurst->frameSize;
+		}
+		if (writev(fd, iov, n) != batchSize)
+			err = -EFILE_ERROR;
+	}
+	if (fsync(fd) != 0 && err == SUCCESS)
+		err = -EFILE_ERROR;
+	if (close(fd) != 0 && err == SUCCESS)
+		err = -EFILE_ERROR;
+	if (err != SUCCESS)
+		return err;
+
+	pIndex = fopen(indexName, "w");
+	if (pIndex == NULL)
+		return -EUNABLE_TO_OPEN_FILE;
+	fprintf(pIndex, "# %ux%u greyscale, %lu frames of %lu bytes: frame, offset, time, us from the first frame\n",
+			pBurst->width, pBurst->height, (unsigned long) pBurst->nCaptured, (unsigned long) pBurst->frameSize);
+	for (i = 0; i < pBurst->nCaptured; i++) {
+		pFrame = &pBurst->pFrames[i];
+		fprintf(pIndex, "%lu %lu %lu.%06lu %lu\n", (unsigned long) i, (unsigned long) i * pBurst->frameSize,
+				(unsigned long) pFrame->time.tv_sec, (unsigned long) pFrame->time.tv_usec,
+				(unsigned long) pFrame->microSecs);
+	}
+	if (fclose(pIndex) != 0)
+		return -EFILE_ERROR;
+	return SUCCESS;
+}
+
+void BurstDestroy(struct BURST *pBurst)
+{
+	free(pBurst->pMemory);
+	free(pBurst->pFrames);
+	pBurst->pMemory = NULL;
+	pBurst->pArena = NULL;
+	pBurst->pFrames = NULL;
+}
@@ -0,0 +1,120 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file burst.h
+ * @brief Burst capture into preallocated memory.
+ * A burst captures a fixed number of frames back to back at the rate of
+ * the sensor into an arena allocated up front. Nothing is allocated,
+ * processed or written while capturing; each frame only gets its time
+ * stamp. Afterwards the frames are written to a raw file without header,
+ * with an index of the frame times beside it.
+ */
+
+#ifndef BURST_H_
+#define BURST_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <sys/time.h>
+
+/*! @brief Frame buffer IDs pointed at the arena in turn (0 .. n - 1). */
+#define BURST_BUFFER_IDS 2
+/*! @brief Alignment of the frames in the arena, a cache line. */
+#define BURST_ALIGN 32
+/*! @brief Maximum number of attempts to capture a frame. */
+#define BURST_MAX_RETRIES 3
+
+/*! @brief A frame of a burst. */
+struct BURST_FRAME {
+	/*! @brief Frame data in the arena. */
+	uint8 *pData;
+	/*! @brief Time the frame was read out. */
+	struct timeval time;
+	/*! @brief Microseconds from the first frame, by the cycle counter. */
+	uint32 microSecs;
+};
+
+/*! @brief State of a burst. */
+struct BURST {
+	/*! @brief Frame size. */
+	uint16 width, height;
+	uint32 frameSize;
+	/*! @brief Distance of the frames in the arena. */
+	uint32 stride;
+	/*! @brief Arena as allocated and aligned. */
+	uint8 *pMemory, *pArena;
+	/*! @brief Frames. */
+	struct BURST_FRAME *pFrames;
+	uint32 nFrames;
+	/*! @brief Time to wait for a picture in ms. */
+	uint16 timeout;
+	/*! @brief Frames captured by the last burst, and captures lost. */
+	uint32 nCaptured, nDropped;
+};
+
+/*********************************************************************//*!
+ * @brief Allocate the arena of a burst.
+ *
+ * @param pBurst Burst to initialize.
+ * @param width Frame width (the width of the area of interest).
+ * @param height Frame height.
+ * @param nFrames Number of frames of a burst.
+ * @param timeout Time to wait for a picture in ms (0 = infinite).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BurstInit(struct BURST *pBurst,
+		const uint16 width,
+		const uint16 height,
+		const uint32 nFrames,
+		const uint16 timeout);
+
+/*********************************************************************//*!
+ * @brief Capture a burst.
+ *
+ * Each capture is set up and triggered as soon as the frame before is
+ * read. Frame buffer IDs 0 to BURST_BUFFER_IDS - 1 are pointed at the
+ * arena and must not be used otherwise meanwhile. Requires the sup, cam
+ * and gpio modules to be loaded.
+ *
+ * @param pBurst Burst.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BurstCapture(struct BURST *pBurst);
+
+/*********************************************************************//*!
+ * @brief Write the frames of the last burst.
+ *
+ * The frames are written one after the other to a raw file without
+ * header, in large writes. The index is a text file with a line per
+ * frame: number, offset in the raw file, time of day in seconds and
+ * microseconds from the first frame.
+ *
+ * @param pBurst Burst.
+ * @param fileName Raw file.
+ * @param indexName Index file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR BurstFlush(const struct BURST *pBurst, const char *fileName, const char *indexName);
+
+/*********************************************************************//*!
+ * @brief Free the arena of a burst.
+ *
+ * @param pBurst Burst.
+ *//*********************************************************************/
+void BurstDestroy(struct BURST *pBurst);
+
+#endif /* BURST_H_ */
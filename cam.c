@@ -19,10 +19,69 @@
 /*!@file cam.c
  * @brief Camera module example.
  * Demonstrates how to capture pictures using multiple buffers.
+ * With -b, a burst of frames is captured at the rate of the sensor into
+ * preallocated memory (burst.c) and written to a raw file afterwards.
  */
 
 #include "oscar/staging/inc/oscar.h"
+#include "burst.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BURST_FILE "burst.raw" /* Frames of a burst, without header */
+#define BURST_INDEX "burst.idx" /* Times of the frames of a burst */
+#define BURST_TIMEOUT 500 /* ms to wait for a frame of a burst */
+
+/*********************************************************************//*!
+ * @brief Capture a burst and write it to BURST_FILE and BURST_INDEX.
+ * 
+ * @param nFrames Number of frames.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR captureBurst(const uint32 nFrames)
+{
+	struct BURST burst;
+	uint32 i, start, us, interval, minInterval = 0xFFFFFFFFUL, maxInterval = 0;
+	OSC_ERR err;
+	
+	err = BurstInit(&burst, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, nFrames, BURST_TIMEOUT);
+	if(err != SUCCESS){
+		printf("%s: Unable to allocate %lu frames (%d)!\n", __func__, (unsigned long) nFrames, err);
+		return err;
+	}
+	
+	/* Nothing but the capture runs until the burst is complete */
+	err = BurstCapture(&burst);
+	if(burst.nCaptured > 1){
+		for(i = 1; i < burst.nCaptured; i++){
+			interval = burst.pFrames[i].microSecs - burst.pFrames[i - 1].microSecs;
+			minInterval = interval < minInterval ? interval : minInterval;
+			maxInterval = interval > maxInterval ? interval : maxInterval;
+		}
+		us = burst.pFrames[burst.nCaptured - 1].microSecs;
+		printf("Burst: %lu frames in %lu ms, %.1f fps, %lu to %lu us apart, %lu dropped\n",
+				(unsigned long) burst.nCaptured, (unsigned long) (us / 1000),
+				us > 0 ? (float) (burst.nCaptured - 1) * 1000000 / us : 0,
+				(unsigned long) minInterval, (unsigned long) maxInterval, (unsigned long) burst.nDropped);
+	}
+	
+	/* Write the frames afterwards */
+	if(err == SUCCESS){
+		start = OscSupCycGet();
+		err = BurstFlush(&burst, BURST_FILE, BURST_INDEX);
+		us = OscSupCycToMicroSecs(OscSupCycGet() - start);
+		if(err != SUCCESS){
+			printf("%s: Unable to write %s (%d)!\n", __func__, BURST_FILE, err);
+		}else{
+			printf("Written to %s and %s in %lu ms, %.1f MB/s\n", BURST_FILE, BURST_INDEX, (unsigned long) (us / 1000),
+					us > 0 ? (float) burst.nCaptured * burst.frameSize / us : 0);
+		}
+	}
+	
+	BurstDestroy(&burst);
+	return err;
+}
 
 /*********************************************************************//*!
  * @brief Program entry.
@@ -47,9 +106,9 @@ int main(const int argc, const char * argv[])
 	uint16 blackOffset;
 	uint8 bufferIDs[2];
 	
-	/* Frame buffers. */
-	uint8 frameBuffer0[OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
-	uint8 frameBuffer1[OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
+	/* Frame buffers (too large for the stack). */
+	static uint8 frameBuffer0[OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
+	static uint8 frameBuffer1[OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
 	
 	/* Pointer to captured picture */
 	void *pic;
@@ -58,11 +117,31 @@ int main(const int argc, const char * argv[])
 	
 	OSC_ERR err = SUCCESS;
 	
+	uint32 opt_burst = 0;
+	int i;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			opt_burst = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: cam [ -h ] [ -b <n> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -b <n>: Captures a burst of n frames to %s and %s.\n", BURST_FILE, BURST_INDEX);
+			return 0;
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	
 	/* Create framework */
 	OscCreate(&hFramework);
 	
 	/* Load camera module */
 	OscCamCreate(hFramework);
+	
+	/* Load support module (cycle counter) */
+	OscSupCreate(hFramework);
 
 	/* Load GPIO module */
 	OscGpioCreate(hFramework);
@@ -148,14 +227,23 @@ int main(const int argc, const char * argv[])
 	/* Process picture */
 	/* --------------- */
 	
+	/* Capture a burst into the buffers of the burst instead */
+	if(opt_burst > 0){
+		OscCamDeleteMultiBuffer();
+		err = captureBurst(opt_burst);
+	}
+	
 	/* Unload camera module */
 	OscCamDestroy(hFramework);
 
 	/* Unload GPIO module */
 	OscGpioDestroy(hFramework);
 	
+	/* Unload support module */
+	OscSupDestroy(hFramework);
+	
 	/* Destroy framework */
 	OscDestroy(hFramework);
 	
-	return 0;
+	return err == SUCCESS ? 0 : 1;
 }
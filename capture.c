@@ -0,0 +1,173 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file capture.c
+ * @brief Pipelined capturing into a frame pool.
+ * Reading a picture immediately sets up and triggers the capture of the
+ * next one, so the sensor exposes frame N+1 while frame N is analysed.
+ * Each capture goes to a free buffer of the pool rather than the next one
+ * of a fixed multi buffer ring, so buffers still referenced by consumers
+ * are skipped. Replayed frames are lent to the buffers instead of being
+ * captured into them.
+ * Requires the sup, cam and gpio modules to be loaded.
+ */
+
+#include "capture.h"
+#include <stdio.h>
+
+OSC_ERR CaptureInit(struct CAPTURE_PIPELINE *pPipe,
+		struct FRAME_POOL *pPool,
+		const uint16 timeout)
+{
+	if (pPool->nFrames < 2) {
+		fprintf(stderr, "%s: ERROR: Pool of %u buffers is too small!\n", __func__, pPool->nFrames);
+		return -EINVALID_PARAMETER;
+	}
+
+	pPipe->pPool = pPool;
+	pPipe->timeout = timeout;
+	pPipe->pReplay = NULL;
+	pPipe->pPending = NULL;
+	pPipe->nFrames = 0;
+	pPipe->nDropped = 0;
+	pPipe->sumMicroSecs = 0;
+	pPipe->lastCycles = OscSupCycGet();
+
+	return SUCCESS;
+}
+
+void CaptureSetReplay(struct CAPTURE_PIPELINE *pPipe, struct REPLAY *pReplay)
+{
+	pPipe->pReplay = pReplay;
+}
+
+OSC_ERR CaptureStart(struct CAPTURE_PIPELINE *pPipe)
+{
+	OSC_ERR err;
+	struct FRAME *pFrame;
+
+	if (pPipe->pPending != NULL)
+		return SUCCESS;
+
+	err = FramePoolAcquire(pPipe->pPool, pPipe->timeout, &pFrame);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: No free frame buffer! (%d)\n", __func__, err);
+		return err;
+	}
+	if (pPipe->pReplay != NULL) {
+		pPipe->pPending = pFrame;
+		return SUCCESS;
+	}
+
+	err = OscCamSetupCapture(pFrame->id);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable setup capture! (%d)\n", __func__, err);
+		FrameRelease(pFrame);
+		return err;
+	}
+	err = OscGpioTriggerImage();
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to trigger! (%d)\n", __func__, err);
+		FrameRelease(pFrame);
+		return err;
+	}
+
+	pPipe->pPending = pFrame;
+	return SUCCESS;
+}
+
+OSC_ERR CaptureNext(struct CAPTURE_PIPELINE *pPipe, struct FRAME **ppFrame)
+{
+	OSC_ERR err = SUCCESS;
+	struct FRAME *pFrame = NULL;
+	uint32 cycles;
+	uint8 *pData;
+	uint8 retry;
+
+	for (retry = 0; retry < CAPTURE_MAX_RETRIES; retry++) {
+		err = CaptureStart(pPipe);
+		if (err != SUCCESS)
+			return err;
+
+		/* The reference of the pending frame passes to the caller. */
+		pFrame = pPipe->pPending;
+		pPipe->pPending = NULL;
+		if (pPipe->pReplay != NULL) {
+			pFrame->pData = (uint8 *) ReplayNext(pPipe->pReplay);
+			break;
+		}
+		err = OscCamReadPicture(pFrame->id, &pData, 0, pPipe->timeout);
+		if (err == SUCCESS)
+			break;
+
+		/* The frame is lost, capture it again. */
+		FrameRelease(pFrame);
+		pPipe->nDropped++;
+	}
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable read picture! (%d)\n", __func__, err);
+		return err;
+	}
+	*ppFrame = pFrame;
+
+	/* Expose the next frame while the caller processes this one. */
+	err = CaptureStart(pPipe);
+	if (err != SUCCESS) {
+		FrameRelease(pFrame);
+		return err;
+	}
+
+	cycles = OscSupCycGet();
+	pPipe->sumMicroSecs += OscSupCycToMicroSecs(cycles - pPipe->lastCycles);
+	pPipe->lastCycles = cycles;
+	pPipe->nFrames++;
+
+	return SUCCESS;
+}
+
+OSC_ERR CaptureStop(struct CAPTURE_PIPELINE *pPipe)
+{
+	OSC_ERR err;
+	uint8 *pData;
+
+	if (pPipe->pPending == NULL)
+		return SUCCESS;
+
+	err = SUCCESS;
+	if (pPipe->pReplay == NULL)
+		err = OscCamReadPicture(pPipe->pPending->id, &pData, 0, pPipe->timeout);
+	FrameRelease(pPipe->pPending);
+	pPipe->pPending = NULL;
+	pPipe->lastCycles = OscSupCycGet();
+	return err;
+}
+
+void CapturePrintStats(struct CAPTURE_PIPELINE *pPipe)
+{
+	float fps = 0;
+
+	if (pPipe->sumMicroSecs != 0)
+		fps = (float)pPipe->nFrames * 1000000 / pPipe->sumMicroSecs;
+
+	printf("Capture: %lu frames, %.2f fps, %lu dropped\n",
+			pPipe->nFrames, fps, pPipe->nDropped);
+
+	pPipe->nFrames = 0;
+	pPipe->nDropped = 0;
+	pPipe->sumMicroSecs = 0;
+}
@@ -0,0 +1,117 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file capture.h
+ * @brief Pipelined capturing into a frame pool.
+ * The next picture is already exposed while the current one is processed.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "framepool.h"
+#include "replay.h"
+
+/*! @brief Number of attempts to capture a frame before giving up. */
+#define CAPTURE_MAX_RETRIES 3
+
+/*! @brief State of a capture pipeline. */
+struct CAPTURE_PIPELINE {
+	/*! @brief Pool providing the frame buffers. */
+	struct FRAME_POOL *pPool;
+	/*! @brief Timeout in ms when waiting for a picture (0 = infinite). */
+	uint16 timeout;
+	/*! @brief Replayed frames served instead of captured ones, NULL to
+	 * capture with the camera. */
+	struct REPLAY *pReplay;
+	/*! @brief Frame set up and triggered, NULL if none. */
+	struct FRAME *pPending;
+	/*! @brief Number of frames delivered. */
+	uint32 nFrames;
+	/*! @brief Number of frames lost and captured again. */
+	uint32 nDropped;
+	/*! @brief Cycle count when the last frame was delivered. */
+	uint32 lastCycles;
+	/*! @brief Accumulated time between delivered frames [us]. */
+	uint32 sumMicroSecs;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a pipeline capturing into the buffers of a frame pool.
+ *
+ * @param pPipe Pipeline to initialize.
+ * @param pPool Initialized frame pool of at least two buffers.
+ * @param timeout Time to wait for a picture or a free buffer in ms
+ * (0 = infinite).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CaptureInit(struct CAPTURE_PIPELINE *pPipe,
+		struct FRAME_POOL *pPool,
+		const uint16 timeout);
+
+/*********************************************************************//*!
+ * @brief Serve replayed frames instead of capturing them.
+ *
+ * The frames still take a buffer of the pool each, so they are retained
+ * and released as captured ones, but their data points to the replayed
+ * frame and must not be written to.
+ *
+ * @param pPipe Pipeline without a pending capture.
+ * @param pReplay Opened replay of frames of the pool's frame size, NULL
+ * to capture with the camera again.
+ *//*********************************************************************/
+void CaptureSetReplay(struct CAPTURE_PIPELINE *pPipe, struct REPLAY *pReplay);
+
+/*********************************************************************//*!
+ * @brief Set up and trigger the next capture if none is pending.
+ *
+ * @param pPipe Pipeline.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CaptureStart(struct CAPTURE_PIPELINE *pPipe);
+
+/*********************************************************************//*!
+ * @brief Wait for the pending frame and trigger the following one.
+ *
+ * The returned frame holds one reference for the caller, who releases it
+ * with FrameRelease when done. The sensor exposes the following frame
+ * into another free buffer of the pool while the caller processes it.
+ *
+ * @param pPipe Pipeline.
+ * @param ppFrame The captured frame.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CaptureNext(struct CAPTURE_PIPELINE *pPipe, struct FRAME **ppFrame);
+
+/*********************************************************************//*!
+ * @brief Wait for a pending capture to finish and discard the frame.
+ *
+ * @param pPipe Pipeline.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CaptureStop(struct CAPTURE_PIPELINE *pPipe);
+
+/*********************************************************************//*!
+ * @brief Print frame rate and frame drop statistics and reset them.
+ *
+ * @param pPipe Pipeline.
+ *//*********************************************************************/
+void CapturePrintStats(struct CAPTURE_PIPELINE *pPipe);
+
+#endif /* CAPTURE_H_ */
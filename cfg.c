@@ -20,9 +20,11 @@
  * @brief Config module example.
  * Demonstrates how to read/write settings from/to config files.
  * See config.txt for file structure details.
+ * The second part does the same with an indexed store (cfgstore.c).
  */
 
 #include "oscar/staging/inc/oscar.h"
+#include "cfgstore.h"
 #include <stdio.h>
 
 /*********************************************************************//*!
@@ -40,7 +42,13 @@ int main(const int argc, const char * argv[])
 	int16 number1;
 	int32 number2;
 	
-	char strNumber[10];
+	char strNumber[12];
+	
+	/* Indexed store of the config file */
+	struct CFG_STORE store;
+	struct CFG_STORE_QUERY queries[4];
+	const char *strName;
+	int32 runs;
 	
 	/* Handle to the config file */
 	CFG_FILE_CONTENT_HANDLE hCfg;
@@ -89,6 +97,45 @@ int main(const int argc, const char * argv[])
 	/* Destroy support module */
 	OscCfgDestroy(hFramework);
 	
+	/* Read the file again into an indexed store */
+	if (CfgStoreLoad(&store, fileName) != SUCCESS) {
+		OscDestroy(hFramework);
+		return 1;
+	}
+	
+	/* Look up several values at once */
+	queries[0].strSection = NULL;
+	queries[0].strTag = "NAME";
+	queries[0].type = CFG_STORE_STR;
+	queries[0].pValue = &strName;
+	queries[1].strSection = NULL;
+	queries[1].strTag = "16BIT";
+	queries[1].type = CFG_STORE_INT16;
+	queries[1].pValue = &number1;
+	queries[2].strSection = "NEWSECTION";
+	queries[2].strTag = "NEW32BIT";
+	queries[2].type = CFG_STORE_INT32;
+	queries[2].pValue = &number2;
+	queries[3].strSection = "SECTION";
+	queries[3].strTag = "RUNS";
+	queries[3].type = CFG_STORE_INT32;
+	queries[3].pValue = &runs;
+	CfgStoreGetBatch(&store, queries, 4);
+	
+	printf("NAME: %s\n", queries[0].err == SUCCESS ? strName : "-");
+	printf("16BIT: %d\n", number1);
+	printf("NEWSECTION NEW32BIT: %ld\n", number2);
+	
+	/* Count the runs; only section SECTION is rewritten */
+	if (queries[3].err != SUCCESS)
+		runs = 0;
+	sprintf(strNumber, "%ld", runs + 1);
+	CfgStoreSetStr(&store, "SECTION", "RUNS", strNumber);
+	printf("SECTION RUNS: %s\n", strNumber);
+	CfgStoreFlush(&store);
+	
+	CfgStoreDestroy(&store);
+	
 	/* Destroy framework */
 	OscDestroy(hFramework);
 	
@@ -0,0 +1,684 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file cfgstore.c
+ * @brief Indexed store of a config file.
+ * A line "TAG: value" sets a tag of the current section, any other
+ * non-empty line starts a new section; lines starting with '#' are
+ * ignored. The strings point into a copy of the file text, split by
+ * terminating zeros. The original text is kept, so that flushing can copy
+ * what did not change. The hash table uses linear probing and is kept at
+ * most half full.
+ */
+
+#include "cfgstore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+
+/*! @brief Growing text buffer for flushing. */
+struct TEXT_BUFFER {
+	char *p;
+	long size, max;
+};
+
+/*********************************************************************//*!
+ * @brief Hash a section and a tag (FNV-1a).
+ *
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @return Hash
+ *//*********************************************************************/
+static uint32 hashKey(const char *strSection, const char *strTag)
+{
+	uint32 hash = 2166136261UL;
+	const char *p;
+
+	for (p = strSection != NULL ? strSection : ""; *p != '\0'; p++)
+		hash = ((hash ^ (uint8) *p) * 16777619UL) & 0xFFFFFFFFUL;
+	/* Separates "AB" + "C" from "A" + "BC". */
+	hash = ((hash ^ 0xFF) * 16777619UL) & 0xFFFFFFFFUL;
+	for (p = strTag; *p != '\0'; p++)
+		hash = ((hash ^ (uint8) *p) * 16777619UL) & 0xFFFFFFFFUL;
+
+	return hash;
+}
+
+/*********************************************************************//*!
+ * @brief Find the entry of a section and a tag.
+ *
+ * @param pStore Store.
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @return Entry index, -1 if there is none
+ *//*********************************************************************/
+static long findEntry(const struct CFG_STORE *pStore, const char *strSection, const char *strTag)
+{
+	uint32 hash = hashKey(strSection, strTag), i;
+	const struct CFG_STORE_ENTRY *pEntry;
+	long iEntry;
+
+	if (pStore->nBuckets == 0)
+		return -1;
+	if (strSection == NULL)
+		strSection = "";
+
+	for (i = hash & (pStore->nBuckets - 1); pStore->pBuckets[i] >= 0; i = (i + 1) & (pStore->nBuckets - 1)) {
+		iEntry = pStore->pBuckets[i];
+		pEntry = &pStore->pEntries[iEntry];
+		if (pEntry->hash == hash && strcmp(pEntry->tag, strTag) == 0 &&
+				strcmp(pStore->pSections[pEntry->iSection].name, strSection) == 0)
+			return iEntry;
+	}
+
+	return -1;
+}
+
+/*********************************************************************//*!
+ * @brief Put an entry into the hash table, growing it if needed.
+ *
+ * @param pStore Store.
+ * @param iEntry Entry index.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR hashEntry(struct CFG_STORE *pStore, const long iEntry)
+{
+	uint32 i, nBuckets;
+	long *pBuckets;
+
+	if (2 * pStore->nEntries > pStore->nBuckets) {
+		nBuckets = pStore->nBuckets == 0 ? 64 : 2 * pStore->nBuckets;
+		pBuckets = malloc(nBuckets * sizeof(long));
+		if (pBuckets == NULL)
+			return -EOUT_OF_MEMORY;
+		free(pStore->pBuckets);
+		pStore->pBuckets = pBuckets;
+		pStore->nBuckets = nBuckets;
+
+		/* Rehash all entries, which includes the new one. */
+		memset(pBuckets, 0xFF, nBuckets * sizeof(long));
+		for (i = 0; i < pStore->nEntries; i++)
+			hashEntry(pStore, i);
+		return SUCCESS;
+	}
+
+	for (i = pStore->pEntries[iEntry].hash & (pStore->nBuckets - 1);
+			pStore->pBuckets[i] >= 0;
+			i = (i + 1) & (pStore->nBuckets - 1));
+	pStore->pBuckets[i] = iEntry;
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Convert the value of an entry to an integer if it is one.
+ *
+ * @param pEntry Entry.
+ *//*********************************************************************/
+static void parseNumber(struct CFG_STORE_ENTRY *pEntry)
+{
+	char *pEnd;
+
+	errno = 0;
+	pEntry->number = strtol(pEntry->value, &pEnd, 10);
+	pEntry->bNumber = *pEntry->value != '\0' && *pEnd == '\0' && errno == 0;
+}
+
+/*********************************************************************//*!
+ * @brief Add a section.
+ *
+ * @param pStore Store.
+ * @param name Name of the section, must stay valid.
+ * @param textBegin Offset of the section in the file, -1 if it is new.
+ * @return Section index, -1 if out of memory
+ *//*********************************************************************/
+static long addSection(struct CFG_STORE *pStore, const char *name, const long textBegin)
+{
+	struct CFG_STORE_SECTION *pSections, *pSection;
+
+	if (pStore->nSections == pStore->maxSections) {
+		pSections = realloc(pStore->pSections,
+				(2 * pStore->maxSections + 8) * sizeof(struct CFG_STORE_SECTION));
+		if (pSections == NULL)
+			return -1;
+		pStore->pSections = pSections;
+		pStore->maxSections = 2 * pStore->maxSections + 8;
+	}
+
+	pSection = &pStore->pSections[pStore->nSections];
+	memset(pSection, 0, sizeof(struct CFG_STORE_SECTION));
+	pSection->name = name;
+	pSection->textBegin = textBegin;
+	pSection->textEnd = textBegin;
+	pSection->insertAt = textBegin;
+	pSection->iFirst = -1;
+	pSection->iLast = -1;
+
+	return pStore->nSections++;
+}
+
+/*********************************************************************//*!
+ * @brief Add a tag to a section.
+ *
+ * @param pStore Store.
+ * @param iSection Section index.
+ * @param tag Tag, must stay valid.
+ * @param value Value, must stay valid.
+ * @param valueBegin Offset of the value in the file, -1 if it is new.
+ * @param valueEnd Offset of the end of the value in the file.
+ * @return Entry index, -1 if out of memory
+ *//*********************************************************************/
+static long addEntry(struct CFG_STORE *pStore,
+		const uint32 iSection,
+		const char *tag,
+		const char *value,
+		const long valueBegin,
+		const long valueEnd)
+{
+	struct CFG_STORE_SECTION *pSection = &pStore->pSections[iSection];
+	struct CFG_STORE_ENTRY *pEntries, *pEntry;
+	long iEntry;
+
+	if (pStore->nEntries == pStore->maxEntries) {
+		pEntries = realloc(pStore->pEntries,
+				(2 * pStore->maxEntries + 32) * sizeof(struct CFG_STORE_ENTRY));
+		if (pEntries == NULL)
+			return -1;
+		pStore->pEntries = pEntries;
+		pStore->maxEntries = 2 * pStore->maxEntries + 32;
+	}
+
+	iEntry = pStore->nEntries++;
+	pEntry = &pStore->pEntries[iEntry];
+	memset(pEntry, 0, sizeof(struct CFG_STORE_ENTRY));
+	pEntry->iSection = iSection;
+	pEntry->tag = tag;
+	pEntry->value = value;
+	pEntry->hash = hashKey(pSection->name, tag);
+	pEntry->valueBegin = valueBegin;
+	pEntry->valueEnd = valueEnd;
+	pEntry->iNext = -1;
+	parseNumber(pEntry);
+
+	if (pSection->iLast >= 0)
+		pStore->pEntries[pSection->iLast].iNext = iEntry;
+	else
+		pSection->iFirst = iEntry;
+	pSection->iLast = iEntry;
+
+	if (hashEntry(pStore, iEntry) != SUCCESS) {
+		pStore->nEntries--;
+		return -1;
+	}
+	return iEntry;
+}
+
+/*********************************************************************//*!
+ * @brief Index the text of a store.
+ *
+ * @param pStore Store with the text set and no sections or entries.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR parse(struct CFG_STORE *pStore)
+{
+	const char *pText = pStore->pText;
+	char *pStrings, *pColon;
+	long pos = 0, lineBegin, lineEnd, next, begin, end, tagEnd, value, iSection;
+
+	pStrings = malloc(pStore->textSize + 1);
+	if (pStrings == NULL)
+		return -EOUT_OF_MEMORY;
+	memcpy(pStrings, pText, pStore->textSize);
+	pStrings[pStore->textSize] = '\0';
+	pStore->pStrings = pStrings;
+
+	iSection = addSection(pStore, "", 0);
+	if (iSection < 0)
+		return -EOUT_OF_MEMORY;
+
+	while (pos < pStore->textSize) {
+		lineBegin = pos;
+		for (lineEnd = pos; lineEnd < pStore->textSize && pText[lineEnd] != '\n'; lineEnd++);
+		next = lineEnd < pStore->textSize ? lineEnd + 1 : lineEnd;
+		pos = next;
+
+		/* Trim the line, which also drops a carriage return. */
+		for (begin = lineBegin; begin < lineEnd && isspace((uint8) pText[begin]); begin++);
+		for (end = lineEnd; end > begin && isspace((uint8) pText[end - 1]); end--);
+		if (begin == end || pText[begin] == '#')
+			continue;
+
+		pColon = memchr(pText + begin, ':', end - begin);
+		if (pColon == NULL) {
+			/* A section header. */
+			pStore->pSections[iSection].textEnd = lineBegin;
+			pStrings[end] = '\0';
+			iSection = addSection(pStore, pStrings + begin, lineBegin);
+			if (iSection < 0)
+				return -EOUT_OF_MEMORY;
+			pStore->pSections[iSection].insertAt = next;
+			continue;
+		}
+
+		for (tagEnd = pColon - pText; tagEnd > begin && isspace((uint8) pText[tagEnd - 1]); tagEnd--);
+		for (value = pColon - pText + 1; value < end && isspace((uint8) pText[value]); value++);
+		pStrings[tagEnd] = '\0';
+		pStrings[end] = '\0';
+
+		/* The first of repeated tags counts. */
+		if (findEntry(pStore, pStore->pSections[iSection].name, pStrings + begin) >= 0)
+			continue;
+		if (addEntry(pStore, iSection, pStrings + begin, pStrings + value, value, end) < 0)
+			return -EOUT_OF_MEMORY;
+		pStore->pSections[iSection].insertAt = next;
+	}
+	pStore->pSections[iSection].textEnd = pStore->textSize;
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Free the index of a store, keeping its text.
+ *
+ * @param pStore Store.
+ *//*********************************************************************/
+static void clearIndex(struct CFG_STORE *pStore)
+{
+	uint32 i;
+
+	for (i = 0; i < pStore->nEntries; i++)
+		free(pStore->pEntries[i].pOwned);
+	for (i = 0; i < pStore->nSections; i++)
+		free(pStore->pSections[i].pOwned);
+	pStore->nEntries = 0;
+	pStore->nSections = 0;
+	if (pStore->pBuckets != NULL)
+		memset(pStore->pBuckets, 0xFF, pStore->nBuckets * sizeof(long));
+
+	free(pStore->pStrings);
+	pStore->pStrings = NULL;
+}
+
+OSC_ERR CfgStoreLoad(struct CFG_STORE *pStore, const char *fileName)
+{
+	FILE *pFile;
+	OSC_ERR err;
+
+	memset(pStore, 0, sizeof(struct CFG_STORE));
+	pStore->fileName = malloc(strlen(fileName) + 1);
+	if (pStore->fileName == NULL)
+		return -EOUT_OF_MEMORY;
+	strcpy(pStore->fileName, fileName);
+
+	pFile = fopen(fileName, "r");
+	if (pFile == NULL && errno != ENOENT) {
+		CfgStoreDestroy(pStore);
+		return -EUNABLE_TO_OPEN_FILE;
+	}
+
+	if (pFile != NULL) {
+		if (fseek(pFile, 0, SEEK_END) != 0 || (pStore->textSize = ftell(pFile)) < 0 ||
+				fseek(pFile, 0, SEEK_SET) != 0) {
+			fclose(pFile);
+			CfgStoreDestroy(pStore);
+			return -EFILE_ERROR;
+		}
+	}
+
+	pStore->pText = malloc(pStore->textSize + 1);
+	if (pStore->pText == NULL) {
+		if (pFile != NULL)
+			fclose(pFile);
+		CfgStoreDestroy(pStore);
+		return -EOUT_OF_MEMORY;
+	}
+
+	if (pFile != NULL) {
+		pStore->textSize = fread(pStore->pText, 1, pStore->textSize, pFile);
+		fclose(pFile);
+	}
+
+	err = parse(pStore);
+	if (err != SUCCESS)
+		CfgStoreDestroy(pStore);
+	return err;
+}
+
+OSC_ERR CfgStoreGetStr(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		const char **pValue)
+{
+	long iEntry = findEntry(pStore, strSection, strTag);
+
+	if (iEntry < 0)
+		return -ECFG_STORE_NO_KEY;
+
+	*pValue = pStore->pEntries[iEntry].value;
+	return SUCCESS;
+}
+
+OSC_ERR CfgStoreGetInt(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		int16 *pValue)
+{
+	long iEntry = findEntry(pStore, strSection, strTag);
+	const struct CFG_STORE_ENTRY *pEntry;
+
+	if (iEntry < 0)
+		return -ECFG_STORE_NO_KEY;
+
+	pEntry = &pStore->pEntries[iEntry];
+	if (!pEntry->bNumber || pEntry->number < -32768 || pEntry->number > 32767)
+		return -ECFG_STORE_WRONG_TYPE;
+
+	*pValue = (int16) pEntry->number;
+	return SUCCESS;
+}
+
+OSC_ERR CfgStoreGetInt32(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		int32 *pValue)
+{
+	long iEntry = findEntry(pStore, strSection, strTag);
+	const struct CFG_STORE_ENTRY *pEntry;
+
+	if (iEntry < 0)
+		return -ECFG_STORE_NO_KEY;
+
+	pEntry = &pStore->pEntries[iEntry];
+	if (!pEntry->bNumber || pEntry->number < -2147483647L - 1 || pEntry->number > 2147483647L)
+		return -ECFG_STORE_WRONG_TYPE;
+
+	*pValue = (int32) pEntry->number;
+	return SUCCESS;
+}
+
+uint32 CfgStoreGetBatch(const struct CFG_STORE *pStore,
+		struct CFG_STORE_QUERY *pQueries,
+		const uint32 nQueries)
+{
+	struct CFG_STORE_QUERY *pQuery;
+	uint32 i, nFound = 0;
+
+	for (i = 0; i < nQueries; i++) {
+		pQuery = &pQueries[i];
+		switch (pQuery->type) {
+		case CFG_STORE_STR:
+			pQuery->err = CfgStoreGetStr(pStore, pQuery->strSection, pQuery->strTag, (const char **) pQuery->pValue);
+			break;
+		case CFG_STORE_INT16:
+			pQuery->err = CfgStoreGetInt(pStore, pQuery->strSection, pQuery->strTag, (int16 *) pQuery->pValue);
+			break;
+		case CFG_STORE_INT32:
+			pQuery->err = CfgStoreGetInt32(pStore, pQuery->strSection, pQuery->strTag, (int32 *) pQuery->pValue);
+			break;
+		default:
+			pQuery->err = -EINVALID_PARAMETER;
+			break;
+		}
+		if (pQuery->err == SUCCESS)
+			nFound++;
+	}
+
+	return nFound;
+}
+
+OSC_ERR CfgStoreSetStr(struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		const char *value)
+{
+	long iEntry = findEntry(pStore, strSection, strTag), iSection = -1;
+	struct CFG_STORE_ENTRY *pEntry;
+	char *pOwned;
+	uint32 i;
+
+	if (strSection == NULL)
+		strSection = "";
+	if (strchr(strTag, ':') != NULL || strchr(strTag, '\n') != NULL ||
+			strchr(value, '\n') != NULL || strchr(strSection, '\n') != NULL ||
+			strchr(strSection, ':') != NULL)
+		return -EINVALID_PARAMETER;
+
+	if (iEntry >= 0 && strcmp(pStore->pEntries[iEntry].value, value) == 0)
+		return SUCCESS;
+
+	/* Tag and value are kept together. */
+	pOwned = malloc(strlen(strTag) + strlen(value) + 2);
+	if (pOwned == NULL)
+		return -EOUT_OF_MEMORY;
+	strcpy(pOwned, strTag);
+	strcpy(pOwned + strlen(strTag) + 1, value);
+
+	if (iEntry >= 0) {
+		pEntry = &pStore->pEntries[iEntry];
+		free(pEntry->pOwned);
+		pEntry->pOwned = pOwned;
+		pEntry->tag = pOwned;
+		pEntry->value = pOwned + strlen(strTag) + 1;
+		parseNumber(pEntry);
+		pStore->pSections[pEntry->iSection].bDirty = TRUE;
+		return SUCCESS;
+	}
+
+	for (i = 0; i < pStore->nSections; i++) {
+		if (strcmp(pStore->pSections[i].name, strSection) == 0) {
+			iSection = i;
+			break;
+		}
+	}
+	if (iSection < 0) {
+		iSection = addSection(pStore, NULL, -1);
+		if (iSection < 0 || (pStore->pSections[iSection].pOwned = malloc(strlen(strSection) + 1)) == NULL) {
+			if (iSection >= 0)
+				pStore->nSections--;
+			free(pOwned);
+			return -EOUT_OF_MEMORY;
+		}
+		strcpy(pStore->pSections[iSection].pOwned, strSection);
+		pStore->pSections[iSection].name = pStore->pSections[iSection].pOwned;
+	}
+
+	iEntry = addEntry(pStore, iSection, pOwned, pOwned + strlen(strTag) + 1, -1, -1);
+	if (iEntry < 0) {
+		free(pOwned);
+		return -EOUT_OF_MEMORY;
+	}
+	pStore->pEntries[iEntry].pOwned = pOwned;
+	pStore->pSections[iSection].bDirty = TRUE;
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Append text to a buffer.
+ *
+ * @param pBuffer Buffer.
+ * @param pText Text.
+ * @param size Number of characters.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR append(struct TEXT_BUFFER *pBuffer, const char *pText, const long size)
+{
+	char *p;
+	long max;
+
+	if (size == 0)
+		return SUCCESS;
+	if (pBuffer->size + size > pBuffer->max) {
+		max = 2 * (pBuffer->size + size) + 256;
+		p = realloc(pBuffer->p, max + 1);
+		if (p == NULL)
+			return -EOUT_OF_MEMORY;
+		pBuffer->p = p;
+		pBuffer->max = max;
+	}
+
+	memcpy(pBuffer->p + pBuffer->size, pText, size);
+	pBuffer->size += size;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Append the text of a changed section to a buffer.
+ *
+ * @param pStore Store.
+ * @param pSection Section.
+ * @param pBuffer Buffer.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR appendSection(const struct CFG_STORE *pStore,
+		const struct CFG_STORE_SECTION *pSection,
+		struct TEXT_BUFFER *pBuffer)
+{
+	const struct CFG_STORE_ENTRY *pEntry;
+	long cursor = pSection->textBegin, iEntry;
+	OSC_ERR err = SUCCESS;
+	int bNewLine;
+
+	if (pSection->textBegin < 0) {
+		/* A new section, separated by an empty line. */
+		if (pBuffer->size > 0 && pBuffer->p[pBuffer->size - 1] != '\n')
+			err = append(pBuffer, "\n", 1);
+		if (err == SUCCESS && pBuffer->size > 0)
+			err = append(pBuffer, "\n", 1);
+		if (err == SUCCESS)
+			err = append(pBuffer, pSection->name, strlen(pSection->name));
+		if (err == SUCCESS)
+			err = append(pBuffer, "\n", 1);
+		cursor = pSection->insertAt;
+	}
+
+	/* Replace the changed values within their lines. */
+	for (iEntry = pSection->iFirst; iEntry >= 0 && err == SUCCESS; iEntry = pEntry->iNext) {
+		pEntry = &pStore->pEntries[iEntry];
+		if (pEntry->valueBegin < 0)
+			continue;
+		err = append(pBuffer, pStore->pText + cursor, pEntry->valueBegin - cursor);
+		if (err == SUCCESS)
+			err = append(pBuffer, pEntry->value, strlen(pEntry->value));
+		cursor = pEntry->valueEnd;
+	}
+	if (err == SUCCESS && pSection->textBegin >= 0)
+		err = append(pBuffer, pStore->pText + cursor, pSection->insertAt - cursor);
+
+	/* Add the new tags after the last tag line. */
+	bNewLine = pBuffer->size == 0 || pBuffer->p[pBuffer->size - 1] == '\n';
+	for (iEntry = pSection->iFirst; iEntry >= 0 && err == SUCCESS; iEntry = pEntry->iNext) {
+		pEntry = &pStore->pEntries[iEntry];
+		if (pEntry->valueBegin >= 0)
+			continue;
+		if (!bNewLine) {
+			err = append(pBuffer, "\n", 1);
+			bNewLine = TRUE;
+		}
+		if (err == SUCCESS)
+			err = append(pBuffer, pEntry->tag, strlen(pEntry->tag));
+		if (err == SUCCESS)
+			err = append(pBuffer, ": ", 2);
+		if (err == SUCCESS)
+			err = append(pBuffer, pEntry->value, strlen(pEntry->value));
+		if (err == SUCCESS)
+			err = append(pBuffer, "\n", 1);
+	}
+
+	if (err == SUCCESS && pSection->textBegin >= 0)
+		err = append(pBuffer, pStore->pText + pSection->insertAt, pSection->textEnd - pSection->insertAt);
+	return err;
+}
+
+OSC_ERR CfgStoreFlush(struct CFG_STORE *pStore)
+{
+	struct TEXT_BUFFER buffer = { NULL, 0, 0 };
+	const struct CFG_STORE_SECTION *pSection;
+	char *tmpName;
+	FILE *pFile;
+	OSC_ERR err = SUCCESS;
+	int bDirty = FALSE;
+	uint32 i;
+
+	for (i = 0; i < pStore->nSections; i++)
+		bDirty |= pStore->pSections[i].bDirty;
+	if (!bDirty)
+		return SUCCESS;
+
+	for (i = 0; i < pStore->nSections && err == SUCCESS; i++) {
+		pSection = &pStore->pSections[i];
+		if (pSection->bDirty)
+			err = appendSection(pStore, pSection, &buffer);
+		else
+			err = append(&buffer, pStore->pText + pSection->textBegin, pSection->textEnd - pSection->textBegin);
+	}
+	if (err != SUCCESS) {
+		free(buffer.p);
+		return err;
+	}
+
+	/* Write a temporary file and put it in place of the config file. */
+	tmpName = malloc(strlen(pStore->fileName) + 2);
+	if (tmpName == NULL) {
+		free(buffer.p);
+		return -EOUT_OF_MEMORY;
+	}
+	sprintf(tmpName, "%s~", pStore->fileName);
+
+	pFile = fopen(tmpName, "w");
+	if (pFile == NULL) {
+		err = -EUNABLE_TO_OPEN_FILE;
+	} else {
+		if (fwrite(buffer.p, 1, buffer.size, pFile) != (size_t) buffer.size ||
+				fflush(pFile) != 0 || fsync(fileno(pFile)) != 0)
+			err = -EFILE_ERROR;
+		if (fclose(pFile) != 0)
+			err = -EFILE_ERROR;
+		if (err == SUCCESS && rename(tmpName, pStore->fileName) != 0)
+			err = -EFILE_ERROR;
+		if (err != SUCCESS)
+			remove(tmpName);
+	}
+	free(tmpName);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to write %s! (%d)\n", __func__, pStore->fileName, err);
+		free(buffer.p);
+		return err;
+	}
+
+	/* Index the new text. */
+	clearIndex(pStore);
+	free(pStore->pText);
+	pStore->pText = buffer.p;
+	pStore->textSize = buffer.size;
+	return parse(pStore);
+}
+
+void CfgStoreDestroy(struct CFG_STORE *pStore)
+{
+	clearIndex(pStore);
+	free(pStore->pSections);
+	free(pStore->pEntries);
+	free(pStore->pBuckets);
+	free(pStore->pText);
+	free(pStore->fileName);
+	memset(pStore, 0, sizeof(struct CFG_STORE));
+}
@@ -0,0 +1,212 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file cfgstore.h
+ * @brief Indexed store of a config file.
+ * The file (see config.txt) is parsed once into a hash table of section
+ * and tag, with integer values converted in advance, so each lookup takes
+ * constant time. Files of any size are read. Flushing rewrites only the
+ * changed sections and replaces the file atomically.
+ */
+
+#ifndef CFGSTORE_H_
+#define CFGSTORE_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Errors of the config store, returned negated. */
+enum EnCfgStoreErrors {
+	ECFG_STORE_NO_KEY = 1000,
+	ECFG_STORE_WRONG_TYPE
+};
+
+/*! @brief Value types of a batch lookup. */
+enum EnCfgStoreType {
+	CFG_STORE_STR,
+	CFG_STORE_INT16,
+	CFG_STORE_INT32
+};
+
+/*! @brief A tag of a section with its value. */
+struct CFG_STORE_ENTRY {
+	/*! @brief Index of the section. */
+	uint32 iSection;
+	/*! @brief Tag and value strings. */
+	const char *tag, *value;
+	/*! @brief Tag and value allocated by a set ("tag\0value"), NULL if
+	 * they are in the parsed text. */
+	char *pOwned;
+	/*! @brief TRUE if the value is an integer, and that integer. */
+	int bNumber;
+	long number;
+	/*! @brief Hash of section and tag. */
+	uint32 hash;
+	/*! @brief Offsets of the value in the file, -1 for a new tag. */
+	long valueBegin, valueEnd;
+	/*! @brief Next entry of the section, -1 for the last one. */
+	long iNext;
+};
+
+/*! @brief A section of the config file. */
+struct CFG_STORE_SECTION {
+	/*! @brief Name, empty for the global section. */
+	const char *name;
+	/*! @brief Name allocated for a new section, NULL otherwise. */
+	char *pOwned;
+	/*! @brief Offsets of the section text in the file and of the end of
+	 * its last tag line, -1 for a new section. */
+	long textBegin, textEnd, insertAt;
+	/*! @brief First and last entry, -1 if there is none. */
+	long iFirst, iLast;
+	/*! @brief TRUE if a value was set since the last flush. */
+	int bDirty;
+};
+
+/*! @brief State of a config store. */
+struct CFG_STORE {
+	/*! @brief Name of the config file. */
+	char *fileName;
+	/*! @brief Text of the file and a copy split into strings. */
+	char *pText, *pStrings;
+	long textSize;
+	/*! @brief Sections, the first one is the global section. */
+	struct CFG_STORE_SECTION *pSections;
+	uint32 nSections, maxSections;
+	/*! @brief Entries of all sections. */
+	struct CFG_STORE_ENTRY *pEntries;
+	uint32 nEntries, maxEntries;
+	/*! @brief Hash table of entry indices, -1 for an empty bucket. */
+	long *pBuckets;
+	uint32 nBuckets;
+};
+
+/*! @brief A lookup of a batch. */
+struct CFG_STORE_QUERY {
+	/*! @brief Section (global if NULL) and tag. */
+	const char *strSection, *strTag;
+	/*! @brief Type of the value. */
+	enum EnCfgStoreType type;
+	/*! @brief Value: const char **, int16 * or int32 *. */
+	void *pValue;
+	/*! @brief Result of the lookup. */
+	OSC_ERR err;
+};
+
+/*********************************************************************//*!
+ * @brief Read and index a config file.
+ *
+ * A missing file gives an empty store, which is created on flushing.
+ *
+ * @param pStore Store to initialize.
+ * @param fileName Name of the config file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreLoad(struct CFG_STORE *pStore, const char *fileName);
+
+/*********************************************************************//*!
+ * @brief Look up a string value.
+ *
+ * @param pStore Store.
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @param pValue Set to the value, which stays valid until the tag is set,
+ * the store is flushed or destroyed.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreGetStr(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		const char **pValue);
+
+/*********************************************************************//*!
+ * @brief Look up a 16 bit integer value.
+ *
+ * @param pStore Store.
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @param pValue Set to the value.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreGetInt(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		int16 *pValue);
+
+/*********************************************************************//*!
+ * @brief Look up a 32 bit integer value.
+ *
+ * @param pStore Store.
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @param pValue Set to the value.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreGetInt32(const struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		int32 *pValue);
+
+/*********************************************************************//*!
+ * @brief Look up a batch of values.
+ *
+ * The result of each lookup is set in its query.
+ *
+ * @param pStore Store.
+ * @param pQueries Lookups.
+ * @param nQueries Number of lookups.
+ * @return Number of successful lookups
+ *//*********************************************************************/
+uint32 CfgStoreGetBatch(const struct CFG_STORE *pStore,
+		struct CFG_STORE_QUERY *pQueries,
+		const uint32 nQueries);
+
+/*********************************************************************//*!
+ * @brief Set a value, adding the section and the tag if needed.
+ *
+ * @param pStore Store.
+ * @param strSection Section, global if NULL.
+ * @param strTag Tag.
+ * @param value Value.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreSetStr(struct CFG_STORE *pStore,
+		const char *strSection,
+		const char *strTag,
+		const char *value);
+
+/*********************************************************************//*!
+ * @brief Write the changed sections to the config file.
+ *
+ * The unchanged sections are copied as they are, changed values are
+ * replaced within their lines and new tags and sections appended. The new
+ * file is written to a temporary file which then replaces the config
+ * file. Nothing is written if nothing changed.
+ *
+ * @param pStore Store.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgStoreFlush(struct CFG_STORE *pStore);
+
+/*********************************************************************//*!
+ * @brief Free a store without flushing it.
+ *
+ * @param pStore Store.
+ *//*********************************************************************/
+void CfgStoreDestroy(struct CFG_STORE *pStore);
+
+#endif /* CFGSTORE_H_ */
@@ -0,0 +1,260 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file cfgwatch.c
+ * @brief Reloading of a config file while the application runs.
+ * Only the watcher thread allocates and frees snapshots. A replaced
+ * snapshot may still be in use by the reader until it takes the new one,
+ * which it acknowledges with the generation it has seen. Until then the
+ * replaced snapshot is kept and a further change waits for publishing.
+ */
+
+#include "cfgwatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#if defined(OSC_HOST)
+/*! @brief Orders the snapshot writes before the pointer swap. */
+#define BARRIER() __sync_synchronize()
+#else
+/*! @brief The Blackfin is a single core, a compiler barrier suffices. */
+#define BARRIER() __asm__ __volatile__ ("" : : : "memory")
+#endif
+
+/*********************************************************************//*!
+ * @brief Parse the config file into a new snapshot.
+ *
+ * @param pWatch Watcher.
+ * @param pPrevious Settings the new ones start from.
+ * @param generation Generation of the new snapshot.
+ * @param ppSnapshot Set to the new snapshot.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR readSnapshot(struct CFG_WATCH *pWatch,
+		const void *pPrevious,
+		const uint32 generation,
+		struct CFG_WATCH_SNAPSHOT **ppSnapshot)
+{
+	struct CFG_WATCH_SNAPSHOT *pSnapshot;
+	struct CFG_STORE store;
+	OSC_ERR err;
+
+	err = CfgStoreLoad(&store, pWatch->fileName);
+	if (err != SUCCESS)
+		return err;
+
+	pSnapshot = malloc(sizeof(struct CFG_WATCH_SNAPSHOT) + pWatch->settingsSize);
+	if (pSnapshot == NULL) {
+		CfgStoreDestroy(&store);
+		return -EOUT_OF_MEMORY;
+	}
+	pSnapshot->generation = generation;
+	pSnapshot->pSettings = pSnapshot + 1;
+	memcpy(pSnapshot->pSettings, pPrevious, pWatch->settingsSize);
+
+	err = pWatch->parse(pWatch->pArg, &store, pSnapshot->pSettings);
+	CfgStoreDestroy(&store);
+	if (err != SUCCESS) {
+		free(pSnapshot);
+		return err;
+	}
+
+	*ppSnapshot = pSnapshot;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Free the replaced snapshot if the reader is done with it.
+ *
+ * @param pWatch Watcher.
+ * @return TRUE if no replaced snapshot is left
+ *//*********************************************************************/
+static int reclaim(struct CFG_WATCH *pWatch)
+{
+	if (pWatch->pRetired == NULL)
+		return TRUE;
+
+	BARRIER();
+	if (pWatch->seenGeneration != pWatch->pCurrent->generation)
+		return FALSE;
+
+	free(pWatch->pRetired);
+	pWatch->pRetired = NULL;
+	return TRUE;
+}
+
+/*********************************************************************//*!
+ * @brief Reload the config file and publish the new snapshot if valid.
+ *
+ * @param pWatch Watcher without a replaced snapshot.
+ *//*********************************************************************/
+static void reload(struct CFG_WATCH *pWatch)
+{
+	struct CFG_WATCH_SNAPSHOT *pCurrent = pWatch->pCurrent, *pSnapshot;
+	OSC_ERR err;
+
+	err = readSnapshot(pWatch, pCurrent->pSettings, pCurrent->generation + 1, &pSnapshot);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Rejected settings of %s, keeping the current ones! (%d)\n",
+				__func__, pWatch->fileName, err);
+		pWatch->nRejected++;
+		return;
+	}
+
+	/* The snapshot is complete before the reader can see it. */
+	BARRIER();
+	pWatch->pRetired = pCurrent;
+	pWatch->pCurrent = pSnapshot;
+	pWatch->nReloads++;
+	printf("Reloaded settings of %s.\n", pWatch->fileName);
+}
+
+/*********************************************************************//*!
+ * @brief Watcher thread: reload the config file when it is written.
+ *
+ * @param pArg Watcher.
+ * @return NULL
+ *//*********************************************************************/
+static void *watcher(void *pArg)
+{
+	struct CFG_WATCH *pWatch = (struct CFG_WATCH *) pArg;
+	struct pollfd pollFd;
+	struct inotify_event *pEvent;
+	/* Room for several events with file names. */
+	char events[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	ssize_t n, i;
+
+	pollFd.fd = pWatch->fdNotify;
+	pollFd.events = POLLIN;
+
+	while (!pWatch->bStop) {
+		if (poll(&pollFd, 1, CFG_WATCH_POLL_MS) > 0) {
+			n = read(pWatch->fdNotify, events, sizeof(events));
+			for (i = 0; i + (ssize_t) sizeof(struct inotify_event) <= n; i += sizeof(struct inotify_event) + pEvent->len) {
+				pEvent = (struct inotify_event *) &events[i];
+				if (pEvent->len > 0 && strcmp(pEvent->name, pWatch->baseName) == 0)
+					pWatch->bPending = TRUE;
+			}
+		}
+
+		/* Publish only once the replaced snapshot is gone. */
+		if (pWatch->bPending && reclaim(pWatch)) {
+			pWatch->bPending = FALSE;
+			reload(pWatch);
+		}
+	}
+
+	return NULL;
+}
+
+OSC_ERR CfgWatchStart(struct CFG_WATCH *pWatch,
+		const char *fileName,
+		const void *pDefaults,
+		const size_t settingsSize,
+		CFG_WATCH_PARSE parse,
+		void *pArg)
+{
+	struct CFG_WATCH_SNAPSHOT *pSnapshot;
+	char *pSlash;
+	OSC_ERR err;
+
+	memset(pWatch, 0, sizeof(struct CFG_WATCH));
+	pWatch->fdNotify = -1;
+	pWatch->settingsSize = settingsSize;
+	pWatch->parse = parse;
+	pWatch->pArg = pArg;
+
+	/* Split the file name into directory and name. */
+	pWatch->fileName = malloc(strlen(fileName) + 1);
+	pWatch->dirName = malloc(strlen(fileName) + 2);
+	if (pWatch->fileName == NULL || pWatch->dirName == NULL) {
+		CfgWatchStop(pWatch);
+		return -EOUT_OF_MEMORY;
+	}
+	strcpy(pWatch->fileName, fileName);
+	pSlash = strrchr(pWatch->fileName, '/');
+	if (pSlash == NULL) {
+		strcpy(pWatch->dirName, ".");
+		pWatch->baseName = pWatch->fileName;
+	} else {
+		strcpy(pWatch->dirName, pWatch->fileName);
+		pWatch->dirName[pSlash - pWatch->fileName + 1] = '\0';
+		pWatch->baseName = pSlash + 1;
+	}
+
+	err = readSnapshot(pWatch, pDefaults, 0, &pSnapshot);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Invalid settings in %s! (%d)\n", __func__, fileName, err);
+		CfgWatchStop(pWatch);
+		return err;
+	}
+	pWatch->pCurrent = pSnapshot;
+
+	pWatch->fdNotify = inotify_init();
+	if (pWatch->fdNotify < 0 ||
+			inotify_add_watch(pWatch->fdNotify, pWatch->dirName, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		fprintf(stderr, "%s: ERROR: Unable to watch %s!\n", __func__, pWatch->dirName);
+		if (pWatch->fdNotify >= 0)
+			close(pWatch->fdNotify);
+		pWatch->fdNotify = -1;
+		CfgWatchStop(pWatch);
+		return -EDEVICE;
+	}
+
+	if (pthread_create(&pWatch->thread, NULL, watcher, pWatch) != 0) {
+		fprintf(stderr, "%s: ERROR: Unable to start watcher thread!\n", __func__);
+		close(pWatch->fdNotify);
+		pWatch->fdNotify = -1;
+		CfgWatchStop(pWatch);
+		return -EDEVICE;
+	}
+
+	return SUCCESS;
+}
+
+const void *CfgWatchAcquire(struct CFG_WATCH *pWatch)
+{
+	struct CFG_WATCH_SNAPSHOT *pSnapshot = pWatch->pCurrent;
+
+	/* The settings are read after the pointer, and the watcher frees the
+	 * replaced snapshot only after seeing the acknowledgement. */
+	BARRIER();
+	pWatch->seenGeneration = pSnapshot->generation;
+	return pSnapshot->pSettings;
+}
+
+void CfgWatchStop(struct CFG_WATCH *pWatch)
+{
+	if (pWatch->fdNotify >= 0) {
+		pWatch->bStop = TRUE;
+		pthread_join(pWatch->thread, NULL);
+		close(pWatch->fdNotify);
+		pWatch->fdNotify = -1;
+	}
+
+	free(pWatch->pRetired);
+	free(pWatch->pCurrent);
+	free(pWatch->fileName);
+	free(pWatch->dirName);
+	memset(pWatch, 0, sizeof(struct CFG_WATCH));
+	pWatch->fdNotify = -1;
+}
@@ -0,0 +1,131 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file cfgwatch.h
+ * @brief Reloading of a config file while the application runs.
+ * A thread waits for the file to be written (inotify), reads it into a
+ * config store and lets the application parse and validate it into a new
+ * settings snapshot. A valid snapshot is published by swapping a pointer;
+ * the frame loop picks it up between frames without taking a lock. The
+ * snapshots are never changed once published.
+ */
+
+#ifndef CFGWATCH_H_
+#define CFGWATCH_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "cfgstore.h"
+#include <pthread.h>
+#include <stddef.h>
+
+/*! @brief Interval in ms at which the thread checks for a stop request
+ * and for a pending snapshot to publish. */
+#define CFG_WATCH_POLL_MS 200
+
+/*********************************************************************//*!
+ * @brief Parse and validate the settings of a config file.
+ *
+ * Called by the watcher thread, not by the frame loop.
+ *
+ * @param pArg Argument passed to CfgWatchStart.
+ * @param pStore Store of the config file.
+ * @param pSettings Settings to fill in, they hold the current settings
+ * (the defaults on the first call), so missing tags keep their values.
+ * @return SUCCESS if the settings are valid, an error code rejects them
+ *//*********************************************************************/
+typedef OSC_ERR (*CFG_WATCH_PARSE)(void *pArg,
+		const struct CFG_STORE *pStore,
+		void *pSettings);
+
+/*! @brief A published settings snapshot, followed by the settings. */
+struct CFG_WATCH_SNAPSHOT {
+	/*! @brief Number of the snapshot, counting from 0. */
+	uint32 generation;
+	/*! @brief The settings, right after the snapshot in memory. */
+	void *pSettings;
+};
+
+/*! @brief State of a config watcher. */
+struct CFG_WATCH {
+	/*! @brief Config file, its directory and its name within it. */
+	char *fileName, *dirName;
+	const char *baseName;
+	/*! @brief Size of the settings. */
+	size_t settingsSize;
+	/*! @brief Parser of the settings and its argument. */
+	CFG_WATCH_PARSE parse;
+	void *pArg;
+	/*! @brief The published snapshot. */
+	struct CFG_WATCH_SNAPSHOT * volatile pCurrent;
+	/*! @brief The snapshot replaced last, freed once the reader has taken
+	 * the current one. */
+	struct CFG_WATCH_SNAPSHOT *pRetired;
+	/*! @brief Generation of the snapshot the reader has taken last. */
+	volatile uint32 seenGeneration;
+	/*! @brief inotify instance, -1 if the file is not watched. */
+	int fdNotify;
+	/*! @brief TRUE if the file changed since the last reload. */
+	int bPending;
+	/*! @brief Watcher thread and its stop request. */
+	pthread_t thread;
+	volatile int bStop;
+	/*! @brief Number of published and rejected reloads. */
+	uint32 nReloads, nRejected;
+};
+
+/*********************************************************************//*!
+ * @brief Read the settings and start watching the config file.
+ *
+ * The first snapshot is parsed from the file right away; a missing file
+ * gives the defaults. Changes are watched on the directory, so that a
+ * file replaced by renaming (see CfgStoreFlush) is noticed as well.
+ *
+ * @param pWatch Watcher to initialize.
+ * @param fileName Config file.
+ * @param pDefaults Default settings.
+ * @param settingsSize Size of the settings.
+ * @param parse Parser of the settings.
+ * @param pArg Argument passed to the parser.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR CfgWatchStart(struct CFG_WATCH *pWatch,
+		const char *fileName,
+		const void *pDefaults,
+		const size_t settingsSize,
+		CFG_WATCH_PARSE parse,
+		void *pArg);
+
+/*********************************************************************//*!
+ * @brief Take the latest settings.
+ *
+ * Lock free, to be called between frames by a single reader thread. The
+ * settings taken before stay valid until the next call.
+ *
+ * @param pWatch Watcher.
+ * @return The settings, never changed
+ *//*********************************************************************/
+const void *CfgWatchAcquire(struct CFG_WATCH *pWatch);
+
+/*********************************************************************//*!
+ * @brief Stop watching and free the snapshots.
+ *
+ * @param pWatch Watcher.
+ *//*********************************************************************/
+void CfgWatchStop(struct CFG_WATCH *pWatch);
+
+#endif /* CFGWATCH_H_ */
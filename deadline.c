@@ -0,0 +1,175 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file deadline.c
+ * @brief Frame deadline monitor with graceful degradation.
+ * Recovering needs a margin of a quarter of the budget, so that undoing a
+ * step does not push the loop right back over the budget.
+ */
+
+#include "deadline.h"
+#include <stdio.h>
+#include <string.h>
+
+/*! @brief Cycles used to get the cycle frequency. */
+#define DEADLINE_CALIBRATION_CYCLES 100000000UL
+
+/*********************************************************************//*!
+ * @brief Convert microseconds to cycles.
+ *
+ * @param microSecs Microseconds.
+ * @return Cycles
+ *//*********************************************************************/
+static unsigned long long cyclesOf(const uint32 microSecs)
+{
+	return (unsigned long long) microSecs * DEADLINE_CALIBRATION_CYCLES /
+			OscSupCycToMicroSecs(DEADLINE_CALIBRATION_CYCLES);
+}
+
+OSC_ERR DeadlineInit(struct DEADLINE *pDeadline,
+		struct PROF *pProf,
+		const uint32 budgetMicroSecs,
+		const uint32 maxPeriodMicroSecs,
+		const uint16 overrunFrames,
+		const uint16 recoverFrames)
+{
+	if (budgetMicroSecs == 0 || overrunFrames == 0 || recoverFrames == 0)
+		return -EINVALID_PARAMETER;
+
+	memset(pDeadline, 0, sizeof(struct DEADLINE));
+	pDeadline->pProf = pProf;
+	pDeadline->budgetCycles = cyclesOf(budgetMicroSecs);
+	pDeadline->maxPeriodCycles = cyclesOf(maxPeriodMicroSecs);
+	pDeadline->overrunFrames = overrunFrames;
+	pDeadline->recoverFrames = recoverFrames;
+
+	return SUCCESS;
+}
+
+OSC_ERR DeadlineAddStep(struct DEADLINE *pDeadline,
+		const char *name,
+		DEADLINE_ACTION action,
+		void *pArg)
+{
+	struct DEADLINE_STEP *pStep;
+
+	if (pDeadline->nSteps == DEADLINE_MAX_STEPS)
+		return -EINVALID_PARAMETER;
+
+	pStep = &pDeadline->steps[pDeadline->nSteps++];
+	pStep->name = name;
+	pStep->action = action;
+	pStep->pArg = pArg;
+
+	return SUCCESS;
+}
+
+OSC_ERR DeadlineStartWatchdog(struct DEADLINE *pDeadline)
+{
+	OSC_ERR err;
+
+	err = OscSupWdtInit();
+	if (err != SUCCESS)
+		return err;
+
+	pDeadline->bWatchdog = TRUE;
+	return SUCCESS;
+}
+
+void DeadlineBegin(struct DEADLINE *pDeadline)
+{
+	pDeadline->beginCycles = ProfCycles(pDeadline->pProf);
+}
+
+void DeadlineEnd(struct DEADLINE *pDeadline)
+{
+	unsigned long long now = ProfCycles(pDeadline->pProf);
+	unsigned long long cycles = now - pDeadline->beginCycles;
+	unsigned long long period = now - pDeadline->endCycles;
+	struct DEADLINE_STEP *pStep;
+
+	pDeadline->nFrames++;
+	if (cycles > pDeadline->maxCycles)
+		pDeadline->maxCycles = cycles;
+
+	if (cycles > pDeadline->budgetCycles) {
+		pDeadline->nOverruns++;
+		pDeadline->overrunRun++;
+		pDeadline->recoverRun = 0;
+	} else {
+		pDeadline->overrunRun = 0;
+		if (cycles <= pDeadline->budgetCycles - pDeadline->budgetCycles / 4)
+			pDeadline->recoverRun++;
+		else
+			pDeadline->recoverRun = 0;
+	}
+
+	if (pDeadline->overrunRun >= pDeadline->overrunFrames &&
+			pDeadline->level < pDeadline->nSteps) {
+		pStep = &pDeadline->steps[pDeadline->level++];
+		pStep->action(pStep->pArg, TRUE);
+		pDeadline->overrunRun = 0;
+		printf("Deadline: %u frames over budget, degrading: %s\n",
+				pDeadline->overrunFrames, pStep->name);
+	} else if (pDeadline->recoverRun >= pDeadline->recoverFrames &&
+			pDeadline->level > 0) {
+		pStep = &pDeadline->steps[--pDeadline->level];
+		pStep->action(pStep->pArg, FALSE);
+		pDeadline->recoverRun = 0;
+		printf("Deadline: %u frames within budget, recovering: %s\n",
+				pDeadline->recoverFrames, pStep->name);
+	}
+
+	/* The first frame has no period. A loop too slow for the minimum rate
+	 * lets the watchdog expire. */
+	if (pDeadline->endCycles == 0 || period <= pDeadline->maxPeriodCycles) {
+		if (pDeadline->bWatchdog)
+			OscSupWdtKeepAlive();
+	} else {
+		pDeadline->nSlowFrames++;
+	}
+	pDeadline->endCycles = now;
+}
+
+void DeadlinePrintStats(struct DEADLINE *pDeadline)
+{
+	printf("Deadline: %lu frames, %lu over budget, %lu below minimum rate, max %llu us, level %u of %u\n",
+			(unsigned long) pDeadline->nFrames, (unsigned long) pDeadline->nOverruns,
+			(unsigned long) pDeadline->nSlowFrames, ProfMicroSecs(pDeadline->maxCycles),
+			pDeadline->level, pDeadline->nSteps);
+
+	pDeadline->nFrames = 0;
+	pDeadline->nOverruns = 0;
+	pDeadline->nSlowFrames = 0;
+	pDeadline->maxCycles = 0;
+}
+
+void DeadlineDestroy(struct DEADLINE *pDeadline)
+{
+	struct DEADLINE_STEP *pStep;
+
+	if (pDeadline->bWatchdog) {
+		OscSupWdtClose();
+		pDeadline->bWatchdog = FALSE;
+	}
+
+	while (pDeadline->level > 0) {
+		pStep = &pDeadline->steps[--pDeadline->level];
+		pStep->action(pStep->pArg, FALSE);
+	}
+}
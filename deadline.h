@@ -0,0 +1,156 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file deadline.h
+ * @brief Frame deadline monitor with graceful degradation.
+ * The time a loop spends on each frame is checked against a budget. After
+ * a number of overruns in a row, the next registered degradation step is
+ * taken; after enough frames well within the budget, the last step is
+ * undone. The watchdog is only kept alive while the loop keeps a minimum
+ * frame rate, so a loop that is alive but too slow is reset as well.
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "prof.h"
+
+/*! @brief Maximum number of degradation steps. */
+#define DEADLINE_MAX_STEPS 8
+
+/*********************************************************************//*!
+ * @brief Take or undo a degradation step.
+ *
+ * @param pArg Argument given with the step.
+ * @param bDegrade TRUE to take the step, FALSE to undo it.
+ *//*********************************************************************/
+typedef void (*DEADLINE_ACTION)(void *pArg, const int bDegrade);
+
+/*! @brief A degradation step. */
+struct DEADLINE_STEP {
+	/*! @brief Name of the step, for the log. */
+	const char *name;
+	/*! @brief Action and its argument. */
+	DEADLINE_ACTION action;
+	void *pArg;
+};
+
+/*! @brief State of a deadline monitor. */
+struct DEADLINE {
+	/*! @brief Profile providing the 64 bit cycle count. */
+	struct PROF *pProf;
+	/*! @brief Cycles budgeted per frame and the longest frame period at
+	 * which the watchdog is kept alive. */
+	unsigned long long budgetCycles, maxPeriodCycles;
+	/*! @brief Overruns in a row before degrading, frames within three
+	 * quarters of the budget in a row before recovering. */
+	uint16 overrunFrames, recoverFrames;
+	/*! @brief Degradation steps, the first level ones are taken. */
+	struct DEADLINE_STEP steps[DEADLINE_MAX_STEPS];
+	uint8 nSteps, level;
+	/*! @brief TRUE if the watchdog is started. */
+	int bWatchdog;
+	/*! @brief Cycle counts of the start of the frame and the end of the
+	 * last one. */
+	unsigned long long beginCycles, endCycles;
+	/*! @brief Current runs of overruns and of frames within the budget. */
+	uint16 overrunRun, recoverRun;
+	/*! @brief Statistics. */
+	uint32 nFrames, nOverruns, nSlowFrames;
+	unsigned long long maxCycles;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize a deadline monitor without degradation steps.
+ *
+ * @param pDeadline Monitor to initialize.
+ * @param pProf Initialized profile providing the cycle count.
+ * @param budgetMicroSecs Time budgeted per frame.
+ * @param maxPeriodMicroSecs Longest frame period at which the watchdog is
+ * kept alive.
+ * @param overrunFrames Overruns in a row before degrading (>= 1).
+ * @param recoverFrames Frames within three quarters of the budget in a
+ * row before undoing a step (>= 1).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DeadlineInit(struct DEADLINE *pDeadline,
+		struct PROF *pProf,
+		const uint32 budgetMicroSecs,
+		const uint32 maxPeriodMicroSecs,
+		const uint16 overrunFrames,
+		const uint16 recoverFrames);
+
+/*********************************************************************//*!
+ * @brief Register the next degradation step.
+ *
+ * Steps are taken in the order of registration and undone in reverse.
+ *
+ * @param pDeadline Monitor.
+ * @param name Name of the step, must stay valid.
+ * @param action Action taking and undoing the step.
+ * @param pArg Argument passed to the action.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DeadlineAddStep(struct DEADLINE *pDeadline,
+		const char *name,
+		DEADLINE_ACTION action,
+		void *pArg);
+
+/*********************************************************************//*!
+ * @brief Start the watchdog, kept alive by DeadlineEnd from now on.
+ *
+ * Requires the sup module to be loaded.
+ *
+ * @param pDeadline Monitor.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DeadlineStartWatchdog(struct DEADLINE *pDeadline);
+
+/*********************************************************************//*!
+ * @brief Mark the start of the work on a frame.
+ *
+ * @param pDeadline Monitor.
+ *//*********************************************************************/
+void DeadlineBegin(struct DEADLINE *pDeadline);
+
+/*********************************************************************//*!
+ * @brief Mark the end of the work on a frame.
+ *
+ * Checks the budget, takes or undoes a degradation step and keeps the
+ * watchdog alive if the frame period is short enough.
+ *
+ * @param pDeadline Monitor.
+ *//*********************************************************************/
+void DeadlineEnd(struct DEADLINE *pDeadline);
+
+/*********************************************************************//*!
+ * @brief Print the statistics and reset them.
+ *
+ * @param pDeadline Monitor.
+ *//*********************************************************************/
+void DeadlinePrintStats(struct DEADLINE *pDeadline);
+
+/*********************************************************************//*!
+ * @brief Stop the watchdog and undo all degradation steps.
+ *
+ * @param pDeadline Monitor.
+ *//*********************************************************************/
+void DeadlineDestroy(struct DEADLINE *pDeadline);
+
+#endif /* DEADLINE_H_ */
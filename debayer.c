@@ -0,0 +1,425 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file debayer.c
+ * @brief Strip wise debayering of raw camera frames.
+ * Every raw row contains one colour besides green, so the full resolution
+ * kernel handles a row as pairs of a red or blue and a green pixel, each
+ * with a fixed set of neighbours. Only the pixels at the left and right
+ * border of the frame need mirrored neighbours and take the slow path.
+ * The luma kernels weight the same neighbours directly, skipping the
+ * rounding of the interpolated colours.
+ */
+
+#include "debayer.h"
+#include <string.h>
+
+/*! @brief Luma weights of red, green and blue (ITU-R BT.601, sum 256). */
+#define LUMA_RED 77
+#define LUMA_GREEN 150
+#define LUMA_BLUE 29
+
+OSC_ERR DebayerInit(struct DEBAYER *pDebayer,
+		const uint16 width,
+		const uint16 height,
+		const enum EnBayerOrder enBayerOrder,
+		const int bHalf)
+{
+	if (width < 2 || height < 2)
+		return -EINVALID_PARAMETER;
+
+	memset(pDebayer, 0, sizeof(struct DEBAYER));
+	pDebayer->width = width;
+	pDebayer->height = height;
+	pDebayer->bHalf = bHalf;
+
+	switch (enBayerOrder) {
+	case ROW_BGBG:
+		pDebayer->redX = 1;
+		pDebayer->redY = 1;
+		break;
+	case ROW_GBGB:
+		pDebayer->redX = 0;
+		pDebayer->redY = 1;
+		break;
+	case ROW_RGRG:
+		pDebayer->redX = 0;
+		pDebayer->redY = 0;
+		break;
+	case ROW_GRGR:
+		pDebayer->redX = 1;
+		pDebayer->redY = 0;
+		break;
+	default:
+		return -EINVALID_PARAMETER;
+	}
+
+	return DebayerSetRoi(pDebayer, 0, 0, width, height);
+}
+
+OSC_ERR DebayerSetRoi(struct DEBAYER *pDebayer,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height)
+{
+	uint16 minSize = pDebayer->bHalf ? 2 : 1;
+
+	if (width < minSize || height < minSize ||
+			(uint32) x + width > pDebayer->width ||
+			(uint32) y + height > pDebayer->height) {
+		return -EINVALID_PARAMETER;
+	}
+
+	pDebayer->roiX = x;
+	pDebayer->roiY = y;
+	pDebayer->roiWidth = width;
+	pDebayer->roiHeight = height;
+	if (pDebayer->bHalf) {
+		pDebayer->outWidth = width / 2;
+		pDebayer->outHeight = height / 2;
+	} else {
+		pDebayer->outWidth = width;
+		pDebayer->outHeight = height;
+	}
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Interpolate a single pixel, mirroring neighbours at the border.
+ *
+ * @param pUp Raw row above.
+ * @param pRow Raw row.
+ * @param pDown Raw row below.
+ * @param width Raw frame width.
+ * @param x Column of the pixel.
+ * @param colourX Column parity of the red or blue pixels of the row.
+ * @param iColour Offset of the colour of those pixels in a BGR pixel.
+ * @param pOut BGR output pixel.
+ *//*********************************************************************/
+static void pixelFull(const uint8 *pUp,
+		const uint8 *pRow,
+		const uint8 *pDown,
+		const uint16 width,
+		const uint16 x,
+		const uint8 colourX,
+		const uint8 iColour,
+		uint8 *pOut)
+{
+	uint16 xl = x > 0 ? x - 1 : x + 1;
+	uint16 xr = x + 1 < width ? x + 1 : x - 1;
+
+	if (((x ^ colourX) & 1) == 0) {
+		pOut[iColour] = pRow[x];
+		pOut[1] = (pRow[xl] + pRow[xr] + pUp[x] + pDown[x] + 2) >> 2;
+		pOut[2 - iColour] = (pUp[xl] + pUp[xr] + pDown[xl] + pDown[xr] + 2) >> 2;
+	} else {
+		pOut[iColour] = (pRow[xl] + pRow[xr] + 1) >> 1;
+		pOut[1] = pRow[x];
+		pOut[2 - iColour] = (pUp[x] + pDown[x] + 1) >> 1;
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Debayer a row of the region of interest at full resolution.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param y Raw row.
+ * @param pOut BGR output row.
+ *//*********************************************************************/
+static void rowFull(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		const uint16 y,
+		uint8 *pOut)
+{
+	const uint16 width = pDebayer->width;
+	const uint8 *pRow = pRaw + (uint32) y * width;
+	const uint8 *pUp, *pDown;
+	uint8 *pColour, *pOther;
+	uint16 x = pDebayer->roiX, xEnd = pDebayer->roiX + pDebayer->roiWidth;
+	uint16 xFast = xEnd < width - 1 ? xEnd : width - 1;
+	uint8 colourX, iColour;
+
+	/* Mirror the rows at the top and bottom border. */
+	pUp = y > 0 ? pRow - width : pRow + width;
+	pDown = y + 1 < pDebayer->height ? pRow + width : pRow - width;
+
+	/* Red or blue row. */
+	if (((y ^ pDebayer->redY) & 1) == 0) {
+		colourX = pDebayer->redX;
+		iColour = 2;
+	} else {
+		colourX = pDebayer->redX ^ 1;
+		iColour = 0;
+	}
+
+	/* Left border and a leading green pixel. */
+	while (x < xEnd && (x == 0 || ((x ^ colourX) & 1) != 0)) {
+		pixelFull(pUp, pRow, pDown, width, x, colourX, iColour, pOut);
+		pOut += 3;
+		x++;
+	}
+
+	/* Pairs of a red or blue and a green pixel. */
+	pColour = pOut + iColour;
+	pOther = pOut + 2 - iColour;
+	for (; x + 2 <= xFast; x += 2) {
+		pColour[0] = pRow[x];
+		pOut[1] = (pRow[x - 1] + pRow[x + 1] + pUp[x] + pDown[x] + 2) >> 2;
+		pOther[0] = (pUp[x - 1] + pUp[x + 1] + pDown[x - 1] + pDown[x + 1] + 2) >> 2;
+
+		pColour[3] = (pRow[x] + pRow[x + 2] + 1) >> 1;
+		pOut[4] = pRow[x + 1];
+		pOther[3] = (pUp[x + 1] + pDown[x + 1] + 1) >> 1;
+
+		pOut += 6;
+		pColour += 6;
+		pOther += 6;
+	}
+
+	/* Right border and a trailing red or blue pixel. */
+	for (; x < xEnd; x++) {
+		pixelFull(pUp, pRow, pDown, width, x, colourX, iColour, pOut);
+		pOut += 3;
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Debayer a row of Bayer quads of the region of interest.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param y Upper raw row of the quads.
+ * @param pOut BGR output row.
+ *//*********************************************************************/
+static void rowHalf(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		const uint16 y,
+		uint8 *pOut)
+{
+	const uint8 *pTop = pRaw + (uint32) y * pDebayer->width + pDebayer->roiX;
+	const uint8 *pBottom = pTop + pDebayer->width;
+	const uint8 *pRed, *pBlue, *pGreen1, *pGreen2;
+	uint8 redX = (pDebayer->redX ^ pDebayer->roiX) & 1;
+	uint16 i, n = pDebayer->outWidth;
+
+	/* Position of the colours within the quads. */
+	if (((pDebayer->redY ^ y) & 1) == 0) {
+		pRed = pTop + redX;
+		pGreen1 = pTop + (redX ^ 1);
+		pGreen2 = pBottom + redX;
+		pBlue = pBottom + (redX ^ 1);
+	} else {
+		pRed = pBottom + redX;
+		pGreen1 = pBottom + (redX ^ 1);
+		pGreen2 = pTop + redX;
+		pBlue = pTop + (redX ^ 1);
+	}
+
+	for (i = 0; i < n; i++) {
+		pOut[0] = pBlue[2 * i];
+		pOut[1] = (pGreen1[2 * i] + pGreen2[2 * i] + 1) >> 1;
+		pOut[2] = pRed[2 * i];
+		pOut += 3;
+	}
+}
+
+OSC_ERR DebayerRun(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		uint8 *pOut,
+		const uint16 stripRows,
+		DEBAYER_SINK sink,
+		void *pArg)
+{
+	uint32 rowSize = (uint32) pDebayer->outWidth * 3;
+	uint16 y, i, nRows;
+	uint8 *pStrip;
+	OSC_ERR err;
+
+	if (stripRows == 0)
+		return -EINVALID_PARAMETER;
+
+	for (y = 0; y < pDebayer->outHeight; y += nRows) {
+		nRows = pDebayer->outHeight - y;
+		if (nRows > stripRows)
+			nRows = stripRows;
+
+		/* Without a sink, the strips are placed in the output picture. */
+		pStrip = sink == NULL ? pOut + y * rowSize : pOut;
+
+		for (i = 0; i < nRows; i++) {
+			if (pDebayer->bHalf)
+				rowHalf(pDebayer, pRaw, pDebayer->roiY + 2 * (y + i), pStrip + i * rowSize);
+			else
+				rowFull(pDebayer, pRaw, pDebayer->roiY + y + i, pStrip + i * rowSize);
+		}
+
+		if (sink != NULL) {
+			err = sink(pArg, y, nRows, pStrip);
+			if (err != SUCCESS)
+				return err;
+		}
+	}
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Luma of a single pixel, mirroring neighbours at the border.
+ *
+ * @param pUp Raw row above.
+ * @param pRow Raw row.
+ * @param pDown Raw row below.
+ * @param width Raw frame width.
+ * @param x Column of the pixel.
+ * @param colourX Column parity of the red or blue pixels of the row.
+ * @param wColour Luma weight of the colour of those pixels.
+ * @param wOther Luma weight of the colour of the rows above and below.
+ * @return Luma of the pixel
+ *//*********************************************************************/
+static uint8 lumaFull(const uint8 *pUp,
+		const uint8 *pRow,
+		const uint8 *pDown,
+		const uint16 width,
+		const uint16 x,
+		const uint8 colourX,
+		const uint32 wColour,
+		const uint32 wOther)
+{
+	uint16 xl = x > 0 ? x - 1 : x + 1;
+	uint16 xr = x + 1 < width ? x + 1 : x - 1;
+
+	if (((x ^ colourX) & 1) == 0) {
+		return (4 * wColour * pRow[x] +
+				LUMA_GREEN * (pRow[xl] + pRow[xr] + pUp[x] + pDown[x]) +
+				wOther * (pUp[xl] + pUp[xr] + pDown[xl] + pDown[xr]) + 512) >> 10;
+	} else {
+		return (2 * wColour * (pRow[xl] + pRow[xr]) +
+				4 * LUMA_GREEN * pRow[x] +
+				2 * wOther * (pUp[x] + pDown[x]) + 512) >> 10;
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Convert a row of the region of interest to luma at full
+ * resolution.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param y Raw row.
+ * @param pLuma Luma output row.
+ *//*********************************************************************/
+static void rowLumaFull(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		const uint16 y,
+		uint8 *pLuma)
+{
+	const uint16 width = pDebayer->width;
+	const uint8 *pRow = pRaw + (uint32) y * width;
+	const uint8 *pUp, *pDown;
+	uint16 x = pDebayer->roiX, xEnd = pDebayer->roiX + pDebayer->roiWidth;
+	uint16 xFast = xEnd < width - 1 ? xEnd : width - 1;
+	uint32 wColour, wOther;
+	uint8 colourX;
+
+	pUp = y > 0 ? pRow - width : pRow + width;
+	pDown = y + 1 < pDebayer->height ? pRow + width : pRow - width;
+
+	if (((y ^ pDebayer->redY) & 1) == 0) {
+		colourX = pDebayer->redX;
+		wColour = LUMA_RED;
+		wOther = LUMA_BLUE;
+	} else {
+		colourX = pDebayer->redX ^ 1;
+		wColour = LUMA_BLUE;
+		wOther = LUMA_RED;
+	}
+
+	while (x < xEnd && (x == 0 || ((x ^ colourX) & 1) != 0)) {
+		*pLuma++ = lumaFull(pUp, pRow, pDown, width, x, colourX, wColour, wOther);
+		x++;
+	}
+
+	for (; x + 2 <= xFast; x += 2) {
+		pLuma[0] = (4 * wColour * pRow[x] +
+				LUMA_GREEN * (pRow[x - 1] + pRow[x + 1] + pUp[x] + pDown[x]) +
+				wOther * (pUp[x - 1] + pUp[x + 1] + pDown[x - 1] + pDown[x + 1]) + 512) >> 10;
+		pLuma[1] = (2 * wColour * (pRow[x] + pRow[x + 2]) +
+				4 * LUMA_GREEN * pRow[x + 1] +
+				2 * wOther * (pUp[x + 1] + pDown[x + 1]) + 512) >> 10;
+		pLuma += 2;
+	}
+
+	for (; x < xEnd; x++)
+		*pLuma++ = lumaFull(pUp, pRow, pDown, width, x, colourX, wColour, wOther);
+}
+
+/*********************************************************************//*!
+ * @brief Convert a row of Bayer quads of the region of interest to luma.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param y Upper raw row of the quads.
+ * @param pLuma Luma output row.
+ *//*********************************************************************/
+static void rowLumaHalf(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		const uint16 y,
+		uint8 *pLuma)
+{
+	const uint8 *pTop = pRaw + (uint32) y * pDebayer->width + pDebayer->roiX;
+	const uint8 *pBottom = pTop + pDebayer->width;
+	const uint8 *pRed, *pBlue, *pGreen1, *pGreen2;
+	uint8 redX = (pDebayer->redX ^ pDebayer->roiX) & 1;
+	uint16 i, n = pDebayer->outWidth;
+
+	if (((pDebayer->redY ^ y) & 1) == 0) {
+		pRed = pTop + redX;
+		pGreen1 = pTop + (redX ^ 1);
+		pGreen2 = pBottom + redX;
+		pBlue = pBottom + (redX ^ 1);
+	} else {
+		pRed = pBottom + redX;
+		pGreen1 = pBottom + (redX ^ 1);
+		pGreen2 = pTop + redX;
+		pBlue = pTop + (redX ^ 1);
+	}
+
+	for (i = 0; i < n; i++) {
+		pLuma[i] = (2 * LUMA_RED * pRed[2 * i] +
+				LUMA_GREEN * (pGreen1[2 * i] + pGreen2[2 * i]) +
+				2 * LUMA_BLUE * pBlue[2 * i] + 256) >> 9;
+	}
+}
+
+void DebayerLuma(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		uint8 *pLuma)
+{
+	uint16 y;
+
+	for (y = 0; y < pDebayer->outHeight; y++) {
+		if (pDebayer->bHalf)
+			rowLumaHalf(pDebayer, pRaw, pDebayer->roiY + 2 * y, pLuma);
+		else
+			rowLumaFull(pDebayer, pRaw, pDebayer->roiY + y, pLuma);
+		pLuma += pDebayer->outWidth;
+	}
+}
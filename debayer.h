@@ -0,0 +1,139 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file debayer.h
+ * @brief Strip wise debayering of raw camera frames.
+ * A region of interest of the raw frame is converted to a BGR picture,
+ * either at full resolution (bilinear interpolation) or at half resolution
+ * (one pixel per 2x2 Bayer quad). The output is produced in strips of a few
+ * rows, which can be handed to a consumer while they are still in the data
+ * cache instead of filling a full frame buffer first. For greyscale
+ * processing, a luma plane can be produced directly.
+ */
+
+#ifndef DEBAYER_H_
+#define DEBAYER_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Default number of rows per strip; a full width strip of BGR
+ * pixels fits into the L1 data cache of the Blackfin. */
+#define DEBAYER_STRIP_ROWS 8
+
+/*********************************************************************//*!
+ * @brief Consumer of debayered strips.
+ *
+ * @param pArg Argument passed to DebayerRun.
+ * @param y First output row of the strip.
+ * @param nRows Number of rows in the strip.
+ * @param pStrip BGR pixels of the strip, without padding.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+typedef OSC_ERR (*DEBAYER_SINK)(void *pArg,
+		const uint16 y,
+		const uint16 nRows,
+		const uint8 *pStrip);
+
+/*! @brief Debayering configuration. */
+struct DEBAYER {
+	/*! @brief Dimensions of the raw frame. */
+	uint16 width, height;
+	/*! @brief Column and row of the red pixels in the raw frame (0 or 1). */
+	uint8 redX, redY;
+	/*! @brief TRUE for one output pixel per 2x2 Bayer quad. */
+	int bHalf;
+	/*! @brief Region of interest in raw frame coordinates. */
+	uint16 roiX, roiY, roiWidth, roiHeight;
+	/*! @brief Dimensions of the output picture. */
+	uint16 outWidth, outHeight;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize debayering of a whole frame.
+ *
+ * @param pDebayer Configuration to initialize.
+ * @param width Raw frame width.
+ * @param height Raw frame height.
+ * @param enBayerOrder Order of the top left pixels of the raw frame, as
+ * returned by OscCamGetBayerOrder.
+ * @param bHalf TRUE for half resolution output.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DebayerInit(struct DEBAYER *pDebayer,
+		const uint16 width,
+		const uint16 height,
+		const enum EnBayerOrder enBayerOrder,
+		const int bHalf);
+
+/*********************************************************************//*!
+ * @brief Restrict debayering to a region of interest.
+ *
+ * In half resolution mode, the width and height are rounded down to
+ * whole Bayer quads.
+ *
+ * @param pDebayer Initialized configuration.
+ * @param x Left column of the region.
+ * @param y Top row of the region.
+ * @param width Region width.
+ * @param height Region height.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DebayerSetRoi(struct DEBAYER *pDebayer,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height);
+
+/*********************************************************************//*!
+ * @brief Debayer the region of interest of a raw frame.
+ *
+ * Without a sink, pOut receives the whole output picture of
+ * outWidth * outHeight BGR pixels. With a sink, pOut is a strip buffer of
+ * outWidth * stripRows BGR pixels, which is passed to the sink each time
+ * it is filled.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param pOut Output picture or strip buffer.
+ * @param stripRows Number of rows per strip (e.g. DEBAYER_STRIP_ROWS).
+ * @param sink Consumer of the strips (may be NULL).
+ * @param pArg Argument passed to the sink.
+ * @return SUCCESS or the first error returned by the sink
+ *//*********************************************************************/
+OSC_ERR DebayerRun(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		uint8 *pOut,
+		const uint16 stripRows,
+		DEBAYER_SINK sink,
+		void *pArg);
+
+/*********************************************************************//*!
+ * @brief Convert the region of interest of a raw frame to luma.
+ *
+ * The colours are interpolated as by DebayerRun and reduced to luma
+ * (ITU-R BT.601 weights) in the same pass, so no BGR picture is stored.
+ *
+ * @param pDebayer Configuration.
+ * @param pRaw Raw frame.
+ * @param pLuma Luma plane of outWidth * outHeight bytes.
+ *//*********************************************************************/
+void DebayerLuma(const struct DEBAYER *pDebayer,
+		const uint8 *pRaw,
+		uint8 *pLuma);
+
+#endif /* DEBAYER_H_ */
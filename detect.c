@@ -0,0 +1,157 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file detect.c
+ * @brief Intruder detection engine.
+ * While the alarm lasts, the frames with motion are learned into the
+ * background as well, so that whatever an intruder leaves in the picture
+ * becomes background. The history is rebuilt from the frames after the
+ * intruder.
+ */
+
+#include "detect.h"
+#include <string.h>
+
+void DetectDefaults(struct DETECT_SETTINGS *pSettings, const uint16 width, const uint16 height)
+{
+	pSettings->threshold = DETECT_THRESHOLD;
+	pSettings->lightingSigmas = DETECT_LIGHTING_SIGMAS;
+	pSettings->historyLength = DETECT_HISTORY_LENGTH;
+	pSettings->pixelThreshold = DETECT_PIXEL_THRESHOLD;
+	pSettings->motionPixels = (uint32) width * height / DETECT_MOTION_PIXELS_DIVISOR;
+	pSettings->lightingPixels = (uint32) width * height / DETECT_LIGHTING_PIXELS_DIVISOR;
+	pSettings->cooldownFrames = DETECT_COOLDOWN_FRAMES;
+	pSettings->learnShift = DETECT_LEARN_SHIFT;
+	pSettings->learnInterleave = DETECT_LEARN_INTERLEAVE;
+}
+
+OSC_ERR DetectorInit(struct DETECTOR *pDet,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBackground,
+		uint8 *pFraction,
+		const struct DETECT_SETTINGS *pSettings)
+{
+	OSC_ERR err;
+
+	memset(pDet, 0, sizeof(struct DETECTOR));
+	pDet->settings = *pSettings;
+
+	err = HistoryInit(&pDet->history, pSettings->historyLength);
+	if (err != SUCCESS)
+		return err;
+
+	return BgModelInit(&pDet->bgModel, width, height, pBackground, pFraction,
+			pSettings->learnShift, pSettings->pixelThreshold, pSettings->learnInterleave);
+}
+
+OSC_ERR DetectorSetSettings(struct DETECTOR *pDet, const struct DETECT_SETTINGS *pSettings)
+{
+	OSC_ERR err;
+
+	if (pSettings->pixelThreshold > 255)
+		return -EINVALID_PARAMETER;
+
+	if (pSettings->historyLength != pDet->settings.historyLength) {
+		err = HistoryInit(&pDet->history, pSettings->historyLength);
+		if (err != SUCCESS)
+			return err;
+	}
+	pDet->bgModel.threshold = pSettings->pixelThreshold;
+
+	pDet->settings = *pSettings;
+	pDet->settings.learnShift = pDet->bgModel.learnShift;
+	pDet->settings.learnInterleave = pDet->bgModel.interleave;
+	return SUCCESS;
+}
+
+uint32 DetectorFrame(struct DETECTOR *pDet,
+		const uint8 *pPic,
+		const uint32 mean,
+		const uint8 diffRowStep)
+{
+	const struct DETECT_SETTINGS *pSet = &pDet->settings;
+	uint32 events = 0, n, d, start;
+
+	/* Learn the background and the history first. */
+	if (pDet->nLearned < pSet->historyLength) {
+		HistoryAdd(&pDet->history, mean);
+		if (pDet->nLearned == 0)
+			BgModelReset(&pDet->bgModel, pPic);
+		else
+			BgModelUpdate(&pDet->bgModel, pPic);
+		pDet->nLearned++;
+		return DETECT_LEARNING;
+	}
+
+	/* Deviation of the mean from the history */
+	n = HistoryMean(&pDet->history);
+	d = mean > n ? mean - n : n - mean;
+
+	/* Count pixels differing from the background */
+	start = ProfStart();
+	if (diffRowStep > 1)
+		pDet->changed = BgModelDiffRows(&pDet->bgModel, pPic, diffRowStep);
+	else
+		pDet->changed = BgModelDiff(&pDet->bgModel, pPic, NULL);
+	ProfStop(pDet->pDiffTimer, start);
+
+	if (HistoryIsFull(&pDet->history) && d > pSet->threshold &&
+			d * d > pSet->lightingSigmas * pSet->lightingSigmas * HistoryVariance(&pDet->history) &&
+			pDet->changed >= pSet->lightingPixels) {
+		/* A global lighting change (beyond the threshold and the noise of
+		 * the history): learn the new background. */
+		BgModelReset(&pDet->bgModel, pPic);
+		HistoryReset(&pDet->history);
+		HistoryAdd(&pDet->history, mean);
+		events |= DETECT_LIGHTING;
+	} else if (pDet->changed >= pSet->motionPixels) {
+		/* A new intruder, not one still moving during the cooldown */
+		events |= DETECT_MOTION;
+		if (!pDet->bMotion)
+			events |= DETECT_INTRUDER;
+
+		/* Keep watching during the cooldown. The baseline is rebuilt
+		 * from the frames after the intruder. */
+		if (pDet->cooldown == 0)
+			HistoryReset(&pDet->history);
+		pDet->cooldown = pSet->cooldownFrames;
+		pDet->bMotion = TRUE;
+	} else {
+		pDet->bMotion = FALSE;
+		HistoryAdd(&pDet->history, mean);
+
+		/* Learn slow changes of the background */
+		start = ProfStart();
+		BgModelUpdate(&pDet->bgModel, pPic);
+		ProfStop(pDet->pUpdateTimer, start);
+	}
+
+	/* During the cooldown the background also learns whatever stays in
+	 * the picture after an intruder */
+	if (pDet->cooldown > 0) {
+		if (pDet->bMotion)
+			BgModelUpdate(&pDet->bgModel, pPic);
+
+		pDet->cooldown--;
+		if (pDet->cooldown == 0)
+			events |= DETECT_ALARM_END;
+	}
+
+	return events;
+}
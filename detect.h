@@ -0,0 +1,157 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file detect.h
+ * @brief Intruder detection engine.
+ * Compares pictures with a background model and keeps a history of the
+ * picture means. Enough pixels differing from the background raise an
+ * alarm, which lasts until a number of frames after the last motion. A
+ * change of the mean beyond the noise of the history together with most
+ * pixels changing is treated as a global lighting change and the
+ * background is learned again. The engine keeps all state between frames,
+ * so the live loop and offline analysis give the same results.
+ */
+
+#ifndef DETECT_H_
+#define DETECT_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "bgmodel.h"
+#include "history.h"
+#include "prof.h"
+
+/* Default settings of the samples, those marked with (*) are read from
+ * the settings file of alarm.c */
+#define DETECT_THRESHOLD 2 /* Mean change of a lighting change (*) */
+#define DETECT_LIGHTING_SIGMAS 3 /* Mean change of a lighting change in standard deviations */
+#define DETECT_HISTORY_LENGTH 20 /* Means in the history (*) */
+#define DETECT_PIXEL_THRESHOLD 20 /* Grey level change of a moving pixel (*) */
+#define DETECT_MOTION_PIXELS_DIVISOR 900 /* One moving pixel in ... raises an alarm (* as MOTION_PIXELS) */
+#define DETECT_LIGHTING_PIXELS_DIVISOR 2 /* One moving pixel in ... is a lighting change */
+#define DETECT_COOLDOWN_FRAMES 40 /* Frames the alarm lasts after the last motion (*) */
+#define DETECT_LEARN_SHIFT 4 /* Background learning rate 2^-DETECT_LEARN_SHIFT */
+#define DETECT_LEARN_INTERLEAVE 4 /* Background rows updated per frame 1/DETECT_LEARN_INTERLEAVE */
+
+/*! @brief Detection settings. */
+struct DETECT_SETTINGS {
+	/*! @brief Mean change of a lighting change, absolute and in standard
+	 * deviations of the history. */
+	uint32 threshold, lightingSigmas;
+	/*! @brief Means in the history, also the frames learned at the start. */
+	uint32 historyLength;
+	/*! @brief Grey level change of a moving pixel. */
+	uint32 pixelThreshold;
+	/*! @brief Moving pixels of an intruder and of a lighting change. */
+	uint32 motionPixels, lightingPixels;
+	/*! @brief Frames the alarm lasts after the last motion. */
+	uint32 cooldownFrames;
+	/*! @brief Background learning rate 2^-learnShift and rows updated per
+	 * frame 1/learnInterleave, only set at initialization. */
+	uint32 learnShift, learnInterleave;
+};
+
+/*! @brief Events of a frame, combined as flags. */
+enum EnDetectEvents {
+	/*! @brief The frame was learned, not analysed. */
+	DETECT_LEARNING = 1,
+	/*! @brief A lighting change, the background is learned again. */
+	DETECT_LIGHTING = 2,
+	/*! @brief Motion in the frame. */
+	DETECT_MOTION = 4,
+	/*! @brief A new intruder: motion after a frame without motion. */
+	DETECT_INTRUDER = 8,
+	/*! @brief The alarm ended with this frame. */
+	DETECT_ALARM_END = 16
+};
+
+/*! @brief State of a detection engine. */
+struct DETECTOR {
+	/*! @brief Settings. */
+	struct DETECT_SETTINGS settings;
+	/*! @brief Background model. */
+	struct BG_MODEL bgModel;
+	/*! @brief History of the picture means. */
+	struct HISTORY history;
+	/*! @brief Frames learned so far, detection starts after historyLength. */
+	uint32 nLearned;
+	/*! @brief Frames left until the alarm ends, 0 without alarm. */
+	uint32 cooldown;
+	/*! @brief TRUE if the last frame had motion. */
+	int bMotion;
+	/*! @brief Moving pixels of the last frame. */
+	uint32 changed;
+	/*! @brief Timers of the background difference and update, may be NULL. */
+	struct PROF_TIMER *pDiffTimer, *pUpdateTimer;
+};
+
+/*********************************************************************//*!
+ * @brief Get the default settings (DETECT_THRESHOLD etc.).
+ *
+ * @param pSettings The settings.
+ * @param width Picture width.
+ * @param height Picture height.
+ *//*********************************************************************/
+void DetectDefaults(struct DETECT_SETTINGS *pSettings, const uint16 width, const uint16 height);
+
+/*********************************************************************//*!
+ * @brief Set up a detection engine.
+ *
+ * @param pDet Engine to initialize.
+ * @param width Picture width.
+ * @param height Picture height.
+ * @param pBackground Background buffer of width * height bytes, word aligned.
+ * @param pFraction Fraction buffer of width * height bytes, word aligned.
+ * @param pSettings Settings.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DetectorInit(struct DETECTOR *pDet,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBackground,
+		uint8 *pFraction,
+		const struct DETECT_SETTINGS *pSettings);
+
+/*********************************************************************//*!
+ * @brief Change the settings between frames.
+ *
+ * A new history length restarts the history. The learning rate and the
+ * interleave are kept.
+ *
+ * @param pDet Engine.
+ * @param pSettings Settings.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DetectorSetSettings(struct DETECTOR *pDet, const struct DETECT_SETTINGS *pSettings);
+
+/*********************************************************************//*!
+ * @brief Analyse a picture.
+ *
+ * The first historyLength pictures are learned as background and history.
+ *
+ * @param pDet Engine.
+ * @param pPic Greyscale picture.
+ * @param mean Mean of the picture (e.g. of a thumbnail).
+ * @param diffRowStep Compare every diffRowStep-th row, 1 for all rows.
+ * @return Events of the frame (EnDetectEvents)
+ *//*********************************************************************/
+uint32 DetectorFrame(struct DETECTOR *pDet,
+		const uint8 *pPic,
+		const uint32 mean,
+		const uint8 diffRowStep);
+
+#endif /* DETECT_H_ */
@@ -18,15 +18,353 @@
 
 /*!@file dma.c
  * @brief DMA module example.
- * Demonstrates a memory copy operation using dma.
+ * Demonstrates a memory copy operation using dma and the processing of a
+ * frame in tiles streamed through on-chip memory. With -b, DMA transfers
+ * planned over several chains are timed against memcpy and a thumbnail
+ * gathered by DMA against one gathered by the CPU.
  */
 
 #include "oscar/staging/inc/oscar.h"
+#include "dmaplan.h"
+#include "thumb.h"
+#include "tilestream.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(OSC_TARGET)
+#include <sys/cachectl.h>
+#endif
 
 #define WIDTH 512
 #define HEIGHT 128
 
+#define FRAME_WIDTH 752
+#define FRAME_HEIGHT 480
+#define TILE_WIDTH 188
+#define TILE_HEIGHT 16
+
+/* Number of frames copied in the largest benchmark case */
+#define BENCH_FRAMES 4
+/* Row stride of the frame copied into a wider picture */
+#define BENCH_STRIDE 1024
+/* Distance of the pixels and rows of the thumbnail */
+#define THUMB_STEP 4
+
+/*********************************************************************//*!
+ * @brief Tile kernel: add up the pixels of a tile.
+ * 
+ * @param pArg Sum of the pixels.
+ * @param pIn Input tile.
+ * @param pOut Unused.
+ * @param x Left column of the tile.
+ * @param y Top row of the tile.
+ * @param width Tile width.
+ * @param height Tile height.
+ *//*********************************************************************/
+static void sumTile(void *pArg, const uint8 *pIn, uint8 *pOut, const uint16 x, const uint16 y, const uint16 width, const uint16 height)
+{
+	uint32 i, sum = 0, size = (uint32) width * height;
+	
+	for (i = 0; i < size; i++) {
+		sum += pIn[i];
+	}
+	*(uint32 *) pArg += sum;
+}
+
+/*********************************************************************//*!
+ * @brief Tile kernel: invert the pixels of a tile.
+ * 
+ * @param pArg Unused.
+ * @param pIn Input tile.
+ * @param pOut Output tile.
+ * @param x Left column of the tile.
+ * @param y Top row of the tile.
+ * @param width Tile width.
+ * @param height Tile height.
+ *//*********************************************************************/
+static void invertTile(void *pArg, const uint8 *pIn, uint8 *pOut, const uint16 x, const uint16 y, const uint16 width, const uint16 height)
+{
+	uint32 i, size = (uint32) width * height;
+	
+	for (i = 0; i < size; i++) {
+		pOut[i] = 255 - pIn[i];
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Process a frame in tiles streamed through on-chip memory.
+ * 
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR streamTiles(void)
+{
+	static uint8 frame[FRAME_WIDTH * FRAME_HEIGHT];
+	static uint8 inverted[FRAME_WIDTH * FRAME_HEIGHT];
+	struct TILE_STREAM stream;
+	uint32 i, sum = 0, cpuSum = 0, cycles, usStream, usCpu, errors = 0;
+	OSC_ERR err;
+	
+	for (i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; i++) {
+		frame[i] = (uint8) (i * 7 + i / FRAME_WIDTH);
+	}
+	
+	err = TileStreamInit(&stream, FRAME_WIDTH, FRAME_HEIGHT, TILE_WIDTH, TILE_HEIGHT);
+	if (err != SUCCESS) {
+		printf("%s: Unable to set up tile stream (%d)!\n", __func__, err);
+		return err;
+	}
+	
+	/* Kernel with output: the results are streamed back */
+	err = TileStreamRun(&stream, frame, inverted, invertTile, NULL);
+	for (i = 0; i < FRAME_WIDTH * FRAME_HEIGHT && err == SUCCESS; i++) {
+		if (inverted[i] != 255 - frame[i]) {
+			errors++;
+		}
+	}
+	
+	/* Kernel without output: compare with the CPU reading the frame directly */
+	cycles = OscSupCycGet();
+	if (err == SUCCESS) {
+		err = TileStreamRun(&stream, frame, NULL, sumTile, &sum);
+	}
+	usStream = OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+	
+	cycles = OscSupCycGet();
+	sumTile(&cpuSum, frame, NULL, 0, 0, FRAME_WIDTH, FRAME_HEIGHT);
+	usCpu = OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+	
+	if (err != SUCCESS) {
+		printf("%s: Tile stream failed (%d)!\n", __func__, err);
+	} else {
+		printf("Tile stream: %lu tiles, %lu wrong pixels, sum %lu (CPU %lu)\n", stream.nTiles, errors, sum, cpuSum);
+		printf("Tile stream: %lu us (%lu us waiting for DMA), CPU: %lu us\n", usStream, OscSupCycToMicroSecs(stream.waitCycles), usCpu);
+		printf("Tile buffers in %s memory\n", stream.bOnChip ? "on-chip" : "external");
+	}
+	
+	TileStreamDestroy(&stream);
+	return err;
+}
+
+
+/*********************************************************************//*!
+ * @brief Copy a list of moves with the CPU.
+ * 
+ * @param pMoves Moves.
+ * @param nMoves Number of moves.
+ *//*********************************************************************/
+static void cpuCopy(const struct DMA_MOVE *pMoves, const uint32 nMoves)
+{
+	uint32 i, y;
+	
+	for (i = 0; i < nMoves; i++) {
+		for (y = 0; y < pMoves[i].height; y++) {
+			memcpy(pMoves[i].pDst + y * pMoves[i].dstStride, pMoves[i].pSrc + y * pMoves[i].srcStride, pMoves[i].width);
+		}
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Time a list of moves done by planned DMA and by memcpy.
+ * 
+ * @param pPlan Plan.
+ * @param name Name of the case.
+ * @param pMoves Moves.
+ * @param nMoves Number of moves.
+ * @param n Number of rounds.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchmarkCase(struct DMA_PLAN *pPlan, const char *name, const struct DMA_MOVE *pMoves, const uint32 nMoves, const uint32 n)
+{
+	uint32 i, j, cycles, usDma = 0, usCpu = 0, bytes = 0, errors = 0;
+	OSC_ERR err = SUCCESS;
+	
+	for (i = 0; i < nMoves; i++) {
+		bytes += pMoves[i].width * pMoves[i].height;
+	}
+	
+	pPlan->nChains = 0;
+	for (i = 0; i < n && err == SUCCESS; i++) {
+		for (j = 0; j < nMoves; j++) {
+			memset(pMoves[j].pDst, 0, (pMoves[j].height - 1) * pMoves[j].dstStride + pMoves[j].width);
+		}
+		
+		cycles = OscSupCycGet();
+#if defined(OSC_TARGET)
+		/* The DMA bypasses the data cache, writing it back is part of its cost. */
+		for (j = 0; j < nMoves; j++) {
+			cacheflush((void *) pMoves[j].pSrc, (pMoves[j].height - 1) * pMoves[j].srcStride + pMoves[j].width, DCACHE);
+			cacheflush(pMoves[j].pDst, (pMoves[j].height - 1) * pMoves[j].dstStride + pMoves[j].width, DCACHE);
+		}
+#endif
+		err = DmaPlanStart(pPlan, pMoves, nMoves);
+		if (err == SUCCESS) {
+			err = DmaPlanSync(pPlan);
+		}
+		usDma += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		for (j = 0; j < nMoves && err == SUCCESS; j++) {
+			if (memcmp(pMoves[j].pDst + (pMoves[j].height - 1) * pMoves[j].dstStride, pMoves[j].pSrc + (pMoves[j].height - 1) * pMoves[j].srcStride, pMoves[j].width) != 0) {
+				errors++;
+			}
+		}
+		
+		cycles = OscSupCycGet();
+		cpuCopy(pMoves, nMoves);
+		usCpu += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+	}
+	
+	if (err != SUCCESS) {
+		printf("%s: %s failed (%d)!\n", __func__, name, err);
+		return err;
+	}
+	
+	/* Bytes per microsecond are megabytes per second. */
+	printf("%-24s %8lu bytes: DMA %5lu MB/s (%lu chains), memcpy %5lu MB/s%s\n", name, bytes,
+			usDma > 0 ? (uint32) ((double) bytes * n / usDma) : 0, pPlan->nChains / n,
+			usCpu > 0 ? (uint32) ((double) bytes * n / usCpu) : 0,
+			errors > 0 ? ", WRONG DATA" : "");
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Time the thumbnail of a frame gathered by DMA and by the CPU.
+ * 
+ * @param frame Frame.
+ * @param n Number of rounds.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchmarkThumb(const uint8 *frame, const uint32 n)
+{
+	static uint8 dmaThumb[FRAME_WIDTH / THUMB_STEP * FRAME_HEIGHT / THUMB_STEP];
+	static uint8 cpuThumb[FRAME_WIDTH / THUMB_STEP * FRAME_HEIGHT / THUMB_STEP];
+	struct THUMB thumb;
+	uint32 i, cycles, usStart = 0, usDma = 0, usCpu = 0, errors = 0;
+	OSC_ERR err;
+	
+	err = ThumbInit(&thumb, FRAME_WIDTH, FRAME_HEIGHT, THUMB_STEP, 0, 0, dmaThumb);
+	if (err != SUCCESS) {
+		printf("%s: Unable to set up thumbnail (%d)!\n", __func__, err);
+		return err;
+	}
+	
+	for (i = 0; i < n && err == SUCCESS; i++) {
+		memset(dmaThumb, 0, sizeof(dmaThumb));
+		
+		cycles = OscSupCycGet();
+		err = ThumbStart(&thumb, frame);
+		usStart += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		if (err == SUCCESS) {
+			err = ThumbSync(&thumb);
+		}
+		usDma += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		ThumbGather(&thumb, frame, cpuThumb);
+		usCpu += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		if (memcmp(dmaThumb, cpuThumb, sizeof(dmaThumb)) != 0) {
+			errors++;
+		}
+	}
+	
+	if (err != SUCCESS) {
+		printf("%s: Thumbnail failed (%d)!\n", __func__, err);
+		return err;
+	}
+	
+	printf("Thumbnail %ux%u: DMA %lu us (CPU busy %lu us), CPU gather %lu us%s\n", thumb.width, thumb.height,
+			usDma / n, usStart / n, usCpu / n, errors > 0 ? ", WRONG DATA" : "");
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Time planned DMA against memcpy for transfers of several sizes.
+ * 
+ * @param n Number of rounds.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR benchmark(const uint32 n)
+{
+	static uint8 src[BENCH_FRAMES * FRAME_WIDTH * FRAME_HEIGHT];
+	static uint8 dst[BENCH_STRIDE * FRAME_HEIGHT > BENCH_FRAMES * FRAME_WIDTH * FRAME_HEIGHT ? BENCH_STRIDE * FRAME_HEIGHT : BENCH_FRAMES * FRAME_WIDTH * FRAME_HEIGHT];
+	const uint32 frameSize = FRAME_WIDTH * FRAME_HEIGHT;
+	struct DMA_MOVE moves[BENCH_FRAMES];
+	struct DMA_PLAN plan;
+	uint32 i;
+	OSC_ERR err;
+	
+	for (i = 0; i < sizeof(src); i++) {
+		src[i] = (uint8) (i * 13 + i / 251);
+	}
+	
+	err = DmaPlanInit(&plan);
+	if (err != SUCCESS) {
+		printf("%s: Unable to set up DMA plan (%d)!\n", __func__, err);
+		return err;
+	}
+	
+	/* The transfer of the example above */
+	moves[0].pDst = dst;
+	moves[0].dstStride = WIDTH * HEIGHT * sizeof(uint32);
+	moves[0].pSrc = src;
+	moves[0].srcStride = WIDTH * HEIGHT * sizeof(uint32);
+	moves[0].srcStep = 1;
+	moves[0].width = WIDTH * HEIGHT * sizeof(uint32);
+	moves[0].height = 1;
+	err = benchmarkCase(&plan, "WIDTH x HEIGHT words", moves, 1, n);
+	
+	/* A frame */
+	moves[0].dstStride = moves[0].srcStride = moves[0].width = FRAME_WIDTH;
+	moves[0].height = FRAME_HEIGHT;
+	if (err == SUCCESS) {
+		err = benchmarkCase(&plan, "Frame", moves, 1, n);
+	}
+	
+	/* A frame into a wider picture, the rows are not contiguous */
+	moves[0].dstStride = BENCH_STRIDE;
+	if (err == SUCCESS) {
+		err = benchmarkCase(&plan, "Frame, strided", moves, 1, n);
+	}
+	
+	/* Several frames as a list of moves */
+	for (i = 0; i < BENCH_FRAMES; i++) {
+		moves[i].pDst = dst + i * frameSize;
+		moves[i].dstStride = FRAME_WIDTH;
+		moves[i].pSrc = src + i * frameSize;
+		moves[i].srcStride = FRAME_WIDTH;
+		moves[i].srcStep = 1;
+		moves[i].width = FRAME_WIDTH;
+		moves[i].height = FRAME_HEIGHT;
+	}
+	if (err == SUCCESS) {
+		err = benchmarkCase(&plan, "Frames", moves, BENCH_FRAMES, n);
+	}
+	
+	/* The frames row by row, many more moves than a chain holds */
+	if (err == SUCCESS) {
+		static struct DMA_MOVE rows[BENCH_FRAMES * FRAME_HEIGHT];
+		
+		for (i = 0; i < BENCH_FRAMES * FRAME_HEIGHT; i++) {
+			rows[i].pDst = dst + i * FRAME_WIDTH;
+			rows[i].dstStride = FRAME_WIDTH;
+			rows[i].pSrc = src + i * FRAME_WIDTH;
+			rows[i].srcStride = FRAME_WIDTH;
+			rows[i].srcStep = 1;
+			rows[i].width = FRAME_WIDTH;
+			rows[i].height = 1;
+		}
+		err = benchmarkCase(&plan, "Frames, row by row", rows, BENCH_FRAMES * FRAME_HEIGHT, n);
+	}
+	
+	/* A thumbnail of every THUMB_STEP-th pixel and row of a frame */
+	if (err == SUCCESS) {
+		err = benchmarkThumb(src, n);
+	}
+	
+	return err;
+}
+
 
 /*********************************************************************//*!
  * @brief Program entry.
@@ -52,6 +390,26 @@ int main(const int argc, const char * argv[])
 	/* Destination data field. */
 	uint32 drain[WIDTH][HEIGHT];
 	uint32 i,j;
+	uint32 opt_benchmark = 0;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0) {
+			i++;
+			if (i >= argc) {
+				printf("Error: -b needs an argument.\n");
+				return 1;
+			}
+			opt_benchmark = atoi(argv[i]);
+		} else if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: dma [ -h ] [ -b <n> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -b <n>: Times DMA against the CPU over n rounds.\n");
+			return 0;
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
 	
 	/* Create framework */
 	OscCreate(&hFramework);
@@ -59,8 +417,9 @@ int main(const int argc, const char * argv[])
 	/* Allocate dma chain */
 	OscDmaAllocChain(&hChain);
 	
-	/* Load dma module */
+	/* Load dma and support module */
 	OscDmaCreate(hFramework);
+	OscSupCreate(hFramework);
 	
 	/* Compute something and fill source data segment with data */
 	/* -------------------------------------------------------- */
@@ -91,8 +450,16 @@ int main(const int argc, const char * argv[])
 	}
 	printf("Dma transfer done!!!\n");
 	
-	/* Unload dma module */
+	/* Stream a frame through on-chip memory tile by tile */
+	streamTiles();
+	
+	if (opt_benchmark > 0) {
+		benchmark(opt_benchmark);
+	}
+	
+	/* Unload dma and support module */
 	OscDmaDestroy(hFramework);
+	OscSupDestroy(hFramework);
 	
 	/* Destroy framework */
 	OscDestroy(hFramework);
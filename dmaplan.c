@@ -0,0 +1,356 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file dmaplan.c
+ * @brief DMA transfer planner.
+ * A transfer has at most 65535 units per row and 65535 rows, and its
+ * modifiers are 16 bit. A rectangle within these limits is one transfer.
+ * Contiguous memory is folded into rows of DMA_PLAN_ROW_UNITS units, other
+ * rectangles are split into their rows. Gathering moves are done byte by
+ * byte, the source X modifier skipping the bytes in between. The emulated
+ * chains of the host carry out their transfers only when synced.
+ */
+
+#include "dmaplan.h"
+#include <string.h>
+
+/*! @brief Units per row when contiguous memory is folded into rows. */
+#define DMA_PLAN_ROW_UNITS 1024
+/*! @brief Maximum unit and row count of a transfer. */
+#define DMA_PLAN_MAX_COUNT 65535
+/*! @brief Maximum magnitude of a modifier. */
+#define DMA_PLAN_MAX_MODIFY 32767
+
+OSC_ERR DmaPlanInit(struct DMA_PLAN *pPlan)
+{
+	OSC_ERR err;
+	uint8 i;
+
+	memset(pPlan, 0, sizeof(struct DMA_PLAN));
+	for (i = 0; i < 2; i++) {
+		err = OscDmaAllocChain(&pPlan->chains[i].hChain);
+		if (err != SUCCESS)
+			return err;
+	}
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Get the widest transfer unit the alignment of a move allows.
+ *
+ * @param pMove Move.
+ * @return Bytes per unit (1, 2 or 4)
+ *//*********************************************************************/
+static uint8 unitSize(const struct DMA_MOVE *pMove)
+{
+	unsigned long bits = (unsigned long) pMove->pDst | (unsigned long) pMove->pSrc | pMove->width;
+
+	if (pMove->height > 1)
+		bits |= pMove->dstStride | pMove->srcStride;
+
+	if (bits % 4 == 0)
+		return 4;
+	if (bits % 2 == 0)
+		return 2;
+	return 1;
+}
+
+/*********************************************************************//*!
+ * @brief Get the next transfer of a plan.
+ *
+ * @param pPlan Plan.
+ * @param pTransfer Transfer to fill in.
+ * @return TRUE if a transfer was filled in, FALSE if the plan is done
+ *//*********************************************************************/
+static int nextTransfer(struct DMA_PLAN *pPlan, struct DMA_TRANSFER *pTransfer)
+{
+	const struct DMA_MOVE *pMove;
+	long dstYModify, srcYModify;
+	uint32 runLength, units;
+	int bContiguous;
+	uint8 unit;
+
+	while (pPlan->iMove < pPlan->nMoves) {
+		pMove = &pPlan->pMoves[pPlan->iMove];
+		unit = unitSize(pMove);
+		bContiguous = pMove->height == 1 ||
+				(pMove->dstStride == (long) pMove->width && pMove->srcStride == (long) pMove->width);
+		if (pMove->width == 0 || pMove->height == 0) {
+			pPlan->iMove++;
+			continue;
+		}
+
+		if (pMove->srcStep > 1) {
+			/* Gathered rows: the whole rectangle or a single row. */
+			dstYModify = pMove->dstStride - (long) pMove->width + 1;
+			srcYModify = pMove->srcStride - (long) (pMove->width - 1) * pMove->srcStep;
+			pTransfer->pDst = pMove->pDst + pPlan->row * pMove->dstStride;
+			pTransfer->pSrc = pMove->pSrc + pPlan->row * pMove->srcStride;
+			pTransfer->unit = 1;
+			pTransfer->xCount = pMove->width;
+			pTransfer->srcXModify = pMove->srcStep;
+			if (pPlan->row == 0 &&
+					dstYModify >= -DMA_PLAN_MAX_MODIFY && dstYModify <= DMA_PLAN_MAX_MODIFY &&
+					srcYModify >= -DMA_PLAN_MAX_MODIFY && srcYModify <= DMA_PLAN_MAX_MODIFY) {
+				pTransfer->yCount = pMove->height;
+				pTransfer->dstYModify = dstYModify;
+				pTransfer->srcYModify = srcYModify;
+				pPlan->row = pMove->height;
+			} else {
+				pTransfer->yCount = 1;
+				pTransfer->dstYModify = 1;
+				pTransfer->srcYModify = pMove->srcStep;
+				pPlan->row++;
+			}
+			if (pPlan->row >= pMove->height) {
+				pPlan->row = 0;
+				pPlan->iMove++;
+			}
+			return TRUE;
+		}
+
+		/* A rectangle within the limits of the controller. */
+		dstYModify = pMove->dstStride - (long) pMove->width + unit;
+		srcYModify = pMove->srcStride - (long) pMove->width + unit;
+		if (!bContiguous && pPlan->row == 0 && pPlan->offset == 0 &&
+				pMove->width / unit <= DMA_PLAN_MAX_COUNT &&
+				dstYModify >= -DMA_PLAN_MAX_MODIFY && dstYModify <= DMA_PLAN_MAX_MODIFY &&
+				srcYModify >= -DMA_PLAN_MAX_MODIFY && srcYModify <= DMA_PLAN_MAX_MODIFY) {
+			pTransfer->pDst = pMove->pDst;
+			pTransfer->pSrc = pMove->pSrc;
+			pTransfer->unit = unit;
+			pTransfer->xCount = pMove->width / unit;
+			pTransfer->yCount = pMove->height;
+			pTransfer->srcXModify = unit;
+			pTransfer->dstYModify = dstYModify;
+			pTransfer->srcYModify = srcYModify;
+			pPlan->iMove++;
+			return TRUE;
+		}
+
+		/* Contiguous memory: the whole move or a single row. */
+		runLength = bContiguous ? pMove->width * pMove->height : pMove->width;
+		if (pPlan->offset < runLength) {
+			pTransfer->pDst = pMove->pDst + pPlan->row * pMove->dstStride + pPlan->offset;
+			pTransfer->pSrc = pMove->pSrc + pPlan->row * pMove->srcStride + pPlan->offset;
+			pTransfer->unit = unit;
+			units = (runLength - pPlan->offset) / unit;
+			if (units >= DMA_PLAN_ROW_UNITS) {
+				pTransfer->xCount = DMA_PLAN_ROW_UNITS;
+				units /= DMA_PLAN_ROW_UNITS;
+				pTransfer->yCount = units < DMA_PLAN_MAX_COUNT ? units : DMA_PLAN_MAX_COUNT;
+			} else {
+				pTransfer->xCount = units;
+				pTransfer->yCount = 1;
+			}
+			pTransfer->srcXModify = unit;
+			pTransfer->dstYModify = unit;
+			pTransfer->srcYModify = unit;
+			pPlan->offset += (uint32) pTransfer->xCount * pTransfer->yCount * unit;
+			return TRUE;
+		}
+
+		pPlan->offset = 0;
+		if (!bContiguous && ++pPlan->row < pMove->height)
+			continue;
+		pPlan->row = 0;
+		pPlan->iMove++;
+	}
+
+	return FALSE;
+}
+
+/*********************************************************************//*!
+ * @brief Fill a chain with the next transfers of a plan.
+ *
+ * @param pPlan Plan.
+ * @param pChain Empty chain.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR fillChain(struct DMA_PLAN *pPlan, struct DMA_PLAN_CHAIN *pChain)
+{
+	OSC_ERR err = SUCCESS;
+#if !defined(OSC_HOST)
+	static const enum EnDmaWdSize wdSizes[5] = {
+		DMA_WDSIZE_8, DMA_WDSIZE_8, DMA_WDSIZE_16, DMA_WDSIZE_16, DMA_WDSIZE_32
+	};
+	struct DMA_TRANSFER *pT;
+#endif
+
+	while (pChain->nTransfers < DMA_PLAN_CHAIN_MOVES &&
+			nextTransfer(pPlan, &pChain->transfers[pChain->nTransfers])) {
+#if !defined(OSC_HOST)
+		pT = &pChain->transfers[pChain->nTransfers];
+		err = OscDmaAdd2DMove(pChain->hChain,
+				pT->pDst, wdSizes[pT->unit], pT->xCount, pT->unit, pT->yCount, pT->dstYModify,
+				(void *) pT->pSrc, wdSizes[pT->unit], pT->xCount, pT->srcXModify, pT->yCount, pT->srcYModify);
+		if (err != SUCCESS)
+			return err;
+#endif
+		pChain->nTransfers++;
+	}
+
+#if !defined(OSC_HOST)
+	if (pChain->nTransfers > 0)
+		err = OscDmaAddSyncPoint(pChain->hChain);
+#endif
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Wait for a started chain and empty it.
+ *
+ * @param pChain Chain.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR syncChain(struct DMA_PLAN_CHAIN *pChain)
+{
+	OSC_ERR err = SUCCESS;
+#if defined(OSC_HOST)
+	const struct DMA_TRANSFER *pT;
+	uint8 *pDst;
+	const uint8 *pSrc;
+	uint32 rowSize, x;
+	uint16 y;
+	uint8 i;
+
+	for (i = 0; i < pChain->nTransfers; i++) {
+		pT = &pChain->transfers[i];
+		pDst = pT->pDst;
+		pSrc = pT->pSrc;
+		rowSize = (uint32) pT->xCount * pT->unit;
+		for (y = 0; y < pT->yCount; y++) {
+			if (pT->srcXModify == pT->unit) {
+				memcpy(pDst, pSrc, rowSize);
+			} else {
+				/* Gathered bytes. */
+				for (x = 0; x < pT->xCount; x++)
+					pDst[x] = pSrc[x * pT->srcXModify];
+			}
+			pDst += rowSize - pT->unit + pT->dstYModify;
+			pSrc += (long) (pT->xCount - 1) * pT->srcXModify + pT->srcYModify;
+		}
+	}
+#else
+	err = OscDmaSync(pChain->hChain);
+	if (err == SUCCESS)
+		err = OscDmaResetChain(pChain->hChain);
+#endif
+	pChain->nTransfers = 0;
+
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Start a filled chain.
+ *
+ * @param pPlan Plan.
+ * @param iChain Index of the chain.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR startChain(struct DMA_PLAN *pPlan, const uint8 iChain)
+{
+	OSC_ERR err = SUCCESS;
+
+#if !defined(OSC_HOST)
+	err = OscDmaStart(pPlan->chains[iChain].hChain);
+	if (err != SUCCESS)
+		return err;
+#endif
+	pPlan->iRunning = iChain;
+	pPlan->bRunning = TRUE;
+	pPlan->nChains++;
+	pPlan->nTransfers += pPlan->chains[iChain].nTransfers;
+
+	return err;
+}
+
+OSC_ERR DmaPlanStart(struct DMA_PLAN *pPlan,
+		const struct DMA_MOVE *pMoves,
+		const uint32 nMoves)
+{
+	OSC_ERR err;
+	uint32 i;
+
+	if (pPlan->bRunning)
+		return -EINVALID_PARAMETER;
+	for (i = 0; i < nMoves; i++) {
+		if (pMoves[i].srcStep > 1 &&
+				(pMoves[i].width > DMA_PLAN_MAX_COUNT || pMoves[i].srcStep > DMA_PLAN_MAX_MODIFY))
+			return -EINVALID_PARAMETER;
+	}
+
+	pPlan->pMoves = pMoves;
+	pPlan->nMoves = nMoves;
+	pPlan->iMove = 0;
+	pPlan->row = 0;
+	pPlan->offset = 0;
+
+	err = fillChain(pPlan, &pPlan->chains[0]);
+	if (err != SUCCESS || pPlan->chains[0].nTransfers == 0)
+		return err;
+
+	err = startChain(pPlan, 0);
+	if (err != SUCCESS)
+		return err;
+
+	/* Prepare the following chain while the first one runs. */
+	return fillChain(pPlan, &pPlan->chains[1]);
+}
+
+OSC_ERR DmaPlanStep(struct DMA_PLAN *pPlan, int *pbDone)
+{
+	OSC_ERR err;
+	uint8 iDone = pPlan->iRunning, iNext = pPlan->iRunning ^ 1;
+
+	*pbDone = FALSE;
+	if (!pPlan->bRunning) {
+		*pbDone = TRUE;
+		return SUCCESS;
+	}
+
+	err = syncChain(&pPlan->chains[iDone]);
+	pPlan->bRunning = FALSE;
+	if (err != SUCCESS)
+		return err;
+
+	if (pPlan->chains[iNext].nTransfers == 0) {
+		*pbDone = TRUE;
+		return SUCCESS;
+	}
+
+	/* Start the prepared chain at once, then prepare the one after. */
+	err = startChain(pPlan, iNext);
+	if (err != SUCCESS)
+		return err;
+
+	return fillChain(pPlan, &pPlan->chains[iDone]);
+}
+
+OSC_ERR DmaPlanSync(struct DMA_PLAN *pPlan)
+{
+	OSC_ERR err;
+	int bDone = FALSE;
+
+	do {
+		err = DmaPlanStep(pPlan, &bDone);
+	} while (err == SUCCESS && !bDone);
+
+	return err;
+}
@@ -0,0 +1,140 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file dmaplan.h
+ * @brief DMA transfer planner.
+ * Carries out any number of 1D and 2D memory moves of any size with DMA.
+ * The moves are split into transfers the DMA controller can do and spread
+ * over as many chains as needed; the next chain is prepared while the
+ * current one runs and started as soon as it is done. A move may gather
+ * every n-th byte of its source rows. On the host, the transfers are
+ * emulated with memcpy.
+ */
+
+#ifndef DMAPLAN_H_
+#define DMAPLAN_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Maximum number of transfers in a DMA chain. */
+#define DMA_PLAN_CHAIN_MOVES 4
+
+/*! @brief A rectangular memory move, a 1D move has a height of 1. */
+struct DMA_MOVE {
+	/*! @brief Start and row stride of the destination. */
+	uint8 *pDst;
+	long dstStride;
+	/*! @brief Start and row stride of the source. */
+	const uint8 *pSrc;
+	long srcStride;
+	/*! @brief Distance of the source bytes of a row, 1 if they are adjacent.
+	 * With a larger step, at most 65535 bytes per row are gathered. */
+	uint16 srcStep;
+	/*! @brief Bytes per row (of the destination) and number of rows. */
+	uint32 width;
+	uint16 height;
+};
+
+/*! @brief A transfer the DMA controller can do in one go. */
+struct DMA_TRANSFER {
+	/*! @brief Start addresses. */
+	uint8 *pDst;
+	const uint8 *pSrc;
+	/*! @brief Bytes per transfer unit (1, 2 or 4). */
+	uint8 unit;
+	/*! @brief Units per row and number of rows. */
+	uint16 xCount, yCount;
+	/*! @brief Address increment between the units of a source row. */
+	int16 srcXModify;
+	/*! @brief Address increment after the last unit of a row. */
+	int16 dstYModify, srcYModify;
+};
+
+/*! @brief A DMA chain of a plan. */
+struct DMA_PLAN_CHAIN {
+	/*! @brief Oscar DMA chain. */
+	void *hChain;
+	/*! @brief Transfers added to the chain. */
+	struct DMA_TRANSFER transfers[DMA_PLAN_CHAIN_MOVES];
+	uint8 nTransfers;
+};
+
+/*! @brief State of a DMA transfer plan. */
+struct DMA_PLAN {
+	/*! @brief The running chain and the one prepared to follow it. */
+	struct DMA_PLAN_CHAIN chains[2];
+	/*! @brief Index of the running chain. */
+	uint8 iRunning;
+	/*! @brief TRUE while the running chain is started and not yet synced. */
+	int bRunning;
+	/*! @brief Moves of the plan, owned by the caller. */
+	const struct DMA_MOVE *pMoves;
+	uint32 nMoves;
+	/*! @brief Position of the next transfer: move, row and offset. */
+	uint32 iMove, offset;
+	uint16 row;
+	/*! @brief Number of chains and transfers started so far. */
+	uint32 nChains, nTransfers;
+};
+
+/*********************************************************************//*!
+ * @brief Allocate the DMA chains of a plan.
+ *
+ * Requires the dma module to be loaded.
+ *
+ * @param pPlan Plan to initialize.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DmaPlanInit(struct DMA_PLAN *pPlan);
+
+/*********************************************************************//*!
+ * @brief Start carrying out a list of moves.
+ *
+ * Moves are done in order, the first chain is started before returning.
+ * The moves must stay unchanged until the plan is synced. Fails with
+ * -EINVALID_PARAMETER on a gathering move the controller cannot do.
+ *
+ * @param pPlan Initialized plan, synced if it was started before.
+ * @param pMoves Moves to carry out.
+ * @param nMoves Number of moves.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DmaPlanStart(struct DMA_PLAN *pPlan,
+		const struct DMA_MOVE *pMoves,
+		const uint32 nMoves);
+
+/*********************************************************************//*!
+ * @brief Wait for the running chain and start the next one.
+ *
+ * Lets the CPU work between the chains of a long plan.
+ *
+ * @param pPlan Started plan.
+ * @param pbDone Set to TRUE if all moves are done.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DmaPlanStep(struct DMA_PLAN *pPlan, int *pbDone);
+
+/*********************************************************************//*!
+ * @brief Wait until all moves of a plan are done.
+ *
+ * @param pPlan Started plan.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR DmaPlanSync(struct DMA_PLAN *pPlan);
+
+#endif /* DMAPLAN_H_ */
@@ -0,0 +1,193 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file exposure.c
+ * @brief Auto exposure on replayed frames.
+ * Runs the auto exposure controller (autoexp.c) on a simulated camera
+ * (simcam.c) which emulates the exposure of replayed frames: given the
+ * shutter width the frames were taken with, each picture is brightened or
+ * darkened by the shutter width set, which takes effect one picture late
+ * as on the sensor. Prints the shutter width each picture was exposed
+ * with, its median and the shutter width predicted, and the picture from
+ * which on the exposure is right.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "autoexp.h"
+#include "simcam.h"
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Default frames, greyscale bitmaps */
+#define EXPOSURE_INPUT "imgCapture.bmp"
+/* Distance of the pixels and rows of the histogram */
+#define HISTOGRAM_STEP 4
+/* Grey level the median is brought to */
+#define EXPOSURE_TARGET 100
+/* Range of the shutter width [us] */
+#define MIN_SHUTTER 10
+#define MAX_SHUTTER 200000
+/* Pictures read out before a new shutter width takes effect */
+#define EXPOSURE_LATENCY 1
+
+/*********************************************************************//*!
+ * @brief Capture pictures and control their exposure.
+ *
+ * @param pCam Camera with an emulated exposure.
+ * @param pExp Auto exposure controller.
+ * @param nFrames Pictures to capture.
+ * @param pSettled First picture exposed right, nFrames if none.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR runExposure(struct SIM_CAMERA *pCam,
+		struct AUTO_EXP *pExp,
+		const uint32 nFrames,
+		uint32 *pSettled)
+{
+	struct OSC_PICTURE pic;
+	uint8 *pData;
+	uint32 i, mean;
+	int bChanged;
+	OSC_ERR err;
+
+	*pSettled = nFrames;
+	printf("# frame shutter median mean new-shutter\n");
+	for (i = 0; i < nFrames; i++) {
+		err = SimCamSetupCapture(pCam, 0);
+		if (err == SUCCESS)
+			err = SimGpioTriggerImage(pCam);
+		if (err == SUCCESS)
+			err = SimCamReadPicture(pCam, 0, &pData);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to capture picture %lu! (%d)\n", __func__, (unsigned long) i, err);
+			return err;
+		}
+
+		pic.data = pData;
+		pic.width = pCam->width;
+		pic.height = pCam->height;
+		pic.type = OSC_PICTURE_GREYSCALE;
+		mean = AutoExpMeasure(pExp, &pic, HISTOGRAM_STEP, 0, 0);
+
+		bChanged = AutoExpUpdate(pExp);
+		if (bChanged)
+			SimCamSetShutterWidth(pCam, pExp->shutter);
+		if (pExp->bSettled && *pSettled == nFrames)
+			*pSettled = i;
+
+		printf("%lu %lu %u %lu %lu%s\n", (unsigned long) i, (unsigned long) pExp->frameShutter,
+				pExp->median, (unsigned long) mean, (unsigned long) pExp->shutter,
+				pExp->bSettled ? " settled" : "");
+	}
+	return SUCCESS;
+}
+
+int main(const int argc, const char * argv[])
+{
+	void *hFramework;
+	struct REPLAY source;
+	struct SIM_CAMERA cam;
+	struct AUTO_EXP autoExp;
+	uint32 i, settled;
+	OSC_ERR err;
+	
+	uint32 opt_shutter = 50000, opt_sourceShutter = 10000, opt_target = EXPOSURE_TARGET, opt_frames = 10;
+	const char *opt_input = EXPOSURE_INPUT;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: exposure [ -h ] [ -s <us> ] [ -f <us> ] [ -t <level> ] [ -n <n> ] [ <frames> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -s <us>: Shutter width to start with (default 50000).\n");
+			printf("    -f <us>: Shutter width the frames were taken with (default 10000).\n");
+			printf("    -t <level>: Grey level of the median to reach (default %d).\n", EXPOSURE_TARGET);
+			printf("    -n <n>: Pictures to capture (default 10).\n");
+			printf("    <frames>: Directory, list or bitmap of the frames (default " EXPOSURE_INPUT ").\n");
+			return 0;
+		} else if (argv[i][0] == '-' && strchr("sftn", argv[i][1]) != NULL && argv[i][2] == '\0') {
+			if (i + 1 >= argc) {
+				printf("Error: %s needs an argument.\n", argv[i]);
+				return 1;
+			}
+			if (argv[i][1] == 's') {
+				opt_shutter = atoi(argv[i + 1]);
+			} else if (argv[i][1] == 'f') {
+				opt_sourceShutter = atoi(argv[i + 1]);
+			} else if (argv[i][1] == 't') {
+				opt_target = atoi(argv[i + 1]);
+			} else {
+				opt_frames = atoi(argv[i + 1]);
+			}
+			i++;
+		} else if (argv[i][0] != '-') {
+			opt_input = argv[i];
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (opt_shutter < MIN_SHUTTER || opt_shutter > MAX_SHUTTER || opt_sourceShutter == 0 ||
+			opt_target == 0 || opt_target >= AUTO_EXP_SATURATED) {
+		printf("Error: The shutter widths must be from %d to %d us, the level from 1 to %d.\n",
+				MIN_SHUTTER, MAX_SHUTTER, AUTO_EXP_SATURATED - 1);
+		return 1;
+	}
+	
+	/* Create framework */
+	OscCreate(&hFramework);
+	
+	/* Load modules */
+	OscSupCreate(hFramework);
+	
+	err = ReplayOpen(&source, opt_input, 0);
+	if (err == SUCCESS) {
+		err = SimCamInit(&cam, &source, 0);
+		if (err == SUCCESS)
+			err = SimCamSetFrameBuffer(&cam, 0, (uint32) source.width * source.height, malloc((uint32) source.width * source.height));
+		if (err == SUCCESS) {
+			SimCamSetSourceShutter(&cam, opt_sourceShutter);
+			SimCamSetShutterWidth(&cam, opt_shutter);
+			err = AutoExpInit(&autoExp, opt_shutter, opt_target, MIN_SHUTTER, MAX_SHUTTER, EXPOSURE_LATENCY);
+		}
+		if (err == SUCCESS)
+			err = runExposure(&cam, &autoExp, opt_frames, &settled);
+		if (err == SUCCESS) {
+			if (settled < opt_frames) {
+				printf("Settled at picture %lu with %lu us, %lu changes.\n", (unsigned long) settled,
+						(unsigned long) autoExp.shutter, (unsigned long) autoExp.nChanges);
+			} else {
+				printf("Not settled after %lu pictures.\n", (unsigned long) opt_frames);
+			}
+		} else {
+			fprintf(stderr, "%s: ERROR: Unable to run the auto exposure! (%d)\n", __func__, err);
+		}
+		
+		free(cam.pBuffers[0]);
+		ReplayClose(&source);
+	}
+	
+	/* Unload modules */
+	OscSupDestroy(hFramework);
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	return err == SUCCESS ? 0 : 1;
+}
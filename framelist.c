@@ -0,0 +1,166 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file framelist.c
+ * @brief List of recorded frame files.
+ */
+
+#include "framelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*! @brief Maximum length of a line of a list file. */
+#define FRAME_LIST_MAX_LINE 512
+
+/*********************************************************************//*!
+ * @brief Check the extension of a file name.
+ *
+ * @param name File name.
+ * @param extension Extension with the dot, compared ignoring case.
+ * @return TRUE if the name ends with the extension
+ *//*********************************************************************/
+static int hasExtension(const char *name, const char *extension)
+{
+	size_t len = strlen(name), extLen = strlen(extension);
+
+	return len > extLen && strcasecmp(name + len - extLen, extension) == 0;
+}
+
+/*********************************************************************//*!
+ * @brief Check for a frame file name.
+ *
+ * @param name File name.
+ * @return TRUE if the name ends with .bmp or .raw
+ *//*********************************************************************/
+static int isFrame(const char *name)
+{
+	return hasExtension(name, ".bmp") || hasExtension(name, ".raw");
+}
+
+int FrameListIsRaw(const char *name)
+{
+	return hasExtension(name, ".raw");
+}
+
+/*********************************************************************//*!
+ * @brief Compare function of qsort for file names.
+ *
+ * @param pA First name.
+ * @param pB Second name.
+ * @return Negative, 0 or positive as strcmp
+ *//*********************************************************************/
+static int compareNames(const void *pA, const void *pB)
+{
+	return strcmp(*(char * const *) pA, *(char * const *) pB);
+}
+
+/*********************************************************************//*!
+ * @brief Add a file name to a list.
+ *
+ * @param pList List.
+ * @param pMaxNames Capacity of the list, updated.
+ * @param name File name.
+ * @return SUCCESS or -EOUT_OF_MEMORY
+ *//*********************************************************************/
+static OSC_ERR addName(struct FRAME_LIST *pList, uint32 *pMaxNames, const char *name)
+{
+	char **ppGrown;
+
+	if (pList->nNames == *pMaxNames) {
+		ppGrown = realloc(pList->ppNames, (2 * *pMaxNames + 16) * sizeof(char *));
+		if (ppGrown == NULL)
+			return -EOUT_OF_MEMORY;
+		pList->ppNames = ppGrown;
+		*pMaxNames = 2 * *pMaxNames + 16;
+	}
+
+	pList->ppNames[pList->nNames] = malloc(strlen(name) + 1);
+	if (pList->ppNames[pList->nNames] == NULL)
+		return -EOUT_OF_MEMORY;
+	strcpy(pList->ppNames[pList->nNames++], name);
+	return SUCCESS;
+}
+
+OSC_ERR FrameListLoad(struct FRAME_LIST *pList, const char *path)
+{
+	char line[FRAME_LIST_MAX_LINE];
+	uint32 maxNames = 0;
+	struct stat status;
+	struct dirent *pEntry;
+	DIR *pDir;
+	FILE *pFile;
+	size_t len;
+	OSC_ERR err = SUCCESS;
+
+	memset(pList, 0, sizeof(struct FRAME_LIST));
+	if (stat(path, &status) != 0) {
+		fprintf(stderr, "%s: ERROR: %s not found!\n", __func__, path);
+		return -EUNABLE_TO_OPEN_FILE;
+	}
+
+	if (S_ISDIR(status.st_mode)) {
+		pDir = opendir(path);
+		if (pDir == NULL)
+			return -EUNABLE_TO_OPEN_FILE;
+		while (err == SUCCESS && (pEntry = readdir(pDir)) != NULL) {
+			if (!isFrame(pEntry->d_name))
+				continue;
+			snprintf(line, sizeof(line), "%s/%s", path, pEntry->d_name);
+			err = addName(pList, &maxNames, line);
+		}
+		closedir(pDir);
+		if (pList->nNames > 0)
+			qsort(pList->ppNames, pList->nNames, sizeof(char *), compareNames);
+	} else if (isFrame(path)) {
+		err = addName(pList, &maxNames, path);
+	} else {
+		pFile = fopen(path, "r");
+		if (pFile == NULL)
+			return -EUNABLE_TO_OPEN_FILE;
+		while (err == SUCCESS && fgets(line, sizeof(line), pFile) != NULL) {
+			for (len = strlen(line); len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' '); len--)
+				line[len - 1] = '\0';
+			if (line[0] == '\0' || line[0] == '#')
+				continue;
+			err = addName(pList, &maxNames, line);
+		}
+		fclose(pFile);
+	}
+
+	if (err == SUCCESS && pList->nNames == 0) {
+		fprintf(stderr, "%s: ERROR: No frames in %s!\n", __func__, path);
+		err = -EINVALID_PARAMETER;
+	}
+	if (err != SUCCESS)
+		FrameListFree(pList);
+	return err;
+}
+
+void FrameListFree(struct FRAME_LIST *pList)
+{
+	uint32 i;
+
+	for (i = 0; i < pList->nNames; i++)
+		free(pList->ppNames[i]);
+	free(pList->ppNames);
+	memset(pList, 0, sizeof(struct FRAME_LIST));
+}
@@ -0,0 +1,65 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file framelist.h
+ * @brief List of recorded frame files.
+ * The frames of a directory are listed in name order, which is the time
+ * order of the timestamped recordings.
+ */
+
+#ifndef FRAMELIST_H_
+#define FRAMELIST_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief A list of frame files. */
+struct FRAME_LIST {
+	/*! @brief File names. */
+	char **ppNames;
+	uint32 nNames;
+};
+
+/*********************************************************************//*!
+ * @brief List the frame files of a path.
+ *
+ * The path is a directory, whose .bmp and .raw files are listed in name
+ * order, a single frame file, or a text file listing one frame file per
+ * line (lines starting with '#' are skipped).
+ *
+ * @param pList List to fill in.
+ * @param path Directory, frame file or list file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR FrameListLoad(struct FRAME_LIST *pList, const char *path);
+
+/*********************************************************************//*!
+ * @brief Check for a raw frame file name.
+ *
+ * @param name File name.
+ * @return TRUE if the name ends with .raw
+ *//*********************************************************************/
+int FrameListIsRaw(const char *name);
+
+/*********************************************************************//*!
+ * @brief Free a list.
+ *
+ * @param pList List.
+ *//*********************************************************************/
+void FrameListFree(struct FRAME_LIST *pList);
+
+#endif /* FRAMELIST_H_ */
@@ -0,0 +1,147 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file framepool.c
+ * @brief Pool of camera frame buffers with reference counted frames.
+ * References are taken and dropped by the capture loop as well as by
+ * consumer threads, so the counts are protected by a mutex. It is held
+ * for a few instructions only and never while a frame is processed.
+ */
+
+#include "framepool.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+OSC_ERR FramePoolInit(struct FRAME_POOL *pPool,
+		const uint8 nFrames,
+		const uint32 frameSize,
+		uint8 *pMemory)
+{
+	OSC_ERR err;
+	uint8 i;
+
+	if (nFrames < 1 || nFrames > FRAME_POOL_MAX_FRAMES ||
+			frameSize % sizeof(unsigned long) != 0 ||
+			((unsigned long) pMemory) % sizeof(unsigned long) != 0) {
+		return -EINVALID_PARAMETER;
+	}
+
+	memset(pPool, 0, sizeof(struct FRAME_POOL));
+	pPool->nFrames = nFrames;
+	pPool->frameSize = frameSize;
+
+	for (i = 0; i < nFrames; i++) {
+		pPool->frames[i].pBuffer = pMemory + (uint32) i * frameSize;
+		pPool->frames[i].pData = pPool->frames[i].pBuffer;
+		pPool->frames[i].id = i;
+		pPool->frames[i].pPool = pPool;
+
+		err = OscCamSetFrameBuffer(i, frameSize, pPool->frames[i].pData, TRUE);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to set frame buffer %u! (%d)\n", __func__, i, err);
+			return err;
+		}
+	}
+
+	if (pthread_mutex_init(&pPool->lock, NULL) != 0)
+		return -EDEVICE;
+	if (pthread_cond_init(&pPool->released, NULL) != 0) {
+		pthread_mutex_destroy(&pPool->lock);
+		return -EDEVICE;
+	}
+
+	return SUCCESS;
+}
+
+OSC_ERR FramePoolAcquire(struct FRAME_POOL *pPool,
+		const uint16 timeout,
+		struct FRAME **ppFrame)
+{
+	struct FRAME *pFrame = NULL;
+	struct timeval now;
+	struct timespec deadline;
+	int bWaited = FALSE;
+	uint8 i;
+
+	gettimeofday(&now, NULL);
+	deadline.tv_sec = now.tv_sec + timeout / 1000;
+	deadline.tv_nsec = now.tv_usec * 1000L + (timeout % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&pPool->lock);
+	while (1) {
+		for (i = 0; i < pPool->nFrames; i++) {
+			if (pPool->frames[i].refCount == 0) {
+				pFrame = &pPool->frames[i];
+				break;
+			}
+		}
+		if (pFrame != NULL)
+			break;
+
+		/* All buffers are referenced, wait for a consumer. */
+		bWaited = TRUE;
+		if (timeout == 0) {
+			pthread_cond_wait(&pPool->released, &pPool->lock);
+		} else if (pthread_cond_timedwait(&pPool->released, &pPool->lock, &deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+	if (pFrame != NULL) {
+		pFrame->refCount = 1;
+		pFrame->pData = pFrame->pBuffer;
+	}
+	if (bWaited)
+		pPool->nWaits++;
+	pthread_mutex_unlock(&pPool->lock);
+
+	*ppFrame = pFrame;
+	if (pFrame == NULL)
+		return -ETIMEOUT;
+
+	return SUCCESS;
+}
+
+void FrameRetain(struct FRAME *pFrame)
+{
+	pthread_mutex_lock(&pFrame->pPool->lock);
+	pFrame->refCount++;
+	pthread_mutex_unlock(&pFrame->pPool->lock);
+}
+
+void FrameRelease(struct FRAME *pFrame)
+{
+	struct FRAME_POOL *pPool = pFrame->pPool;
+
+	pthread_mutex_lock(&pPool->lock);
+	pFrame->refCount--;
+	if (pFrame->refCount == 0)
+		pthread_cond_signal(&pPool->released);
+	pthread_mutex_unlock(&pPool->lock);
+}
+
+void FramePoolDestroy(struct FRAME_POOL *pPool)
+{
+	pthread_cond_destroy(&pPool->released);
+	pthread_mutex_destroy(&pPool->lock);
+}
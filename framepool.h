@@ -0,0 +1,120 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file framepool.h
+ * @brief Pool of camera frame buffers with reference counted frames.
+ * The buffers are registered with the camera module once. A captured frame
+ * can be shared by several consumers, each holding a reference; the buffer
+ * is captured into again only after the last reference is released.
+ */
+
+#ifndef FRAMEPOOL_H_
+#define FRAMEPOOL_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <pthread.h>
+
+/*! @brief Maximum number of frame buffers in a pool. */
+#define FRAME_POOL_MAX_FRAMES 8
+
+/*! @brief A frame buffer of a pool. */
+struct FRAME {
+	/*! @brief Frame data, the buffer unless the frame is replayed. */
+	uint8 *pData;
+	/*! @brief Frame buffer registered with the camera module. */
+	uint8 *pBuffer;
+	/*! @brief Frame buffer ID registered with the camera module. */
+	uint8 id;
+	/*! @brief Number of references, 0 if the buffer is free. */
+	uint16 refCount;
+	/*! @brief Pool the frame belongs to. */
+	struct FRAME_POOL *pPool;
+};
+
+/*! @brief State of a frame pool. */
+struct FRAME_POOL {
+	/*! @brief Frame buffers. */
+	struct FRAME frames[FRAME_POOL_MAX_FRAMES];
+	uint8 nFrames;
+	/*! @brief Size of one frame buffer in bytes. */
+	uint32 frameSize;
+	/*! @brief Protects the reference counts. */
+	pthread_mutex_t lock;
+	/*! @brief Signalled when a buffer becomes free. */
+	pthread_cond_t released;
+	/*! @brief Number of acquisitions which had to wait for a free buffer. */
+	uint32 nWaits;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a pool and register its buffers with the camera module.
+ *
+ * The buffers are registered as frame buffer IDs 0 to nFrames - 1.
+ * Requires the cam module to be loaded.
+ *
+ * @param pPool Pool to initialize.
+ * @param nFrames Number of frame buffers (1 .. FRAME_POOL_MAX_FRAMES).
+ * @param frameSize Size of one frame buffer in bytes, a multiple of the
+ * word size.
+ * @param pMemory Word aligned memory of nFrames * frameSize bytes.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR FramePoolInit(struct FRAME_POOL *pPool,
+		const uint8 nFrames,
+		const uint32 frameSize,
+		uint8 *pMemory);
+
+/*********************************************************************//*!
+ * @brief Take a free buffer out of the pool.
+ *
+ * Waits for a consumer to release a frame if all buffers are in use.
+ *
+ * @param pPool Pool.
+ * @param timeout Time to wait in ms (0 = infinite).
+ * @param ppFrame The acquired frame, holding one reference.
+ * @return SUCCESS or -ETIMEOUT if no buffer became free
+ *//*********************************************************************/
+OSC_ERR FramePoolAcquire(struct FRAME_POOL *pPool,
+		const uint16 timeout,
+		struct FRAME **ppFrame);
+
+/*********************************************************************//*!
+ * @brief Add a reference to a frame, e.g. before handing it to another
+ * consumer.
+ *
+ * @param pFrame Frame with at least one reference.
+ *//*********************************************************************/
+void FrameRetain(struct FRAME *pFrame);
+
+/*********************************************************************//*!
+ * @brief Drop a reference to a frame.
+ *
+ * The buffer returns to the pool when the last reference is dropped.
+ *
+ * @param pFrame Frame with at least one reference.
+ *//*********************************************************************/
+void FrameRelease(struct FRAME *pFrame);
+
+/*********************************************************************//*!
+ * @brief Release the resources of a pool.
+ *
+ * @param pPool Pool without referenced frames.
+ *//*********************************************************************/
+void FramePoolDestroy(struct FRAME_POOL *pPool);
+
+#endif /* FRAMEPOOL_H_ */
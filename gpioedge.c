@@ -0,0 +1,299 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file gpioedge.c
+ * @brief Edges of the GPIO inputs, delivered to a waiting thread.
+ * The replaying thread sleeps on the condition until the next step is
+ * due, so a stop request ends it at once.
+ */
+
+#include "gpioedge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/*! @brief Maximum length of a line of a replay file. */
+#define GPIO_EDGE_MAX_LINE 128
+
+/*********************************************************************//*!
+ * @brief Get the time a number of microseconds after a start time.
+ *
+ * @param pStart Start time.
+ * @param us Microseconds after the start.
+ * @param pTime The time.
+ *//*********************************************************************/
+static void timeAfter(const struct timeval *pStart, const unsigned long long us, struct timespec *pTime)
+{
+	unsigned long long usecs = (unsigned long long) pStart->tv_usec + us;
+
+	pTime->tv_sec = pStart->tv_sec + usecs / 1000000;
+	pTime->tv_nsec = (usecs % 1000000) * 1000L;
+}
+
+/*********************************************************************//*!
+ * @brief Queue the edges between the current and new levels.
+ *
+ * @param pEdges Watcher, its lock held.
+ * @param levels New levels of IN1 and IN2.
+ * @param cycles Cycle count when the levels were read.
+ * @param window Cycles since the levels were read before.
+ *//*********************************************************************/
+static void addEdges(struct GPIO_EDGES *pEdges, const int levels[2], const uint32 cycles, const uint32 window)
+{
+	static const enum EnGpios pins[2] = { GPIO_IN1, GPIO_IN2 };
+	struct GPIO_EDGE *pEdge;
+	uint8 i;
+
+	for (i = 0; i < 2; i++) {
+		if (levels[i] == pEdges->levels[i])
+			continue;
+		pEdges->levels[i] = levels[i];
+
+		if (pEdges->count == GPIO_EDGE_QUEUE) {
+			pEdges->nLost++;
+			continue;
+		}
+		pEdge = &pEdges->queue[(pEdges->head + pEdges->count++) % GPIO_EDGE_QUEUE];
+		pEdge->pin = pins[i];
+		pEdge->bLevel = levels[i];
+		pEdge->cycles = cycles;
+		pEdge->window = window;
+		pthread_cond_broadcast(&pEdges->changed);
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Thread replaying the steps of a file.
+ *
+ * @param pArg Watcher.
+ * @return NULL
+ *//*********************************************************************/
+static void * replayThread(void *pArg)
+{
+	struct GPIO_EDGES *pEdges = (struct GPIO_EDGES *) pArg;
+	const uint32 period = pEdges->pSteps[pEdges->nSteps - 1].time + 1;
+	unsigned long long round = 0;
+	struct timeval start;
+	struct timespec due;
+	uint32 i = 0;
+
+	gettimeofday(&start, NULL);
+	pthread_mutex_lock(&pEdges->lock);
+	while (!pEdges->bStop) {
+		timeAfter(&start, (round * period + pEdges->pSteps[i].time) * GPIO_EDGE_TICK_US, &due);
+		if (pthread_cond_timedwait(&pEdges->changed, &pEdges->lock, &due) != ETIMEDOUT)
+			continue;
+
+		addEdges(pEdges, pEdges->pSteps[i].levels, OscSupCycGet(), 0);
+		if (++i == pEdges->nSteps) {
+			i = 0;
+			round++;
+		}
+	}
+	pthread_mutex_unlock(&pEdges->lock);
+
+	return NULL;
+}
+
+/*********************************************************************//*!
+ * @brief Thread sampling the inputs.
+ *
+ * @param pArg Watcher.
+ * @return NULL
+ *//*********************************************************************/
+static void * sampleThread(void *pArg)
+{
+	struct GPIO_EDGES *pEdges = (struct GPIO_EDGES *) pArg;
+	int levels[2], bStop = FALSE;
+	uint32 cycles, window;
+
+	while (!bStop) {
+		OscGpioRead(GPIO_IN1, &levels[0]);
+		OscGpioRead(GPIO_IN2, &levels[1]);
+		cycles = OscSupCycGet();
+
+		pthread_mutex_lock(&pEdges->lock);
+		window = (cycles - pEdges->lastSample) & 0xFFFFFFFFUL;
+		pEdges->lastSample = cycles;
+		pEdges->nIntervals++;
+		pEdges->sumIntervals += window;
+		if (window > pEdges->maxInterval)
+			pEdges->maxInterval = window;
+		addEdges(pEdges, levels, cycles, window);
+		bStop = pEdges->bStop;
+		pthread_mutex_unlock(&pEdges->lock);
+
+		usleep(GPIO_EDGE_POLL_US);
+	}
+
+	return NULL;
+}
+
+/*********************************************************************//*!
+ * @brief Read the steps of a replay file.
+ *
+ * @param pEdges Watcher to add the steps to.
+ * @param fileName Replay file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR readSteps(struct GPIO_EDGES *pEdges, const char *fileName)
+{
+	char line[GPIO_EDGE_MAX_LINE];
+	struct GPIO_EDGE_STEP step, *pGrown;
+	uint32 maxSteps = 0;
+	unsigned long time;
+	FILE *pFile;
+	OSC_ERR err = SUCCESS;
+
+	pFile = fopen(fileName, "r");
+	if (pFile == NULL) {
+		fprintf(stderr, "%s: ERROR: Unable to open %s!\n", __func__, fileName);
+		return -EUNABLE_TO_OPEN_FILE;
+	}
+
+	while (err == SUCCESS && fgets(line, sizeof(line), pFile) != NULL) {
+		if (line[0] != '@')
+			continue;
+		if (sscanf(line + 1, "%lu %d %d", &time, &step.levels[0], &step.levels[1]) != 3 ||
+				(pEdges->nSteps > 0 && time < pEdges->pSteps[pEdges->nSteps - 1].time)) {
+			fprintf(stderr, "%s: ERROR: Invalid step in %s: %s", __func__, fileName, line);
+			err = -EINVALID_PARAMETER;
+			break;
+		}
+		step.time = time;
+		step.levels[0] = step.levels[0] != 0;
+		step.levels[1] = step.levels[1] != 0;
+
+		if (pEdges->nSteps == maxSteps) {
+			pGrown = realloc(pEdges->pSteps, (2 * maxSteps + 16) * sizeof(struct GPIO_EDGE_STEP));
+			if (pGrown == NULL) {
+				err = -EOUT_OF_MEMORY;
+				break;
+			}
+			pEdges->pSteps = pGrown;
+			maxSteps = 2 * maxSteps + 16;
+		}
+		pEdges->pSteps[pEdges->nSteps++] = step;
+	}
+	fclose(pFile);
+
+	if (err == SUCCESS && pEdges->nSteps == 0) {
+		fprintf(stderr, "%s: ERROR: No steps in %s!\n", __func__, fileName);
+		err = -EINVALID_PARAMETER;
+	}
+	return err;
+}
+
+OSC_ERR GpioEdgesStart(struct GPIO_EDGES *pEdges, const char *replayFile)
+{
+	OSC_ERR err;
+
+	memset(pEdges, 0, sizeof(struct GPIO_EDGES));
+	if (replayFile != NULL) {
+		err = readSteps(pEdges, replayFile);
+		if (err != SUCCESS) {
+			free(pEdges->pSteps);
+			pEdges->pSteps = NULL;
+			return err;
+		}
+	} else {
+		/* Edges are changes from the levels at the start */
+		OscGpioRead(GPIO_IN1, &pEdges->levels[0]);
+		OscGpioRead(GPIO_IN2, &pEdges->levels[1]);
+		pEdges->lastSample = OscSupCycGet();
+	}
+
+	pthread_mutex_init(&pEdges->lock, NULL);
+	pthread_cond_init(&pEdges->changed, NULL);
+	if (pthread_create(&pEdges->thread, NULL, pEdges->pSteps != NULL ? replayThread : sampleThread, pEdges) != 0) {
+		pthread_cond_destroy(&pEdges->changed);
+		pthread_mutex_destroy(&pEdges->lock);
+		free(pEdges->pSteps);
+		pEdges->pSteps = NULL;
+		return -EDEVICE;
+	}
+
+	return SUCCESS;
+}
+
+OSC_ERR GpioEdgesWait(struct GPIO_EDGES *pEdges, struct GPIO_EDGE *pEdge, const uint16 timeout)
+{
+	struct timeval now;
+	struct timespec deadline;
+	OSC_ERR err = SUCCESS;
+
+	gettimeofday(&now, NULL);
+	timeAfter(&now, (unsigned long long) timeout * 1000, &deadline);
+
+	pthread_mutex_lock(&pEdges->lock);
+	while (pEdges->count == 0) {
+		if (timeout == 0) {
+			pthread_cond_wait(&pEdges->changed, &pEdges->lock);
+		} else if (pthread_cond_timedwait(&pEdges->changed, &pEdges->lock, &deadline) == ETIMEDOUT) {
+			err = -ETIMEOUT;
+			break;
+		}
+	}
+	if (err == SUCCESS) {
+		*pEdge = pEdges->queue[pEdges->head];
+		pEdges->head = (pEdges->head + 1) % GPIO_EDGE_QUEUE;
+		pEdges->count--;
+	}
+	pthread_mutex_unlock(&pEdges->lock);
+
+	return err;
+}
+
+void GpioEdgesPrintStats(struct GPIO_EDGES *pEdges)
+{
+	uint32 n, mean = 0, max;
+
+	pthread_mutex_lock(&pEdges->lock);
+	n = pEdges->nIntervals;
+	if (n > 0)
+		mean = (uint32) (pEdges->sumIntervals / n);
+	max = pEdges->maxInterval;
+	pEdges->nIntervals = 0;
+	pEdges->sumIntervals = 0;
+	pEdges->maxInterval = 0;
+	pthread_mutex_unlock(&pEdges->lock);
+
+	if (pEdges->pSteps != NULL) {
+		printf("Inputs: replayed, edges seen when due\n");
+	} else if (n > 0) {
+		printf("Inputs: %lu samples, every %lu us on average, at most %lu us apart: edges are seen up to this late\n",
+				n, OscSupCycToMicroSecs(mean), OscSupCycToMicroSecs(max));
+	}
+}
+
+void GpioEdgesStop(struct GPIO_EDGES *pEdges)
+{
+	pthread_mutex_lock(&pEdges->lock);
+	pEdges->bStop = TRUE;
+	pthread_cond_broadcast(&pEdges->changed);
+	pthread_mutex_unlock(&pEdges->lock);
+	pthread_join(pEdges->thread, NULL);
+
+	pthread_cond_destroy(&pEdges->changed);
+	pthread_mutex_destroy(&pEdges->lock);
+	free(pEdges->pSteps);
+	pEdges->pSteps = NULL;
+}
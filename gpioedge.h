@@ -0,0 +1,131 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file gpioedge.h
+ * @brief Edges of the GPIO inputs, delivered to a waiting thread.
+ * A thread watches the inputs IN1 and IN2 and queues each change of
+ * level, stamped with the cycle count when it was seen. The application
+ * blocks until an edge arrives instead of reading the pins in its loop.
+ * The inputs are sampled every GPIO_EDGE_POLL_US, as the gpio module
+ * offers no interrupts; on the host they may be replayed from a file of
+ * the format of gpio_in.txt instead. An edge is seen up to one sampling
+ * interval after it happened. The sleep between the samples lasts at
+ * least a scheduler tick on uClinux, much longer than GPIO_EDGE_POLL_US,
+ * so the real intervals are measured and reported as the error bound of
+ * the stamps.
+ */
+
+#ifndef GPIOEDGE_H_
+#define GPIOEDGE_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <pthread.h>
+
+/*! @brief Edges queued until the application takes them. */
+#define GPIO_EDGE_QUEUE 16
+/*! @brief Sampling interval of the inputs in us. */
+#define GPIO_EDGE_POLL_US 200
+/*! @brief Time unit of the replayed steps in us. */
+#define GPIO_EDGE_TICK_US 1000
+
+/*! @brief A change of level of an input. */
+struct GPIO_EDGE {
+	/*! @brief Input, GPIO_IN1 or GPIO_IN2. */
+	enum EnGpios pin;
+	/*! @brief New level, TRUE on a rising edge. */
+	int bLevel;
+	/*! @brief Cycle count when the edge was seen. */
+	uint32 cycles;
+	/*! @brief Cycles since the sample before, in which the edge happened
+	 * (0 if replayed). */
+	uint32 window;
+};
+
+/*! @brief A replayed step: from this time on the inputs have these levels. */
+struct GPIO_EDGE_STEP {
+	/*! @brief Time in GPIO_EDGE_TICK_US from the start. */
+	uint32 time;
+	/*! @brief Levels of IN1 and IN2. */
+	int levels[2];
+};
+
+/*! @brief State of an edge watcher. */
+struct GPIO_EDGES {
+	/*! @brief Replayed steps, NULL if the inputs are sampled. */
+	struct GPIO_EDGE_STEP *pSteps;
+	uint32 nSteps;
+	/*! @brief Current levels of IN1 and IN2. */
+	int levels[2];
+	/*! @brief Queued edges. */
+	struct GPIO_EDGE queue[GPIO_EDGE_QUEUE];
+	uint8 head, count;
+	/*! @brief Edges lost because the queue was full. */
+	uint32 nLost;
+	/*! @brief Cycle count of the last sample, intervals between the
+	 * samples since the last statistics and the longest one. */
+	uint32 lastSample, nIntervals, maxInterval;
+	unsigned long long sumIntervals;
+	/*! @brief Protects the queue, signalled when an edge is added or the
+	 * thread is to stop. */
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	/*! @brief Watching thread and its stop request. */
+	pthread_t thread;
+	int bStop;
+};
+
+/*********************************************************************//*!
+ * @brief Start watching the inputs.
+ *
+ * A replay file holds a header line starting with '!' and one line per
+ * step "@ <time> <IN1> <IN2>", times in GPIO_EDGE_TICK_US and ascending.
+ * The steps are repeated, the first one again one tick after the last.
+ * Without a replay file the inputs are sampled, which requires the gpio
+ * module to be loaded.
+ *
+ * @param pEdges Watcher to initialize.
+ * @param replayFile File of steps to replay, NULL to sample the inputs.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR GpioEdgesStart(struct GPIO_EDGES *pEdges, const char *replayFile);
+
+/*********************************************************************//*!
+ * @brief Wait for the next edge.
+ *
+ * @param pEdges Watcher.
+ * @param pEdge The edge, oldest first.
+ * @param timeout Time to wait in ms (0 = infinite).
+ * @return SUCCESS or -ETIMEOUT
+ *//*********************************************************************/
+OSC_ERR GpioEdgesWait(struct GPIO_EDGES *pEdges, struct GPIO_EDGE *pEdge, const uint16 timeout);
+
+/*********************************************************************//*!
+ * @brief Print and reset the intervals the inputs were sampled at.
+ *
+ * @param pEdges Watcher.
+ *//*********************************************************************/
+void GpioEdgesPrintStats(struct GPIO_EDGES *pEdges);
+
+/*********************************************************************//*!
+ * @brief Stop watching and free the watcher.
+ *
+ * @param pEdges Watcher.
+ *//*********************************************************************/
+void GpioEdgesStop(struct GPIO_EDGES *pEdges);
+
+#endif /* GPIOEDGE_H_ */
@@ -19,9 +19,16 @@
 /*!@file hello-world.c
  * @brief Simple hello-world application.
  * Initialize Framework, take a picture, modify and save it to a file.
+ * Unless a shutter width is given, the exposure is corrected from the
+ * histogram of the pictures taken until it is right.
  */
 
 #include "oscar/staging/inc/oscar.h"
+#include "autoexp.h"
+#include "debayer.h"
+#include "bmpmap.h"
+#include "prof.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -33,6 +40,134 @@
 #define HTTP_ROOT "/home/httpd/"
 #endif
 
+/* Shutter width the auto exposure starts with [us] */
+#define EXPOSURE_START 20000
+/* Grey level of the median the auto exposure brings the picture to */
+#define EXPOSURE_TARGET 100
+/* Range of the auto exposure [us] */
+#define MIN_SHUTTER_WIDTH 10
+#define MAX_SHUTTER_WIDTH 200000
+/* Pictures taken until a new shutter width takes effect */
+#define EXPOSURE_LATENCY 1
+/* Pictures taken at most until the exposure is right */
+#define EXPOSURE_MAX_FRAMES 8
+/* Distance of the pixels and rows of the histogram */
+#define EXPOSURE_STEP 4
+
+/*! @brief Profile of the steps, printed with -p. */
+static struct PROF prof;
+static struct PROF_TIMER *pCaptureTimer, *pDebayerTimer, *pWriteTimer;
+
+/*! @brief Trace of the steps, written with -t. */
+static struct TRACE trace;
+static struct TRACE_RING *pTrace;
+
+/*********************************************************************//*!
+ * @brief Take a picture into frame buffer 0.
+ * 
+ * @param ppPic The picture.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR takePicture(uint8 **ppPic)
+{
+	OSC_ERR err;
+	
+	err = OscCamSetupCapture(0);
+	if (err == SUCCESS)
+		err = OscGpioTriggerImage();
+	if (err == SUCCESS)
+		err = OscCamReadPicture(0, (void *) ppPic, 0, 0);
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Write a debayered strip to a bitmap file.
+ * 
+ * @param pArg Bitmap writer.
+ * @param y First row of the strip.
+ * @param nRows Number of rows in the strip.
+ * @param pStrip BGR pixels of the strip.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR writeStrip(void *pArg, const uint16 y, const uint16 nRows, const uint8 *pStrip)
+{
+	uint32 start = ProfStart();
+	OSC_ERR err;
+	
+	err = BmpWriterPutRows((struct BMP_WRITER *) pArg, y, nRows, pStrip);
+	ProfStop(pWriteTimer, start);
+	TRACE_STOP(pTrace, "bmp write", start);
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Consume a debayered strip without doing anything.
+ * 
+ * @param pArg Unused.
+ * @param y First row of the strip.
+ * @param nRows Number of rows in the strip.
+ * @param pStrip BGR pixels of the strip.
+ * @return SUCCESS
+ *//*********************************************************************/
+static OSC_ERR dropStrip(void *pArg, const uint16 y, const uint16 nRows, const uint8 *pStrip)
+{
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Time the full frame OscVisDebayer against the strip wise modes.
+ * 
+ * @param rawPic Raw picture.
+ * @param enBayerOrder Bayer order of the raw picture.
+ * @param n Number of rounds.
+ * @return 0 on success
+ *//*********************************************************************/
+static int benchmark(const uint8 *rawPic, const enum EnBayerOrder enBayerOrder, const uint32 n)
+{
+	static uint8 colorPic[3 * OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
+	static uint8 strip[3 * OSC_CAM_MAX_IMAGE_WIDTH * DEBAYER_STRIP_ROWS];
+	struct DEBAYER full, half, roi;
+	uint32 i, cycles;
+	uint32 usVis = 0, usFull = 0, usStrips = 0, usHalf = 0, usRoi = 0;
+	
+	DebayerInit(&full, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, FALSE);
+	DebayerInit(&half, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, TRUE);
+	DebayerInit(&roi, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, FALSE);
+	/* The centre quarter of the frame. */
+	DebayerSetRoi(&roi, OSC_CAM_MAX_IMAGE_WIDTH / 4, OSC_CAM_MAX_IMAGE_HEIGHT / 4, OSC_CAM_MAX_IMAGE_WIDTH / 2, OSC_CAM_MAX_IMAGE_HEIGHT / 2);
+	
+	for (i = 0; i < n; i += 1)
+	{
+		cycles = OscSupCycGet();
+		OscVisDebayer(rawPic, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, colorPic);
+		usVis += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		DebayerRun(&full, rawPic, colorPic, DEBAYER_STRIP_ROWS, NULL, NULL);
+		usFull += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		DebayerRun(&full, rawPic, strip, DEBAYER_STRIP_ROWS, dropStrip, NULL);
+		usStrips += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		DebayerRun(&half, rawPic, strip, DEBAYER_STRIP_ROWS, dropStrip, NULL);
+		usHalf += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+		
+		cycles = OscSupCycGet();
+		DebayerRun(&roi, rawPic, strip, DEBAYER_STRIP_ROWS, dropStrip, NULL);
+		usRoi += OscSupCycToMicroSecs(OscSupCycGet() - cycles);
+	}
+	
+	printf("OscVisDebayer, full frame: %lu us\n", usVis / n);
+	printf("DebayerRun, full frame:    %lu us\n", usFull / n);
+	printf("DebayerRun, strips:        %lu us\n", usStrips / n);
+	printf("DebayerRun, half size:     %lu us\n", usHalf / n);
+	printf("DebayerRun, centre region: %lu us\n", usRoi / n);
+	
+	return 0;
+}
+
 /*********************************************************************//*!
  * @brief Program entry.
  * 
@@ -51,15 +186,28 @@ int main(const int argc, const char * argv[])
 #endif
 
 	static uint8 frameBuffer[OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
-	static uint8 colorPic[3 * OSC_CAM_MAX_IMAGE_WIDTH * OSC_CAM_MAX_IMAGE_HEIGHT];
+	/* Debayered strips are written to the file while still in the cache. */
+	static uint8 strip[3 * OSC_CAM_MAX_IMAGE_WIDTH * DEBAYER_STRIP_ROWS];
 	
 	uint16 i;
+	uint32 start;
 	uint8 * rawPic = NULL;
 	struct OSC_PICTURE pic;
 	enum EnBayerOrder enBayerOrder;
+	struct DEBAYER debayer;
+	struct BMP_WRITER writer;
+	struct AUTO_EXP autoExp;
+	uint16 greenX;
+	int ret = 0;
 	
-	int32 opt_shutterWidth = 50000;
+	int32 opt_shutterWidth = 0;
 	bool opt_debayer = false;
+	bool opt_half = false;
+	bool opt_roi = false;
+	unsigned int opt_roiX, opt_roiY, opt_roiWidth, opt_roiHeight;
+	uint32 opt_benchmark = 0;
+	bool opt_profile = false;
+	const char *opt_trace = NULL;
 	
 	for (i = 1; i < argc; i += 1)
 	{
@@ -77,12 +225,57 @@ int main(const int argc, const char * argv[])
 			}
 			opt_shutterWidth = atoi(argv[i]);
 		}
+		else if (strcmp(argv[i], "-H") == 0)
+		{
+			opt_debayer = true;
+			opt_half = true;
+		}
+		else if (strcmp(argv[i], "-r") == 0)
+		{
+			i += 1;
+			if (i >= argc || sscanf(argv[i], "%u,%u,%u,%u", &opt_roiX, &opt_roiY, &opt_roiWidth, &opt_roiHeight) != 4)
+			{
+				printf("Error: -r needs an argument <x>,<y>,<width>,<height>.\n");
+				return 1;
+			}
+			opt_debayer = true;
+			opt_roi = true;
+		}
+		else if (strcmp(argv[i], "-b") == 0)
+		{
+			i += 1;
+			if (i >= argc)
+			{
+				printf("Error: -b needs an argument.\n");
+				return 1;
+			}
+			opt_benchmark = atoi(argv[i]);
+		}
+		else if (strcmp(argv[i], "-p") == 0)
+		{
+			opt_profile = true;
+		}
+		else if (strcmp(argv[i], "-t") == 0)
+		{
+			i += 1;
+			if (i >= argc)
+			{
+				printf("Error: -t needs an argument.\n");
+				return 1;
+			}
+			opt_trace = argv[i];
+		}
 		else if (strcmp(argv[i], "-h") == 0)
 		{
-			printf("Usage: hello-world [ -h ] [ -d ] [ -s <shutter-width> ]\n");
-			printf("    -h: Prints this help.");
-			printf("    -d: Debayers the image.");
-			printf("    -s <shutter-width>: Sets the shutter with in us.");
+			printf("Usage: hello-world [ -h ] [ -d ] [ -H ] [ -r <x>,<y>,<width>,<height> ] [ -s <shutter-width> ] [ -b <n> ] [ -p ] [ -t <file> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -d: Debayers the image.\n");
+			printf("    -H: Debayers the image at half resolution.\n");
+			printf("    -r <x>,<y>,<width>,<height>: Debayers only this region of the image.\n");
+			printf("    -s <shutter-width>: Sets the shutter with in us instead of correcting it.\n");
+			printf("    -b <n>: Times the debayering modes over n rounds.\n");
+			printf("    -p: Prints the time taken by each step.\n");
+			printf("    -t <file>: Writes a trace of the steps for chrome://tracing.\n");
 		}
 		else
 		{
@@ -99,6 +292,15 @@ int main(const int argc, const char * argv[])
 	OscCamCreate(hFramework);
 	OscVisCreate(hFramework);
 	OscGpioCreate(hFramework);
+	OscSupCreate(hFramework);
+	
+	ProfInit(&prof);
+	pCaptureTimer = ProfTimer(&prof, "capture");
+	pDebayerTimer = ProfTimer(&prof, "debayer and write");
+	pWriteTimer = ProfTimer(&prof, "bmp write");
+	TraceInit(&trace, &prof);
+	pTrace = TraceRing(&trace, "main");
+	TraceEnable(&trace, opt_trace != NULL);
 	
 #if defined(OSC_HOST) || defined(OSC_SIM)
 	/* Setup file name reader (for host compiled version); read constant image */
@@ -107,55 +309,112 @@ int main(const int argc, const char * argv[])
 #endif
 	
 	/* Configure camera */
-	OscCamSetShutterWidth(opt_shutterWidth);
+	OscCamSetShutterWidth(opt_shutterWidth > 0 ? opt_shutterWidth : EXPOSURE_START);
 	OscCamSetAreaOfInterest(0, 0, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT);
 	OscCamSetFrameBuffer(0, OSC_CAM_MAX_IMAGE_WIDTH*OSC_CAM_MAX_IMAGE_HEIGHT, frameBuffer, TRUE);
 	
-	/* Take a picture */
-	OscCamSetupCapture(0);
-#if defined(OSC_TARGET)
-	/* This hacks around the camera chip activating settings only after the next image taken. */
-	OscGpioTriggerImage();
-	OscCamReadPicture(0, (void *) &rawPic, 0, 0);
-	OscCamSetShutterWidth(48);
-	
-	OscCamSetupCapture(0);
-	OscGpioTriggerImage();
-#endif
-	OscCamReadPicture(0, (void *) &rawPic, 0, 0);
+	pic.width = OSC_CAM_MAX_IMAGE_WIDTH;
+	pic.height = OSC_CAM_MAX_IMAGE_HEIGHT;
 	
-	/* Debayer (transform to colored picture) */
-	/* OscCamGetBayerOrder(&enBayerOrder, 0, 0); */
-	/* OscVisDebayer((uint8*)&rawPic, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, (uint8*)&colorPic);*/
+	/* Take a picture */
+	start = ProfStart();
+	if (opt_shutterWidth > 0)
+	{
+		/* The camera chip activates settings only after the next image taken. */
+		for (i = 0; i <= EXPOSURE_LATENCY; i += 1)
+		{
+			takePicture(&rawPic);
+		}
+	}
+	else
+	{
+		/* Correct the exposure from the histogram of the green pixels of
+		 * the mosaic (all pixels on a monochrome sensor). */
+		OscCamGetBayerOrder(&enBayerOrder, 0, 0);
+		greenX = enBayerOrder == ROW_GBGB || enBayerOrder == ROW_GRGR ? 0 : 1;
+		AutoExpInit(&autoExp, EXPOSURE_START, EXPOSURE_TARGET, MIN_SHUTTER_WIDTH, MAX_SHUTTER_WIDTH, EXPOSURE_LATENCY);
+		for (i = 0; i < EXPOSURE_MAX_FRAMES; i += 1)
+		{
+			takePicture(&rawPic);
+			pic.data = rawPic;
+			AutoExpMeasure(&autoExp, &pic, EXPOSURE_STEP, greenX, 0);
+			if (AutoExpUpdate(&autoExp))
+			{
+				OscCamSetShutterWidth(autoExp.shutter);
+			}
+			else if (autoExp.bSettled)
+			{
+				break;
+			}
+		}
+	}
+	ProfStop(pCaptureTimer, start);
+	TRACE_STOP(pTrace, "capture", start);
 	
 	/* Write picture to file */
-	pic.width = OSC_CAM_MAX_IMAGE_WIDTH;
-	pic.height = OSC_CAM_MAX_IMAGE_HEIGHT;
 	
-	if (opt_debayer)
+	if (opt_benchmark > 0)
 	{
 		OscCamGetBayerOrder(&enBayerOrder, 0, 0);
-		OscVisDebayer(frameBuffer, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, colorPic);
-		pic.type = OSC_PICTURE_BGR_24;
-		pic.data = colorPic;
+		ret = benchmark(rawPic, enBayerOrder, opt_benchmark);
+	}
+	else if (opt_debayer)
+	{
+		/* Debayer strip by strip straight into the file, no colour picture buffer is needed. */
+		OscCamGetBayerOrder(&enBayerOrder, 0, 0);
+		if (DebayerInit(&debayer, OSC_CAM_MAX_IMAGE_WIDTH, OSC_CAM_MAX_IMAGE_HEIGHT, enBayerOrder, opt_half) != SUCCESS ||
+			(opt_roi && DebayerSetRoi(&debayer, opt_roiX, opt_roiY, opt_roiWidth, opt_roiHeight) != SUCCESS))
+		{
+			printf("Error: Invalid region of interest.\n");
+			ret = 1;
+		}
+		else if (BmpWriterOpen(&writer, HTTP_ROOT "hello-world.bmp~", debayer.outWidth, debayer.outHeight, OSC_PICTURE_BGR_24) == SUCCESS)
+		{
+			start = ProfStart();
+			DebayerRun(&debayer, rawPic, strip, DEBAYER_STRIP_ROWS, writeStrip, &writer);
+			ProfStop(pDebayerTimer, start);
+			TRACE_STOP(pTrace, "debayer and write", start);
+			BmpWriterClose(&writer);
+			rename(HTTP_ROOT "hello-world.bmp~", HTTP_ROOT "hello-world.bmp");
+		}
 	}
 	else
 	{
 		pic.type = OSC_PICTURE_GREYSCALE;
 		pic.data = rawPic;
+		
+		start = ProfStart();
+		OscBmpWrite(&pic, HTTP_ROOT "hello-world.bmp~");
+		ProfStop(pWriteTimer, start);
+		TRACE_STOP(pTrace, "bmp write", start);
+		rename(HTTP_ROOT "hello-world.bmp~", HTTP_ROOT "hello-world.bmp");
 	}
-
-	OscBmpWrite(&pic, HTTP_ROOT "hello-world.bmp~");
-	rename(HTTP_ROOT "hello-world.bmp~", HTTP_ROOT "hello-world.bmp");
+	
+	if (opt_profile)
+	{
+		if (opt_shutterWidth == 0)
+		{
+			printf("Exposure: %lu us, median %u, %s after %u pictures\n", (unsigned long) autoExp.frameShutter,
+					autoExp.median, autoExp.bSettled ? "settled" : "not settled", i < EXPOSURE_MAX_FRAMES ? i + 1 : i);
+		}
+		ProfReport(&prof, stdout);
+	}
+	if (opt_trace != NULL)
+	{
+		TraceDump(&trace, opt_trace);
+	}
+	TraceDestroy(&trace);
+	ProfDestroy(&prof);
 	
 	/* Destroy modules */
 	OscBmpDestroy(hFramework);
 	OscCamDestroy(hFramework);
 	OscVisDestroy(hFramework);
 	OscGpioDestroy(hFramework);
+	OscSupDestroy(hFramework);
 	
 	/* Destroy framework */
 	OscDestroy(hFramework);
 	
-	return 0;
+	return ret;
 }
@@ -0,0 +1,88 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file history.c
+ * @brief Ring buffer of the last values with running statistics.
+ */
+
+#include "history.h"
+
+OSC_ERR HistoryInit(struct HISTORY *pHist, const uint16 length)
+{
+	if (length < 1 || length > HISTORY_MAX_LENGTH)
+		return -EINVALID_PARAMETER;
+
+	pHist->length = length;
+	HistoryReset(pHist);
+
+	return SUCCESS;
+}
+
+void HistoryReset(struct HISTORY *pHist)
+{
+	pHist->count = 0;
+	pHist->index = 0;
+	pHist->sum = 0;
+	pHist->sumSquares = 0;
+}
+
+void HistoryAdd(struct HISTORY *pHist, const uint32 value)
+{
+	uint32 old;
+
+	if (pHist->count == pHist->length) {
+		/* Replace the oldest value. */
+		old = pHist->values[pHist->index];
+		pHist->sum -= old;
+		pHist->sumSquares -= (unsigned long long) old * old;
+	} else {
+		pHist->count++;
+	}
+
+	pHist->values[pHist->index] = value;
+	pHist->sum += value;
+	pHist->sumSquares += (unsigned long long) value * value;
+
+	pHist->index++;
+	if (pHist->index == pHist->length)
+		pHist->index = 0;
+}
+
+int HistoryIsFull(const struct HISTORY *pHist)
+{
+	return pHist->count == pHist->length;
+}
+
+uint32 HistoryMean(const struct HISTORY *pHist)
+{
+	if (pHist->count == 0)
+		return 0;
+
+	return (uint32) (pHist->sum / pHist->count);
+}
+
+uint32 HistoryVariance(const struct HISTORY *pHist)
+{
+	unsigned long long n = pHist->count;
+
+	if (n == 0)
+		return 0;
+
+	/* (n * sum(x^2) - sum(x)^2) / n^2, exact in integers. */
+	return (uint32) ((n * pHist->sumSquares - pHist->sum * pHist->sum) / (n * n));
+}
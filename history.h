@@ -0,0 +1,97 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file history.h
+ * @brief Ring buffer of the last values with running statistics.
+ * Adding a value updates the sum and the sum of squares of the values in
+ * the buffer in constant time.
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*! @brief Maximum number of values in a history. */
+#define HISTORY_MAX_LENGTH 64
+
+/*! @brief Ring buffer of the last values. */
+struct HISTORY {
+	/*! @brief The values, the oldest at index once the buffer is full. */
+	uint32 values[HISTORY_MAX_LENGTH];
+	/*! @brief Capacity of the buffer. */
+	uint16 length;
+	/*! @brief Number of values in the buffer. */
+	uint16 count;
+	/*! @brief Index where the next value is stored. */
+	uint16 index;
+	/*! @brief Sum of the values in the buffer. */
+	unsigned long long sum;
+	/*! @brief Sum of the squares of the values in the buffer. */
+	unsigned long long sumSquares;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize an empty history.
+ *
+ * @param pHist History to initialize.
+ * @param length Number of values to keep (1 .. HISTORY_MAX_LENGTH).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR HistoryInit(struct HISTORY *pHist, const uint16 length);
+
+/*********************************************************************//*!
+ * @brief Remove all values.
+ *
+ * @param pHist History.
+ *//*********************************************************************/
+void HistoryReset(struct HISTORY *pHist);
+
+/*********************************************************************//*!
+ * @brief Add a value, replacing the oldest one if the history is full.
+ *
+ * @param pHist History.
+ * @param value Value to add.
+ *//*********************************************************************/
+void HistoryAdd(struct HISTORY *pHist, const uint32 value);
+
+/*********************************************************************//*!
+ * @brief Check whether the history holds length values.
+ *
+ * @param pHist History.
+ * @return TRUE if the history is full
+ *//*********************************************************************/
+int HistoryIsFull(const struct HISTORY *pHist);
+
+/*********************************************************************//*!
+ * @brief Mean of the values in the history (0 if empty).
+ *
+ * @param pHist History.
+ * @return Mean rounded down
+ *//*********************************************************************/
+uint32 HistoryMean(const struct HISTORY *pHist);
+
+/*********************************************************************//*!
+ * @brief Population variance of the values in the history (0 if empty).
+ *
+ * @param pHist History.
+ * @return Variance rounded down
+ *//*********************************************************************/
+uint32 HistoryVariance(const struct HISTORY *pHist);
+
+#endif /* HISTORY_H_ */
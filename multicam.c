@@ -0,0 +1,301 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file multicam.c
+ * @brief Many simulated cameras in one process.
+ * Runs the capture and detection pipeline of alarm.c for a number of
+ * simulated cameras (simcam.c), one thread per camera, and reports the
+ * frames per second of all cameras together for 1, 2, 4, ... cameras up
+ * to the number given. The cameras share the replayed frames but nothing
+ * else, so the throughput should grow with the cameras as long as there
+ * are processors and memory bandwidth left.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "simcam.h"
+#include "replay.h"
+#include "detect.h"
+#include "picstat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+/* Default frames, greyscale bitmaps */
+#define MULTICAM_INPUT "imgCapture.bmp"
+/* Maximum number of cameras */
+#define MAX_CAMERAS 256
+/* Distance of the pixels and rows averaged for the mean */
+#define THUMB_STEP 4
+
+/*! @brief A simulated camera, its pipeline and its thread. */
+struct MULTICAM_UNIT {
+	struct SIM_CAMERA cam;
+	pthread_t thread;
+	/*! @brief Frame buffers, captured into by turns. */
+	uint8 *pBuffers[2];
+	/*! @brief Background model buffers. */
+	uint8 *pBackground, *pFraction;
+	/*! @brief Detection engine. */
+	struct DETECTOR detector;
+	/*! @brief Frames to run. */
+	uint32 nFrames;
+	/*! @brief Intruders detected. */
+	uint32 nIntruders;
+	/*! @brief Result of the pipeline. */
+	OSC_ERR err;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a camera and trigger its first capture.
+ *
+ * @param pUnit Camera to set up.
+ * @param pSource Frames shared by the cameras.
+ * @param first First frame of the camera.
+ * @param pSettings Detection settings.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR setupUnit(struct MULTICAM_UNIT *pUnit,
+		const struct REPLAY *pSource,
+		const uint32 first,
+		const struct DETECT_SETTINGS *pSettings)
+{
+	const uint32 size = (uint32) pSource->width * pSource->height;
+	OSC_ERR err;
+	uint8 i;
+
+	memset(pUnit, 0, sizeof(struct MULTICAM_UNIT));
+	for (i = 0; i < 2; i++)
+		pUnit->pBuffers[i] = malloc(size);
+	pUnit->pBackground = malloc(size);
+	pUnit->pFraction = malloc(size);
+	if (pUnit->pBuffers[0] == NULL || pUnit->pBuffers[1] == NULL || pUnit->pBackground == NULL || pUnit->pFraction == NULL)
+		return -EOUT_OF_MEMORY;
+
+	err = SimCamInit(&pUnit->cam, pSource, first);
+	for (i = 0; i < 2 && err == SUCCESS; i++)
+		err = SimCamSetFrameBuffer(&pUnit->cam, i, size, pUnit->pBuffers[i]);
+	if (err == SUCCESS)
+		err = DetectorInit(&pUnit->detector, pSource->width, pSource->height, pUnit->pBackground, pUnit->pFraction, pSettings);
+	if (err == SUCCESS)
+		err = SimCamSetupCapture(&pUnit->cam, 0);
+	if (err == SUCCESS)
+		err = SimGpioTriggerImage(&pUnit->cam);
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Free the buffers of a camera, which may be set up partly.
+ *
+ * @param pUnit Camera.
+ *//*********************************************************************/
+static void destroyUnit(struct MULTICAM_UNIT *pUnit)
+{
+	free(pUnit->pBuffers[0]);
+	free(pUnit->pBuffers[1]);
+	free(pUnit->pBackground);
+	free(pUnit->pFraction);
+	pUnit->pBuffers[0] = pUnit->pBuffers[1] = NULL;
+	pUnit->pBackground = pUnit->pFraction = NULL;
+}
+
+/*********************************************************************//*!
+ * @brief Thread of a camera: capture pipelined and detect intruders.
+ *
+ * @param pArg Camera.
+ * @return NULL
+ *//*********************************************************************/
+static void * unitThread(void *pArg)
+{
+	struct MULTICAM_UNIT *pUnit = (struct MULTICAM_UNIT *) pArg;
+	struct SIM_CAMERA *pCam = &pUnit->cam;
+	struct OSC_PICTURE pic;
+	uint32 i, events;
+	uint8 id = 0;
+	OSC_ERR err = SUCCESS;
+
+	pic.width = pCam->width;
+	pic.height = pCam->height;
+	pic.type = OSC_PICTURE_GREYSCALE;
+
+	for (i = 0; i < pUnit->nFrames && err == SUCCESS; i++) {
+		err = SimCamReadPicture(pCam, id, (uint8 **) &pic.data);
+		if (err != SUCCESS)
+			break;
+
+		/* Expose the next frame while this one is analysed */
+		id = 1 - id;
+		err = SimCamSetupCapture(pCam, id);
+		if (err == SUCCESS)
+			err = SimGpioTriggerImage(pCam);
+
+		events = DetectorFrame(&pUnit->detector, pic.data, PicStatMeanSampled(&pic, THUMB_STEP, 0, 0), 1);
+		if (events & DETECT_INTRUDER) {
+			SimGpioWrite(pCam, GPIO_OUT2, TRUE);
+			pUnit->nIntruders++;
+		}
+		if (events & DETECT_ALARM_END)
+			SimGpioWrite(pCam, GPIO_OUT2, FALSE);
+	}
+
+	pUnit->err = err;
+	return NULL;
+}
+
+/*********************************************************************//*!
+ * @brief Run a number of cameras, each on a thread of its own.
+ *
+ * @param pUnits Cameras.
+ * @param nUnits Number of cameras.
+ * @param pSource Frames shared by the cameras.
+ * @param nFrames Frames per camera.
+ * @param pSettings Detection settings.
+ * @param pMicroSecs Time taken by the cameras.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR runUnits(struct MULTICAM_UNIT *pUnits,
+		const uint32 nUnits,
+		const struct REPLAY *pSource,
+		const uint32 nFrames,
+		const struct DETECT_SETTINGS *pSettings,
+		uint32 *pMicroSecs)
+{
+	uint32 i, nSetUp, nStarted = 0;
+	struct timeval start, end;
+	OSC_ERR err = SUCCESS;
+
+	/* Set up all cameras first, so that only the pipelines are timed */
+	for (i = 0; i < nUnits && err == SUCCESS; i++) {
+		err = setupUnit(&pUnits[i], pSource, i * pSource->nFrames / nUnits, pSettings);
+		pUnits[i].nFrames = nFrames;
+	}
+	nSetUp = i;
+
+	/* Timed by the clock, the 32 bit cycle count wraps within seconds */
+	gettimeofday(&start, NULL);
+	for (i = 0; i < nUnits && err == SUCCESS; i++) {
+		if (pthread_create(&pUnits[i].thread, NULL, unitThread, &pUnits[i]) != 0) {
+			fprintf(stderr, "%s: ERROR: Unable to start thread %lu!\n", __func__, (unsigned long) i);
+			err = -EDEVICE;
+			break;
+		}
+		nStarted++;
+	}
+	for (i = 0; i < nStarted; i++) {
+		pthread_join(pUnits[i].thread, NULL);
+		if (err == SUCCESS)
+			err = pUnits[i].err;
+	}
+	gettimeofday(&end, NULL);
+	*pMicroSecs = (uint32) ((end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec);
+
+	/* Only the cameras of this round, the others are freed already */
+	for (i = 0; i < nSetUp; i++)
+		destroyUnit(&pUnits[i]);
+	return err;
+}
+
+int main(const int argc, const char * argv[])
+{
+	void *hFramework;
+	static struct MULTICAM_UNIT units[MAX_CAMERAS];
+	struct REPLAY source;
+	struct DETECT_SETTINGS settings;
+	uint32 i, n, us, fps, baseFps = 0, nIntruders;
+	OSC_ERR err;
+	
+	uint32 opt_cameras = 8, opt_frames = 200;
+	const char *opt_input = MULTICAM_INPUT;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: multicam [ -h ] [ -n <n> ] [ -f <n> ] [ <frames> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -n <n>: Simulates up to this many cameras (default 8).\n");
+			printf("    -f <n>: Frames per camera (default 200).\n");
+			printf("    <frames>: Directory, list or bitmap of the frames (default " MULTICAM_INPUT ").\n");
+			return 0;
+		} else if (argv[i][0] == '-' && strchr("nf", argv[i][1]) != NULL && argv[i][2] == '\0') {
+			if (i + 1 >= argc) {
+				printf("Error: %s needs an argument.\n", argv[i]);
+				return 1;
+			}
+			if (argv[i][1] == 'n') {
+				opt_cameras = atoi(argv[i + 1]);
+			} else {
+				opt_frames = atoi(argv[i + 1]);
+			}
+			i++;
+		} else if (argv[i][0] != '-') {
+			opt_input = argv[i];
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (opt_cameras == 0 || opt_cameras > MAX_CAMERAS || opt_frames == 0) {
+		printf("Error: The cameras must be from 1 to %d, the frames at least 1.\n", MAX_CAMERAS);
+		return 1;
+	}
+	
+	/* Create framework */
+	OscCreate(&hFramework);
+	
+	/* Load modules */
+	OscSupCreate(hFramework);
+	
+	err = ReplayOpen(&source, opt_input, 0);
+	if (err == SUCCESS) {
+		DetectDefaults(&settings, source.width, source.height);
+		
+		printf("# %lu frames of %ux%u, %lu frames per camera\n",
+				(unsigned long) source.nFrames, source.width, source.height, (unsigned long) opt_frames);
+		printf("# cameras frames/s per-camera speedup intruders\n");
+		
+		/* 1, 2, 4, ... cameras and the number asked for */
+		for (n = 1; err == SUCCESS; n = 2 * n < opt_cameras ? 2 * n : opt_cameras) {
+			err = runUnits(units, n, &source, opt_frames, &settings, &us);
+			if (err != SUCCESS) {
+				fprintf(stderr, "%s: ERROR: Unable to run %lu cameras! (%d)\n", __func__, (unsigned long) n, err);
+				break;
+			}
+			
+			nIntruders = 0;
+			for (i = 0; i < n; i++)
+				nIntruders += units[i].nIntruders;
+			fps = us > 0 ? (uint32) ((unsigned long long) n * opt_frames * 1000000 / us) : 0;
+			if (n == 1)
+				baseFps = fps;
+			printf("%lu %lu %lu %.2f %lu\n", (unsigned long) n, (unsigned long) fps, (unsigned long) (fps / n),
+					baseFps > 0 ? (float) fps / baseFps : 0, (unsigned long) nIntruders);
+			if (n == opt_cameras)
+				break;
+		}
+		
+		ReplayClose(&source);
+	}
+	
+	/* Unload modules */
+	OscSupDestroy(hFramework);
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	return err == SUCCESS ? 0 : 1;
+}
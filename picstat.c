@@ -0,0 +1,55 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file picstat.c
+ * @brief Statistics of greyscale pictures.
+ */
+
+#include "picstat.h"
+
+uint32 PicStatMean(const struct OSC_PICTURE *pic)
+{
+	uint32 sum = 0;
+	uint32 size = (uint32) pic->width * pic->height;
+	const uint8 *p = (const uint8 *) pic->data;
+	const uint8 *pEnd = p + size;
+
+	while (p < pEnd) {
+		sum += *p++;
+	}
+	return sum / size;
+}
+
+uint32 PicStatMeanSampled(const struct OSC_PICTURE *pic,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0)
+{
+	uint32 sum = 0, n = 0;
+	const uint8 *pRow;
+	uint16 x, y;
+
+	for (y = y0; y < pic->height; y += step) {
+		pRow = (const uint8 *) pic->data + (uint32) y * pic->width;
+		for (x = x0; x < pic->width; x += step) {
+			sum += pRow[x];
+		}
+		n += (pic->width - x0 + step - 1) / step;
+	}
+	return n > 0 ? sum / n : 0;
+}
@@ -0,0 +1,55 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file picstat.h
+ * @brief Statistics of greyscale pictures.
+ */
+
+#ifndef PICSTAT_H_
+#define PICSTAT_H_
+
+#include "oscar/staging/inc/oscar.h"
+
+/*********************************************************************//*!
+ * @brief Calculate the mean of a greyscale picture.
+ *
+ * The sum is kept in 32 bits, which holds pictures of up to 16M pixels.
+ *
+ * @param pic Picture.
+ * @return Mean grey level, rounded down
+ *//*********************************************************************/
+uint32 PicStatMean(const struct OSC_PICTURE *pic);
+
+/*********************************************************************//*!
+ * @brief Calculate the mean of every step-th pixel and row.
+ *
+ * Gives the mean of the thumbnail of the same step and origin (see
+ * thumb.h) without gathering it.
+ *
+ * @param pic Picture.
+ * @param step Distance of the pixels and rows.
+ * @param x0 First column.
+ * @param y0 First row.
+ * @return Mean grey level, rounded down
+ *//*********************************************************************/
+uint32 PicStatMeanSampled(const struct OSC_PICTURE *pic,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0);
+
+#endif /* PICSTAT_H_ */
@@ -0,0 +1,255 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file prof.c
+ * @brief Cycle count profiling of program stages.
+ * A timer has a single writer, so its records need no lock. A report taken
+ * meanwhile may miss the latest call. The 64 bit cycle count has a single
+ * writer as well, the owner of the profile; it marks an overflow being
+ * counted with an odd sequence number, which readers retry on. The
+ * histogram buckets are logarithmic: below 2^PROF_SUB_BITS cycles there is
+ * one per count, above each power of two is split into 2^PROF_SUB_BITS
+ * ranges, which bounds the error of a percentile to an eighth.
+ */
+
+#include "prof.h"
+#include <string.h>
+
+#if defined(OSC_HOST)
+/*! @brief Orders the memory accesses around the sequence number. */
+#define BARRIER() __sync_synchronize()
+#else
+/*! @brief The Blackfin is a single core, a compiler barrier suffices. */
+#define BARRIER() __asm__ __volatile__ ("" : : : "memory")
+#endif
+
+/*! @brief Cycles used to get the cycle frequency. */
+#define PROF_CALIBRATION_CYCLES 100000000UL
+
+OSC_ERR ProfInit(struct PROF *pProf)
+{
+	memset(pProf, 0, sizeof(struct PROF));
+	ProfReset(pProf);
+	return SUCCESS;
+}
+
+struct PROF_TIMER *ProfTimer(struct PROF *pProf, const char *name)
+{
+	struct PROF_TIMER *pTimer;
+	uint8 i;
+
+	for (i = 0; i < pProf->nTimers; i++) {
+		if (strncmp(pProf->timers[i].name, name, PROF_MAX_NAME - 1) == 0)
+			return &pProf->timers[i];
+	}
+	if (pProf->nTimers == PROF_MAX_TIMERS)
+		return NULL;
+
+	pTimer = &pProf->timers[pProf->nTimers++];
+	strncpy(pTimer->name, name, PROF_MAX_NAME - 1);
+	pTimer->name[PROF_MAX_NAME - 1] = '\0';
+	pTimer->min = ~0UL;
+	return pTimer;
+}
+
+unsigned long long ProfCycles(struct PROF *pProf)
+{
+	uint32 now = OscSupCycGet();
+
+	if (now < pProf->lastCycles) {
+		pProf->seq++;
+		BARRIER();
+		pProf->nOverflows++;
+		pProf->lastCycles = now;
+		BARRIER();
+		pProf->seq++;
+	} else {
+		pProf->lastCycles = now;
+	}
+
+	return ((unsigned long long) pProf->nOverflows << 32) + now;
+}
+
+unsigned long long ProfCyclesRead(const struct PROF *pProf)
+{
+	uint32 seq, last, nOverflows, now;
+
+	do {
+		seq = pProf->seq;
+		BARRIER();
+		last = pProf->lastCycles;
+		nOverflows = pProf->nOverflows;
+		now = OscSupCycGet();
+		BARRIER();
+	} while ((seq & 1) || seq != pProf->seq);
+
+	/* Overflowed since the owner last looked */
+	if (now < last)
+		nOverflows++;
+	return ((unsigned long long) nOverflows << 32) + now;
+}
+
+unsigned long long ProfMicroSecs(const unsigned long long cycles)
+{
+	static double microSecsPerCycle = 0;
+
+	if (microSecsPerCycle == 0)
+		microSecsPerCycle = (double) OscSupCycToMicroSecs(PROF_CALIBRATION_CYCLES) / PROF_CALIBRATION_CYCLES;
+
+	return (unsigned long long) (cycles * microSecsPerCycle);
+}
+
+uint32 ProfStart(void)
+{
+	return OscSupCycGet();
+}
+
+void ProfStop(struct PROF_TIMER *pTimer, const uint32 start)
+{
+	/* The difference of the 32 bit counts, also where uint32 is wider. */
+	ProfRecord(pTimer, (OscSupCycGet() - start) & 0xFFFFFFFFUL);
+}
+
+/*********************************************************************//*!
+ * @brief Get the histogram bucket of a cycle count.
+ *
+ * @param cycles Cycles.
+ * @return Bucket index
+ *//*********************************************************************/
+static uint16 bucketOf(const uint32 cycles)
+{
+	uint16 msb;
+
+	if (cycles < (1 << PROF_SUB_BITS))
+		return cycles;
+
+	msb = 31 - __builtin_clz((unsigned int) cycles);
+	return ((msb - PROF_SUB_BITS + 1) << PROF_SUB_BITS) |
+			((cycles >> (msb - PROF_SUB_BITS)) & ((1 << PROF_SUB_BITS) - 1));
+}
+
+/*********************************************************************//*!
+ * @brief Get the largest cycle count of a histogram bucket.
+ *
+ * @param iBucket Bucket index.
+ * @return Cycles
+ *//*********************************************************************/
+static uint32 bucketTop(const uint16 iBucket)
+{
+	uint16 shift;
+
+	if (iBucket < (1 << PROF_SUB_BITS))
+		return iBucket;
+
+	shift = (iBucket >> PROF_SUB_BITS) - 1;
+	return ((((1UL << PROF_SUB_BITS) | (iBucket & ((1 << PROF_SUB_BITS) - 1))) << shift) - 1) +
+			(1UL << shift);
+}
+
+void ProfRecord(struct PROF_TIMER *pTimer, const uint32 cycles)
+{
+	if (pTimer == NULL)
+		return;
+
+	pTimer->buckets[bucketOf(cycles)]++;
+	pTimer->sum += cycles;
+	if (cycles < pTimer->min)
+		pTimer->min = cycles;
+	if (cycles > pTimer->max)
+		pTimer->max = cycles;
+	pTimer->count++;
+}
+
+/*********************************************************************//*!
+ * @brief Get a percentile of the cycles recorded by a timer.
+ *
+ * @param buckets Copy of the histogram.
+ * @param count Number of calls in the histogram.
+ * @param percent Percentile.
+ * @param max Largest cycle count recorded.
+ * @return Upper bound of the percentile
+ *//*********************************************************************/
+static uint32 percentile(const uint32 *buckets, const uint32 count, const uint8 percent, const uint32 max)
+{
+	uint32 rank = (uint32) (((unsigned long long) count * percent + 99) / 100), n = 0, top;
+	uint16 i;
+
+	for (i = 0; i < PROF_BUCKETS; i++) {
+		n += buckets[i];
+		if (n >= rank && n > 0) {
+			top = bucketTop(i);
+			return top < max ? top : max;
+		}
+	}
+	return max;
+}
+
+void ProfReport(struct PROF *pProf, FILE *pFile)
+{
+	uint32 buckets[PROF_BUCKETS];
+	const struct PROF_TIMER *pTimer;
+	uint32 count;
+	uint16 i;
+	uint8 t;
+
+	fprintf(pFile, "Profile over %llu ms (us per call):\n",
+			ProfMicroSecs(ProfCyclesRead(pProf) - pProf->resetCycles) / 1000);
+	fprintf(pFile, "%-*s %8s %8s %8s %8s %8s %8s\n", PROF_MAX_NAME, "stage",
+			"calls", "mean", "min", "p50", "p99", "max");
+
+	for (t = 0; t < pProf->nTimers; t++) {
+		pTimer = &pProf->timers[t];
+
+		/* Take a consistent histogram while the timer goes on. */
+		memcpy(buckets, pTimer->buckets, sizeof(buckets));
+		count = 0;
+		for (i = 0; i < PROF_BUCKETS; i++)
+			count += buckets[i];
+		if (count == 0) {
+			fprintf(pFile, "%-*s %8u\n", PROF_MAX_NAME, pTimer->name, 0);
+			continue;
+		}
+
+		fprintf(pFile, "%-*s %8lu %8llu %8lu %8lu %8lu %8lu\n", PROF_MAX_NAME, pTimer->name,
+				(unsigned long) count,
+				ProfMicroSecs(pTimer->sum / count),
+				(unsigned long) OscSupCycToMicroSecs(pTimer->min),
+				(unsigned long) OscSupCycToMicroSecs(percentile(buckets, count, 50, pTimer->max)),
+				(unsigned long) OscSupCycToMicroSecs(percentile(buckets, count, 99, pTimer->max)),
+				(unsigned long) OscSupCycToMicroSecs(pTimer->max));
+	}
+}
+
+void ProfReset(struct PROF *pProf)
+{
+	uint8 t;
+
+	for (t = 0; t < pProf->nTimers; t++) {
+		memset(pProf->timers[t].buckets, 0, sizeof(pProf->timers[t].buckets));
+		pProf->timers[t].count = 0;
+		pProf->timers[t].sum = 0;
+		pProf->timers[t].min = ~0UL;
+		pProf->timers[t].max = 0;
+	}
+	pProf->resetCycles = ProfCycles(pProf);
+}
+
+void ProfDestroy(struct PROF *pProf)
+{
+	/* Nothing allocated so far */
+}
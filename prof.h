@@ -0,0 +1,175 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file prof.h
+ * @brief Cycle count profiling of program stages.
+ * Extends the 32 bit cycle count of the sup module to 64 bit and records
+ * the cycles taken by each call of a stage into a histogram of the stage
+ * timer, from which the minimum, maximum and percentiles are reported.
+ * Recording takes a few instructions and neither allocates nor locks.
+ */
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <stdio.h>
+
+/*! @brief Maximum number of timers of a profile. */
+#define PROF_MAX_TIMERS 16
+
+/*! @brief Maximum length of a timer name. */
+#define PROF_MAX_NAME 24
+
+/*! @brief Histogram buckets per power of two (log2). */
+#define PROF_SUB_BITS 3
+
+/*! @brief Number of histogram buckets covering all 32 bit cycle counts. */
+#define PROF_BUCKETS ((32 - PROF_SUB_BITS + 1) << PROF_SUB_BITS)
+
+/*! @brief Cycles taken by the calls of a stage. */
+struct PROF_TIMER {
+	/*! @brief Name of the stage. */
+	char name[PROF_MAX_NAME];
+	/*! @brief Number of calls, their total, minimum and maximum cycles. */
+	uint32 count;
+	unsigned long long sum;
+	uint32 min, max;
+	/*! @brief Number of calls per range of cycles. Each range spans an
+	 * eighth of the power of two it starts at. */
+	uint32 buckets[PROF_BUCKETS];
+};
+
+/*! @brief State of a profile. */
+struct PROF {
+	/*! @brief Stage timers. */
+	struct PROF_TIMER timers[PROF_MAX_TIMERS];
+	uint8 nTimers;
+	/*! @brief Last 32 bit cycle count and its number of overflows,
+	 * written by the owner of the profile only. */
+	volatile uint32 lastCycles, nOverflows;
+	/*! @brief Odd while the owner counts an overflow. */
+	volatile uint32 seq;
+	/*! @brief 64 bit cycle count when the profile was reset. */
+	unsigned long long resetCycles;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize a profile without timers.
+ *
+ * Requires the sup module to be loaded.
+ *
+ * @param pProf Profile to initialize.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ProfInit(struct PROF *pProf);
+
+/*********************************************************************//*!
+ * @brief Get the timer of a stage, add it if there is none.
+ *
+ * Meant for setting up, not for the timed code. A timer is recorded by one
+ * thread only.
+ *
+ * @param pProf Profile.
+ * @param name Name of the stage.
+ * @return The timer, NULL if the profile is full
+ *//*********************************************************************/
+struct PROF_TIMER *ProfTimer(struct PROF *pProf, const char *name);
+
+/*********************************************************************//*!
+ * @brief Get the 64 bit cycle count and keep it going.
+ *
+ * Called by one thread only, the owner of the profile (e.g. the frame
+ * loop), at least once per overflow of OscSupCycGet (some seconds).
+ *
+ * @param pProf Profile.
+ * @return Cycles since the 32 bit count started
+ *//*********************************************************************/
+unsigned long long ProfCycles(struct PROF *pProf);
+
+/*********************************************************************//*!
+ * @brief Get the 64 bit cycle count from any thread.
+ *
+ * Does not keep the count going, which is left to the owner calling
+ * ProfCycles.
+ *
+ * @param pProf Profile.
+ * @return Cycles since the 32 bit count started
+ *//*********************************************************************/
+unsigned long long ProfCyclesRead(const struct PROF *pProf);
+
+/*********************************************************************//*!
+ * @brief Convert a 64 bit cycle count to microseconds.
+ *
+ * @param cycles Cycles.
+ * @return Microseconds
+ *//*********************************************************************/
+unsigned long long ProfMicroSecs(const unsigned long long cycles);
+
+/*********************************************************************//*!
+ * @brief Start timing a call of a stage.
+ *
+ * @return Cycle count to pass to ProfStop
+ *//*********************************************************************/
+uint32 ProfStart(void);
+
+/*********************************************************************//*!
+ * @brief Record the cycles taken by a call of a stage.
+ *
+ * The call must take less than one overflow period of the cycle count.
+ *
+ * @param pTimer Timer of the stage, NULL to record nothing.
+ * @param start Value returned by ProfStart.
+ *//*********************************************************************/
+void ProfStop(struct PROF_TIMER *pTimer, const uint32 start);
+
+/*********************************************************************//*!
+ * @brief Record a given number of cycles.
+ *
+ * @param pTimer Timer of the stage, NULL to record nothing.
+ * @param cycles Cycles.
+ *//*********************************************************************/
+void ProfRecord(struct PROF_TIMER *pTimer, const uint32 cycles);
+
+/*********************************************************************//*!
+ * @brief Print the calls and microseconds of each stage.
+ *
+ * May be called while the timers are recorded.
+ *
+ * @param pProf Profile.
+ * @param pFile Output stream.
+ *//*********************************************************************/
+void ProfReport(struct PROF *pProf, FILE *pFile);
+
+/*********************************************************************//*!
+ * @brief Clear the records of all timers.
+ *
+ * Must not be called while the timers are recorded.
+ *
+ * @param pProf Profile.
+ *//*********************************************************************/
+void ProfReset(struct PROF *pProf);
+
+/*********************************************************************//*!
+ * @brief Free the resources of a profile.
+ *
+ * @param pProf Profile.
+ *//*********************************************************************/
+void ProfDestroy(struct PROF *pProf);
+
+#endif /* PROF_H_ */
@@ -0,0 +1,274 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file readout.c
+ * @brief Adaptive readout: watch windows while idle, full frames on motion.
+ * The window backgrounds are learned again from the first watch frame
+ * after full frames, so that whatever changed during an alarm does not
+ * trigger the next one.
+ */
+
+#include "readout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************************************************************//*!
+ * @brief Round a size up to whole words.
+ *
+ * @param size Size in bytes.
+ * @return Size in bytes, a multiple of the word size
+ *//*********************************************************************/
+static uint32 wordSize(const uint32 size)
+{
+	return (size + sizeof(unsigned long) - 1) & ~(uint32) (sizeof(unsigned long) - 1);
+}
+
+/*********************************************************************//*!
+ * @brief Widen a window to even coordinates inside the full frame.
+ *
+ * @param pWindow Window to widen.
+ * @param pFull Full frame.
+ *//*********************************************************************/
+static void alignWindow(struct READOUT_WINDOW *pWindow, const struct READOUT_WINDOW *pFull)
+{
+	uint32 right = (uint32) pWindow->x + pWindow->width;
+	uint32 bottom = (uint32) pWindow->y + pWindow->height;
+
+	right = (right + 1) & ~1UL;
+	bottom = (bottom + 1) & ~1UL;
+	pWindow->x &= ~1;
+	pWindow->y &= ~1;
+	pWindow->width = (right < pFull->width ? right : pFull->width) - pWindow->x;
+	pWindow->height = (bottom < pFull->height ? bottom : pFull->height) - pWindow->y;
+}
+
+/*********************************************************************//*!
+ * @brief Scale the moving pixels of motion in a full frame to a window.
+ *
+ * @param pReadout Readout.
+ * @param pWin Window.
+ * @param motionPixels Moving pixels of motion in a full frame.
+ * @return Moving pixels of motion in the window (>= 1)
+ *//*********************************************************************/
+static uint32 windowMotionPixels(const struct READOUT *pReadout,
+		const struct READOUT_WINDOW *pWin,
+		const uint32 motionPixels)
+{
+	uint32 n = (uint32) ((unsigned long long) motionPixels * ((uint32) pWin->width * pWin->height) /
+			((uint32) pReadout->full.width * pReadout->full.height));
+
+	return n > 0 ? n : 1;
+}
+
+OSC_ERR ReadoutInit(struct READOUT *pReadout,
+		const uint16 width,
+		const uint16 height,
+		const struct READOUT_WINDOW *pWindows,
+		const uint8 nWindows,
+		const uint8 pixelThreshold,
+		const uint32 motionPixels,
+		const uint32 burstFrames,
+		const uint32 refreshFrames)
+{
+	struct READOUT_WINDOW *pWin;
+	uint32 size, maxSize = 0, total = 0, right = 0, bottom = 0;
+	uint8 *pNext;
+	OSC_ERR err;
+	uint8 i;
+
+	if (nWindows < 1 || nWindows > READOUT_MAX_WINDOWS || burstFrames < 1)
+		return -EINVALID_PARAMETER;
+
+	memset(pReadout, 0, sizeof(struct READOUT));
+	pReadout->full.width = width;
+	pReadout->full.height = height;
+	pReadout->nWindows = nWindows;
+	pReadout->burstFrames = burstFrames;
+	pReadout->refreshFrames = refreshFrames;
+	pReadout->mode = READOUT_WATCH;
+	pReadout->bLearn = TRUE;
+
+	/* The watch area is the bounding box of the windows. */
+	pReadout->area.x = width;
+	pReadout->area.y = height;
+	for (i = 0; i < nWindows; i++) {
+		pWin = &pReadout->windows[i];
+		*pWin = pWindows[i];
+		if (pWin->width == 0 || pWin->height == 0 ||
+				(uint32) pWin->x + pWin->width > width || (uint32) pWin->y + pWin->height > height) {
+			fprintf(stderr, "%s: ERROR: Window %u is not inside the frame!\n", __func__, i);
+			return -EINVALID_PARAMETER;
+		}
+		alignWindow(pWin, &pReadout->full);
+
+		if (pWin->x < pReadout->area.x)
+			pReadout->area.x = pWin->x;
+		if (pWin->y < pReadout->area.y)
+			pReadout->area.y = pWin->y;
+		if (pWin->x + pWin->width > right)
+			right = pWin->x + pWin->width;
+		if (pWin->y + pWin->height > bottom)
+			bottom = pWin->y + pWin->height;
+
+		size = (uint32) pWin->width * pWin->height;
+		pReadout->motionPixels[i] = windowMotionPixels(pReadout, pWin, motionPixels);
+		if (size > maxSize)
+			maxSize = size;
+		total += 2 * wordSize(size);
+	}
+	pReadout->area.width = right - pReadout->area.x;
+	pReadout->area.height = bottom - pReadout->area.y;
+
+	/* Background and fraction of each window, then the gather buffer */
+	pReadout->pMemory = malloc(total + maxSize);
+	if (pReadout->pMemory == NULL)
+		return -EOUT_OF_MEMORY;
+
+	pNext = pReadout->pMemory;
+	for (i = 0; i < nWindows; i++) {
+		pWin = &pReadout->windows[i];
+		size = wordSize((uint32) pWin->width * pWin->height);
+		err = BgModelInit(&pReadout->models[i], pWin->width, pWin->height, pNext, pNext + size,
+				READOUT_LEARN_SHIFT, pixelThreshold, 1);
+		if (err != SUCCESS) {
+			ReadoutDestroy(pReadout);
+			return err;
+		}
+		pNext += 2 * size;
+	}
+	pReadout->pGather = pNext;
+
+	return SUCCESS;
+}
+
+void ReadoutSetThresholds(struct READOUT *pReadout,
+		const uint8 pixelThreshold,
+		const uint32 motionPixels)
+{
+	uint8 i;
+
+	for (i = 0; i < pReadout->nWindows; i++) {
+		pReadout->models[i].threshold = pixelThreshold;
+		pReadout->motionPixels[i] = windowMotionPixels(pReadout, &pReadout->windows[i], motionPixels);
+	}
+}
+
+const struct READOUT_WINDOW * ReadoutArea(const struct READOUT *pReadout)
+{
+	return pReadout->mode == READOUT_WATCH ? &pReadout->area : &pReadout->full;
+}
+
+OSC_ERR ReadoutSetArea(const struct READOUT *pReadout)
+{
+	const struct READOUT_WINDOW *pArea = ReadoutArea(pReadout);
+
+	return OscCamSetAreaOfInterest(pArea->x, pArea->y, pArea->width, pArea->height);
+}
+
+/*********************************************************************//*!
+ * @brief Get the pixels of a window as a picture of its own.
+ *
+ * @param pReadout Readout.
+ * @param pWin Window.
+ * @param pData Frame data.
+ * @param pArea Area of the sensor covered by the frame data.
+ * @return The window pixels, in the frame data if its rows are
+ * contiguous, otherwise gathered into the gather buffer
+ *//*********************************************************************/
+static const uint8 * windowPixels(struct READOUT *pReadout,
+		const struct READOUT_WINDOW *pWin,
+		const uint8 *pData,
+		const struct READOUT_WINDOW *pArea)
+{
+	const uint8 *pSrc = pData + (uint32) (pWin->y - pArea->y) * pArea->width + (pWin->x - pArea->x);
+	uint16 y;
+
+	if (pWin->width == pArea->width)
+		return pSrc;
+
+	for (y = 0; y < pWin->height; y++)
+		memcpy(pReadout->pGather + (uint32) y * pWin->width, pSrc + (uint32) y * pArea->width, pWin->width);
+	return pReadout->pGather;
+}
+
+int ReadoutWatch(struct READOUT *pReadout,
+		const uint8 *pData,
+		const struct READOUT_WINDOW *pArea)
+{
+	const uint8 *pPixels;
+	int bMotion = FALSE;
+	uint8 i;
+
+	pReadout->nWatch++;
+	pReadout->watchFrames++;
+
+	for (i = 0; i < pReadout->nWindows; i++) {
+		pPixels = windowPixels(pReadout, &pReadout->windows[i], pData, pArea);
+		if (pReadout->bLearn)
+			BgModelReset(&pReadout->models[i], pPixels);
+		else if (BgModelDiff(&pReadout->models[i], pPixels, NULL) >= pReadout->motionPixels[i])
+			bMotion = TRUE;
+		else
+			BgModelUpdate(&pReadout->models[i], pPixels);
+	}
+	pReadout->bLearn = FALSE;
+
+	if (bMotion) {
+		pReadout->framesLeft = pReadout->burstFrames;
+		pReadout->nBursts++;
+	} else if (pReadout->refreshFrames > 0 && pReadout->watchFrames >= pReadout->refreshFrames) {
+		pReadout->framesLeft = 1;
+	} else {
+		return FALSE;
+	}
+
+	pReadout->mode = READOUT_FULL;
+	pReadout->watchFrames = 0;
+	return TRUE;
+}
+
+int ReadoutFull(struct READOUT *pReadout, const int bActive)
+{
+	pReadout->nFull++;
+	if (pReadout->framesLeft > 0)
+		pReadout->framesLeft--;
+	if (pReadout->framesLeft > 0 || bActive)
+		return FALSE;
+
+	pReadout->mode = READOUT_WATCH;
+	pReadout->bLearn = TRUE;
+	return TRUE;
+}
+
+void ReadoutPrintStats(struct READOUT *pReadout)
+{
+	printf("Readout: %lu watch frames of %ux%u, %lu full frames, %lu bursts\n",
+			(unsigned long) pReadout->nWatch, pReadout->area.width, pReadout->area.height,
+			(unsigned long) pReadout->nFull, (unsigned long) pReadout->nBursts);
+
+	pReadout->nWatch = 0;
+	pReadout->nFull = 0;
+	pReadout->nBursts = 0;
+}
+
+void ReadoutDestroy(struct READOUT *pReadout)
+{
+	free(pReadout->pMemory);
+	pReadout->pMemory = NULL;
+}
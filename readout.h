@@ -0,0 +1,184 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file readout.h
+ * @brief Adaptive readout: watch windows while idle, full frames on motion.
+ * While nothing happens, only the bounding box of a few watch windows is
+ * read out, which takes a fraction of the readout time, memory bandwidth
+ * and processing of a full frame. Each window has a small background model
+ * of its own. Motion in a window switches the readout to full frames for
+ * a burst, which lasts as long as the caller reports activity; then the
+ * readout falls back to the windows. A full frame is also read every
+ * refreshFrames windows frames, so that the caller's full frame analysis
+ * keeps up with slow changes of the scene.
+ */
+
+#ifndef READOUT_H_
+#define READOUT_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "bgmodel.h"
+
+/*! @brief Maximum number of watch windows. */
+#define READOUT_MAX_WINDOWS 4
+/*! @brief Learning rate 2^-READOUT_LEARN_SHIFT of the window backgrounds. */
+#define READOUT_LEARN_SHIFT 4
+
+/*! @brief A rectangle of the sensor. */
+struct READOUT_WINDOW {
+	uint16 x, y, width, height;
+};
+
+/*! @brief Readout modes. */
+enum EnReadoutMode {
+	/*! @brief The bounding box of the watch windows is read. */
+	READOUT_WATCH,
+	/*! @brief Full frames are read. */
+	READOUT_FULL
+};
+
+/*! @brief State of an adaptive readout. */
+struct READOUT {
+	/*! @brief Watch windows, in sensor coordinates. */
+	struct READOUT_WINDOW windows[READOUT_MAX_WINDOWS];
+	uint8 nWindows;
+	/*! @brief Area read in watch mode (bounding box of the windows) and
+	 * full frame. */
+	struct READOUT_WINDOW area, full;
+	/*! @brief Current mode. */
+	enum EnReadoutMode mode;
+	/*! @brief Background models of the windows and their buffers. */
+	struct BG_MODEL models[READOUT_MAX_WINDOWS];
+	uint8 *pMemory;
+	/*! @brief Window pixels gathered from a frame. */
+	uint8 *pGather;
+	/*! @brief Moving pixels of motion per window. */
+	uint32 motionPixels[READOUT_MAX_WINDOWS];
+	/*! @brief TRUE if the window backgrounds are learned from the next
+	 * watch frame. */
+	int bLearn;
+	/*! @brief Minimum full frames of a burst and watch frames between
+	 * refreshing full frames (0 = never). */
+	uint32 burstFrames, refreshFrames;
+	/*! @brief Full frames left in the current burst. */
+	uint32 framesLeft;
+	/*! @brief Watch frames since the last full frame. */
+	uint32 watchFrames;
+	/*! @brief Statistics: watch frames, full frames and bursts. */
+	uint32 nWatch, nFull, nBursts;
+};
+
+/*********************************************************************//*!
+ * @brief Set up an adaptive readout, starting in watch mode.
+ *
+ * The windows are widened to even coordinates, so the Bayer order of the
+ * watch area is that of the full frame.
+ *
+ * @param pReadout Readout to initialize.
+ * @param width Full frame width.
+ * @param height Full frame height.
+ * @param pWindows Watch windows, inside the full frame.
+ * @param nWindows Number of windows (1 .. READOUT_MAX_WINDOWS).
+ * @param pixelThreshold Grey level change of a moving pixel.
+ * @param motionPixels Moving pixels of motion in a full frame; scaled to
+ * the size of each window.
+ * @param burstFrames Minimum full frames read after motion (>= 1).
+ * @param refreshFrames Watch frames between refreshing full frames
+ * (0 = never).
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ReadoutInit(struct READOUT *pReadout,
+		const uint16 width,
+		const uint16 height,
+		const struct READOUT_WINDOW *pWindows,
+		const uint8 nWindows,
+		const uint8 pixelThreshold,
+		const uint32 motionPixels,
+		const uint32 burstFrames,
+		const uint32 refreshFrames);
+
+/*********************************************************************//*!
+ * @brief Change the motion thresholds of the watch windows, e.g. after
+ * the settings were reloaded. The window backgrounds are kept.
+ *
+ * @param pReadout Readout.
+ * @param pixelThreshold Grey level change of a moving pixel.
+ * @param motionPixels Moving pixels of motion in a full frame; scaled to
+ * the size of each window.
+ *//*********************************************************************/
+void ReadoutSetThresholds(struct READOUT *pReadout,
+		const uint8 pixelThreshold,
+		const uint32 motionPixels);
+
+/*********************************************************************//*!
+ * @brief Get the area of the sensor to read in the current mode.
+ *
+ * @param pReadout Readout.
+ * @return The watch area or the full frame
+ *//*********************************************************************/
+const struct READOUT_WINDOW * ReadoutArea(const struct READOUT *pReadout);
+
+/*********************************************************************//*!
+ * @brief Set the camera's area of interest to that of the current mode.
+ *
+ * No capture may be pending. Requires the cam module to be loaded.
+ *
+ * @param pReadout Readout.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ReadoutSetArea(const struct READOUT *pReadout);
+
+/*********************************************************************//*!
+ * @brief Check the watch windows of a frame read in watch mode.
+ *
+ * @param pReadout Readout in watch mode.
+ * @param pData Frame data.
+ * @param pArea Area of the sensor covered by the frame data, the watch
+ * area or the full frame (e.g. of replayed frames).
+ * @return TRUE if the readout switched to full frames, because of motion
+ * in a window or to refresh
+ *//*********************************************************************/
+int ReadoutWatch(struct READOUT *pReadout,
+		const uint8 *pData,
+		const struct READOUT_WINDOW *pArea);
+
+/*********************************************************************//*!
+ * @brief Count a full frame of a burst.
+ *
+ * @param pReadout Readout in full mode.
+ * @param bActive TRUE while the caller wants full frames to go on (e.g.
+ * during an alarm).
+ * @return TRUE if the readout switched back to watch mode
+ *//*********************************************************************/
+int ReadoutFull(struct READOUT *pReadout, const int bActive);
+
+/*********************************************************************//*!
+ * @brief Print the frames read per mode and reset the statistics.
+ *
+ * @param pReadout Readout.
+ *//*********************************************************************/
+void ReadoutPrintStats(struct READOUT *pReadout);
+
+/*********************************************************************//*!
+ * @brief Free the buffers of a readout.
+ *
+ * @param pReadout Readout.
+ *//*********************************************************************/
+void ReadoutDestroy(struct READOUT *pReadout);
+
+#endif /* READOUT_H_ */
@@ -0,0 +1,251 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file recorder.c
+ * @brief Event recorder with pre- and post-event frames.
+ * The capture loop is the only producer and the writer thread the only
+ * consumer of the slot queue, so the queue needs no lock: each index is
+ * written by one side only and published after a memory barrier.
+ * Requires the bmp and sup modules to be loaded.
+ */
+
+#include "recorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(OSC_HOST)
+/*! @brief Orders the memory accesses around the queue indices. */
+#define BARRIER() __sync_synchronize()
+#else
+/*! @brief The Blackfin is a single core, a compiler barrier suffices. */
+#define BARRIER() __asm__ __volatile__ ("" : : : "memory")
+#endif
+
+/*********************************************************************//*!
+ * @brief Hand a slot to the writer thread.
+ *
+ * @param pRec Recorder.
+ * @param iSlot Slot to write.
+ *//*********************************************************************/
+static void enqueue(struct RECORDER *pRec, const uint16 iSlot)
+{
+	uint16 head = pRec->queueHead;
+
+	pRec->slots[iSlot].state = RECORDER_SLOT_QUEUED;
+	pRec->queue[head] = iSlot;
+	BARRIER();
+	pRec->queueHead = (head + 1) % (RECORDER_MAX_SLOTS + 1);
+	sem_post(&pRec->queued);
+}
+
+/*********************************************************************//*!
+ * @brief Write a slot to a file named after the time of the frame, or
+ * add it to the ring file.
+ *
+ * @param pRec Recorder.
+ * @param pSlot Slot to write.
+ *//*********************************************************************/
+static void writeSlot(struct RECORDER *pRec, struct RECORDER_SLOT *pSlot)
+{
+	struct OSC_PICTURE pic;
+	struct tm tm;
+	time_t seconds = pSlot->time.tv_sec;
+	char date[16];
+	char fileName[RECORDER_MAX_PREFIX + 64];
+	uint32 start;
+	OSC_ERR err;
+
+	if (pRec->pRingFile != NULL) {
+		start = ProfStart();
+		err = RingFileAdd(pRec->pRingFile, pSlot->pData, &pSlot->time, pSlot->seq);
+		ProfStop(pRec->pWriteTimer, start);
+		TRACE_STOP(pRec->pWriteTrace, "ring write", start);
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: Unable to add frame %lu to the ring file! (%d)\n", __func__, (unsigned long) pSlot->seq, err);
+		}
+		return;
+	}
+
+	localtime_r(&seconds, &tm);
+	strftime(date, sizeof(date), "%Y%m%d-%H%M%S", &tm);
+	snprintf(fileName, sizeof(fileName), "%s%s-%03d-%06lu.bmp", pRec->prefix,
+			date, (int) (pSlot->time.tv_usec / 1000), (unsigned long) pSlot->seq);
+
+	pic.width = pRec->width;
+	pic.height = pRec->height;
+	pic.type = OSC_PICTURE_GREYSCALE;
+	pic.data = pSlot->pData;
+
+	start = ProfStart();
+	err = OscBmpWrite(&pic, fileName);
+	ProfStop(pRec->pWriteTimer, start);
+	TRACE_STOP(pRec->pWriteTrace, "bmp write", start);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to write %s! (%d)\n", __func__, fileName, err);
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Writer thread: write queued slots until stopped.
+ *
+ * @param pArg Recorder.
+ * @return NULL
+ *//*********************************************************************/
+static void * writer(void *pArg)
+{
+	struct RECORDER *pRec = (struct RECORDER *) pArg;
+	struct RECORDER_SLOT *pSlot;
+	uint16 tail;
+
+	while (1) {
+		sem_wait(&pRec->queued);
+
+		tail = pRec->queueTail;
+		if (tail == pRec->queueHead) {
+			/* Woken up without work: stop requested. */
+			if (pRec->bStop)
+				break;
+			continue;
+		}
+		BARRIER();
+
+		pSlot = &pRec->slots[pRec->queue[tail]];
+		writeSlot(pRec, pSlot);
+		pRec->nWritten++;
+
+		BARRIER();
+		pSlot->state = RECORDER_SLOT_FREE;
+		pRec->queueTail = (tail + 1) % (RECORDER_MAX_SLOTS + 1);
+	}
+
+	return NULL;
+}
+
+OSC_ERR RecorderInit(struct RECORDER *pRec,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBuffer,
+		const uint16 nSlots,
+		const uint16 preRoll,
+		const uint16 postRoll,
+		const char *prefix)
+{
+	uint16 i;
+
+	if (nSlots > RECORDER_MAX_SLOTS || preRoll >= nSlots ||
+			strlen(prefix) >= RECORDER_MAX_PREFIX) {
+		return -EINVALID_PARAMETER;
+	}
+
+	memset(pRec, 0, sizeof(struct RECORDER));
+	pRec->width = width;
+	pRec->height = height;
+	strcpy(pRec->prefix, prefix);
+	pRec->nSlots = nSlots;
+	pRec->preRoll = preRoll;
+	pRec->postRoll = postRoll;
+
+	for (i = 0; i < nSlots; i++) {
+		pRec->slots[i].pData = pBuffer + (uint32) i * width * height;
+		pRec->slots[i].state = RECORDER_SLOT_FREE;
+	}
+
+	if (sem_init(&pRec->queued, 0, 0) != 0)
+		return -EDEVICE;
+	if (pthread_create(&pRec->writer, NULL, writer, pRec) != 0) {
+		sem_destroy(&pRec->queued);
+		return -EDEVICE;
+	}
+
+	return SUCCESS;
+}
+
+void RecorderAddFrame(struct RECORDER *pRec, const uint8 *pFrame)
+{
+	struct RECORDER_SLOT *pSlot = NULL;
+	uint16 i, iSlot = 0;
+	int bRecording = pRec->postRemaining > 0;
+
+	pRec->nFrames++;
+	if (bRecording)
+		pRec->postRemaining--;
+	else if (pRec->preRoll == 0)
+		return;
+
+	/* Reuse the oldest pre-roll slot once the pre-roll is complete. */
+	if (!bRecording && pRec->preRoll > 0 &&
+			pRec->preRollCount == pRec->preRoll) {
+		iSlot = pRec->preRollSlots[pRec->preRollFirst];
+		pSlot = &pRec->slots[iSlot];
+		pRec->preRollFirst = (pRec->preRollFirst + 1) % pRec->preRoll;
+		pRec->preRollCount--;
+	} else {
+		for (i = 0; i < pRec->nSlots; i++) {
+			if (pRec->slots[i].state == RECORDER_SLOT_FREE) {
+				iSlot = i;
+				pSlot = &pRec->slots[i];
+				break;
+			}
+		}
+	}
+
+	if (pSlot == NULL) {
+		/* The writer falls behind, drop the frame from the recording. */
+		pRec->nDropped++;
+		return;
+	}
+
+	BARRIER();
+	memcpy(pSlot->pData, pFrame, (uint32) pRec->width * pRec->height);
+	gettimeofday(&pSlot->time, NULL);
+	pSlot->seq = pRec->nFrames;
+
+	if (bRecording) {
+		enqueue(pRec, iSlot);
+	} else {
+		pSlot->state = RECORDER_SLOT_PREROLL;
+		pRec->preRollSlots[(pRec->preRollFirst + pRec->preRollCount) % pRec->preRoll] = iSlot;
+		pRec->preRollCount++;
+	}
+}
+
+void RecorderTrigger(struct RECORDER *pRec)
+{
+	/* Queue the pre-roll frames, oldest first. */
+	while (pRec->preRollCount > 0) {
+		enqueue(pRec, pRec->preRollSlots[pRec->preRollFirst]);
+		pRec->preRollFirst = (pRec->preRollFirst + 1) % pRec->preRoll;
+		pRec->preRollCount--;
+	}
+
+	pRec->postRemaining = pRec->postRoll;
+}
+
+OSC_ERR RecorderDestroy(struct RECORDER *pRec)
+{
+	pRec->bStop = TRUE;
+	BARRIER();
+	sem_post(&pRec->queued);
+
+	if (pthread_join(pRec->writer, NULL) != 0)
+		return -EDEVICE;
+	sem_destroy(&pRec->queued);
+
+	return SUCCESS;
+}
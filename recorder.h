@@ -0,0 +1,151 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file recorder.h
+ * @brief Event recorder with pre- and post-event frames.
+ * The last frames are kept in RAM. When an event is triggered, they and
+ * the following frames are written to timestamped bitmap files, or added
+ * to a ring file (ringfile.c), by a background thread. If the writer falls
+ * behind, frames are dropped from the recording instead of stalling the
+ * capture loop.
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "prof.h"
+#include "trace.h"
+#include "ringfile.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/time.h>
+
+/*! @brief Maximum number of frame slots of a recorder. */
+#define RECORDER_MAX_SLOTS 32
+
+/*! @brief Maximum length of the file name prefix. */
+#define RECORDER_MAX_PREFIX 64
+
+/*! @brief States of a frame slot. */
+enum EnRecorderSlot {
+	RECORDER_SLOT_FREE,
+	RECORDER_SLOT_PREROLL,
+	RECORDER_SLOT_QUEUED
+};
+
+/*! @brief A frame held by the recorder. */
+struct RECORDER_SLOT {
+	/*! @brief Frame data. */
+	uint8 *pData;
+	/*! @brief Time the frame was added. */
+	struct timeval time;
+	/*! @brief Sequence number of the frame. */
+	uint32 seq;
+	/*! @brief Owner of the slot, written by the capture loop and the writer. */
+	volatile enum EnRecorderSlot state;
+};
+
+/*! @brief State of an event recorder. */
+struct RECORDER {
+	/*! @brief Frame dimensions. */
+	uint16 width, height;
+	/*! @brief File name prefix, may contain a directory. */
+	char prefix[RECORDER_MAX_PREFIX];
+	/*! @brief Frame slots. */
+	struct RECORDER_SLOT slots[RECORDER_MAX_SLOTS];
+	uint16 nSlots;
+	/*! @brief Slots of the last frames before an event, oldest first. */
+	uint16 preRollSlots[RECORDER_MAX_SLOTS];
+	uint16 preRoll, preRollCount, preRollFirst;
+	/*! @brief Frames to record after an event and frames still to record. */
+	uint16 postRoll, postRemaining;
+	/*! @brief Single producer, single consumer queue of slots to write. */
+	uint16 queue[RECORDER_MAX_SLOTS + 1];
+	volatile uint16 queueHead, queueTail;
+	/*! @brief Counts the queued slots, the writer waits on it. */
+	sem_t queued;
+	/*! @brief Writer thread. */
+	pthread_t writer;
+	volatile int bStop;
+	/*! @brief Statistics. */
+	uint32 nFrames;
+	volatile uint32 nWritten;
+	uint32 nDropped;
+	/*! @brief Timer of the bitmap writes, may be set before the first
+	 * trigger (NULL by default). */
+	struct PROF_TIMER *pWriteTimer;
+	/*! @brief Trace ring of the writer thread, may be set before the
+	 * first trigger (NULL by default). */
+	struct TRACE_RING *pWriteTrace;
+	/*! @brief Ring file the frames are added to instead of bitmap files,
+	 * may be set before the first trigger (NULL by default). */
+	struct RING_FILE *pRingFile;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize a recorder and start its writer thread.
+ *
+ * @param pRec Recorder to initialize.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @param pBuffer Greyscale frame storage of nSlots * width * height bytes.
+ * @param nSlots Number of frames in RAM (> preRoll, <= RECORDER_MAX_SLOTS).
+ * @param preRoll Number of frames recorded before an event.
+ * @param postRoll Number of frames recorded from an event on.
+ * @param prefix File name prefix, e.g. "../intruder-".
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RecorderInit(struct RECORDER *pRec,
+		const uint16 width,
+		const uint16 height,
+		uint8 *pBuffer,
+		const uint16 nSlots,
+		const uint16 preRoll,
+		const uint16 postRoll,
+		const char *prefix);
+
+/*********************************************************************//*!
+ * @brief Add a captured frame; never blocks.
+ *
+ * The frame is copied. If no slot is free, because the writer falls
+ * behind, the frame is dropped from the recording.
+ *
+ * @param pRec Recorder.
+ * @param pFrame Greyscale frame.
+ *//*********************************************************************/
+void RecorderAddFrame(struct RECORDER *pRec, const uint8 *pFrame);
+
+/*********************************************************************//*!
+ * @brief Record the pre-roll frames and the next postRoll frames.
+ *
+ * Triggering during a recording extends it.
+ *
+ * @param pRec Recorder.
+ *//*********************************************************************/
+void RecorderTrigger(struct RECORDER *pRec);
+
+/*********************************************************************//*!
+ * @brief Write the queued frames and stop the writer thread.
+ *
+ * @param pRec Recorder.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RecorderDestroy(struct RECORDER *pRec);
+
+#endif /* RECORDER_H_ */
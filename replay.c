@@ -0,0 +1,143 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file replay.c
+ * @brief In-memory replay of recorded frames.
+ * The frame rate is kept by sleeping for the rest of the period after the
+ * frame served last; a frame asked for after its period is served at once
+ * and counted as late.
+ */
+
+#include "replay.h"
+#include "framelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*********************************************************************//*!
+ * @brief Load a frame and add it to a replay.
+ *
+ * @param pReplay Replay with room for the frame.
+ * @param fileName Bitmap file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR loadFrame(struct REPLAY *pReplay, const char *fileName)
+{
+	struct REPLAY_FRAME *pFrame = &pReplay->pFrames[pReplay->nFrames];
+	const struct OSC_PICTURE *pPic = &pFrame->map.pic;
+	uint8 *pCopy;
+	uint16 y;
+	OSC_ERR err;
+
+	err = BmpMapOpen(&pFrame->map, fileName);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to open %s! (%d)\n", __func__, fileName, err);
+		return err;
+	}
+
+	if (pReplay->nFrames == 0) {
+		pReplay->width = pPic->width;
+		pReplay->height = pPic->height;
+	}
+	if (pPic->type != OSC_PICTURE_GREYSCALE || pPic->width != pReplay->width || pPic->height != pReplay->height) {
+		fprintf(stderr, "%s: ERROR: %s is no 8 bit bitmap of %ux%u pixels!\n", __func__,
+				fileName, pReplay->width, pReplay->height);
+		BmpMapClose(&pFrame->map);
+		return -EINVALID_PARAMETER;
+	}
+
+	if (pPic->data != NULL) {
+		pFrame->pData = pPic->data;
+	} else {
+		/* Turn the rows upright once, the file is not needed anymore. */
+		pCopy = malloc((uint32) pPic->width * pPic->height);
+		if (pCopy == NULL) {
+			BmpMapClose(&pFrame->map);
+			return -EOUT_OF_MEMORY;
+		}
+		for (y = 0; y < pPic->height; y++)
+			memcpy(pCopy + (uint32) y * pPic->width, BmpMapRow(&pFrame->map, y), pPic->width);
+		BmpMapClose(&pFrame->map);
+		pFrame->pData = pCopy;
+		pFrame->bCopy = TRUE;
+	}
+
+	pReplay->nFrames++;
+	return SUCCESS;
+}
+
+OSC_ERR ReplayOpen(struct REPLAY *pReplay, const char *path, const uint32 fps)
+{
+	struct FRAME_LIST list;
+	uint32 i;
+	OSC_ERR err;
+
+	memset(pReplay, 0, sizeof(struct REPLAY));
+	pReplay->periodUs = fps > 0 ? 1000000 / fps : 0;
+
+	err = FrameListLoad(&list, path);
+	if (err != SUCCESS)
+		return err;
+
+	pReplay->pFrames = calloc(list.nNames, sizeof(struct REPLAY_FRAME));
+	err = pReplay->pFrames != NULL ? SUCCESS : -EOUT_OF_MEMORY;
+	for (i = 0; i < list.nNames && err == SUCCESS; i++)
+		err = loadFrame(pReplay, list.ppNames[i]);
+	FrameListFree(&list);
+
+	if (err != SUCCESS) {
+		ReplayClose(pReplay);
+		return err;
+	}
+	pReplay->lastCycles = OscSupCycGet();
+	return SUCCESS;
+}
+
+const uint8 *ReplayNext(struct REPLAY *pReplay)
+{
+	const uint8 *pData = pReplay->pFrames[pReplay->iNext].pData;
+	uint32 elapsedUs;
+
+	if (pReplay->periodUs > 0 && pReplay->nServed > 0) {
+		elapsedUs = OscSupCycToMicroSecs(OscSupCycGet() - pReplay->lastCycles);
+		if (elapsedUs < pReplay->periodUs)
+			usleep(pReplay->periodUs - elapsedUs);
+		else if (elapsedUs > pReplay->periodUs)
+			pReplay->nLate++;
+	}
+	pReplay->lastCycles = OscSupCycGet();
+
+	pReplay->iNext = (pReplay->iNext + 1) % pReplay->nFrames;
+	pReplay->nServed++;
+	return pData;
+}
+
+void ReplayClose(struct REPLAY *pReplay)
+{
+	uint32 i;
+
+	for (i = 0; i < pReplay->nFrames; i++) {
+		if (pReplay->pFrames[i].bCopy)
+			free((void *) pReplay->pFrames[i].pData);
+		else
+			BmpMapClose(&pReplay->pFrames[i].map);
+	}
+	free(pReplay->pFrames);
+	memset(pReplay, 0, sizeof(struct REPLAY));
+}
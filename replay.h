@@ -0,0 +1,93 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file replay.h
+ * @brief In-memory replay of recorded frames.
+ * A sequence of greyscale or raw bitmaps is loaded once and then served
+ * over and over, at a fixed frame rate or as fast as possible. Frames
+ * stored top-down are served straight from the mapped file, others are
+ * turned upright once when loading. No frame is decoded or copied while
+ * replaying.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "bmpmap.h"
+
+/*! @brief A loaded frame. */
+struct REPLAY_FRAME {
+	/*! @brief Top row of the frame, rows without gaps. */
+	const uint8 *pData;
+	/*! @brief Mapped file, serving pData unless it was copied. */
+	struct BMP_MAP map;
+	/*! @brief TRUE if pData is an upright copy of the file rows. */
+	int bCopy;
+};
+
+/*! @brief State of a replay. */
+struct REPLAY {
+	/*! @brief Frames in replay order. */
+	struct REPLAY_FRAME *pFrames;
+	uint32 nFrames;
+	/*! @brief Frame dimensions, the same for all frames. */
+	uint16 width, height;
+	/*! @brief Time between frames in us, 0 to serve as fast as possible. */
+	uint32 periodUs;
+	/*! @brief Next frame to serve. */
+	uint32 iNext;
+	/*! @brief Cycle count when the last frame was served. */
+	uint32 lastCycles;
+	/*! @brief Number of frames served and of those served late. */
+	uint32 nServed, nLate;
+};
+
+/*********************************************************************//*!
+ * @brief Load the frames to replay.
+ *
+ * The path is a directory, whose .bmp files are replayed in name order,
+ * a single .bmp file, or a text file listing one bitmap file per line
+ * (see FrameListLoad). All frames must be 8 bit bitmaps of the same size.
+ *
+ * @param pReplay Replay to initialize.
+ * @param path Directory, bitmap or list file.
+ * @param fps Frames per second, 0 to serve as fast as possible.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ReplayOpen(struct REPLAY *pReplay, const char *path, const uint32 fps);
+
+/*********************************************************************//*!
+ * @brief Serve the next frame, starting over after the last one.
+ *
+ * Waits until the frame is due at the fixed frame rate. The frame must
+ * not be written to.
+ *
+ * @param pReplay Replay.
+ * @return Top row of the frame, rows without gaps
+ *//*********************************************************************/
+const uint8 *ReplayNext(struct REPLAY *pReplay);
+
+/*********************************************************************//*!
+ * @brief Free the frames of a replay.
+ *
+ * @param pReplay Replay.
+ *//*********************************************************************/
+void ReplayClose(struct REPLAY *pReplay);
+
+#endif /* REPLAY_H_ */
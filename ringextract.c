@@ -0,0 +1,252 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file ringextract.c
+ * @brief Extract frames of a ring file recorded by alarm.c to bitmaps.
+ * Lists the frames of the ring file (ringfile.c) with their sequence
+ * number, time and size, or writes frames to bitmap files named like the
+ * ones of the recorder: one by sequence number, the first one at or after
+ * a time, or all of them.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "ringfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*********************************************************************//*!
+ * @brief Format the time of a frame as the recorder names its files.
+ *
+ * @param pTime Time.
+ * @param str Buffer of at least 24 characters.
+ *//*********************************************************************/
+static void formatTime(const struct timeval *pTime, char *str)
+{
+	struct tm tm;
+	time_t seconds = pTime->tv_sec;
+
+	localtime_r(&seconds, &tm);
+	strftime(str, 16, "%Y%m%d-%H%M%S", &tm);
+	sprintf(str + strlen(str), "-%03d", (int) (pTime->tv_usec / 1000));
+}
+
+/*********************************************************************//*!
+ * @brief Parse a local time given as YYYYMMDD-HHMMSS[-mmm].
+ *
+ * @param str Time.
+ * @param pTime The time.
+ * @return SUCCESS or -EINVALID_PARAMETER
+ *//*********************************************************************/
+static OSC_ERR parseTime(const char *str, struct timeval *pTime)
+{
+	struct tm tm;
+	int ms = 0, n;
+
+	memset(&tm, 0, sizeof(struct tm));
+	n = sscanf(str, "%4d%2d%2d-%2d%2d%2d-%3d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+			&tm.tm_hour, &tm.tm_min, &tm.tm_sec, &ms);
+	if (n < 6)
+		return -EINVALID_PARAMETER;
+	tm.tm_year -= 1900;
+	tm.tm_mon -= 1;
+	tm.tm_isdst = -1;
+
+	pTime->tv_sec = mktime(&tm);
+	pTime->tv_usec = ms * 1000L;
+	return pTime->tv_sec == -1 ? -EINVALID_PARAMETER : SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Print the frames of the ring file.
+ *
+ * @param pRing Ring file.
+ *//*********************************************************************/
+static void listFrames(const struct RING_FILE *pRing)
+{
+	struct RING_FILE_ENTRY entry;
+	unsigned long long nBytes = 0;
+	uint32 n, nKeys = 0;
+	char time[24];
+
+	printf("%ux%u pixels, %lu frames:\n", pRing->width, pRing->height, (unsigned long) (pRing->head - pRing->tail));
+	for (n = pRing->tail; n != pRing->head; n++) {
+		RingFileEntry(pRing, n, &entry);
+		formatTime(&entry.time, time);
+		printf("%8lu %s %s %7lu bytes\n", (unsigned long) entry.seq, time,
+				entry.bKey ? "key  " : "delta", (unsigned long) entry.length);
+		nBytes += entry.length;
+		nKeys += entry.bKey;
+	}
+	if (pRing->head != pRing->tail) {
+		printf("%lu keyframes, %lu bytes per frame, %lu%% of the frames uncompressed.\n", (unsigned long) nKeys,
+				(unsigned long) (nBytes / (pRing->head - pRing->tail)),
+				(unsigned long) (nBytes * 100 / ((unsigned long long) (pRing->head - pRing->tail) * pRing->width * pRing->height)));
+	}
+}
+
+/*********************************************************************//*!
+ * @brief Decode a frame and write it to a bitmap file.
+ *
+ * @param pRing Ring file.
+ * @param n Frame number.
+ * @param prefix File name prefix.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR extractFrame(struct RING_FILE *pRing, const uint32 n, const char *prefix)
+{
+	struct RING_FILE_ENTRY entry;
+	struct OSC_PICTURE pic;
+	const uint8 *pFrame;
+	char time[24];
+	char fileName[256];
+	OSC_ERR err;
+
+	RingFileEntry(pRing, n, &entry);
+	err = RingFileRead(pRing, n, &pFrame);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to decode frame %lu! (%d)\n", __func__, (unsigned long) entry.seq, err);
+		return err;
+	}
+
+	formatTime(&entry.time, time);
+	snprintf(fileName, sizeof(fileName), "%s%s-%06lu.bmp", prefix, time, (unsigned long) entry.seq);
+	pic.width = pRing->width;
+	pic.height = pRing->height;
+	pic.type = OSC_PICTURE_GREYSCALE;
+	pic.data = (uint8 *) pFrame;
+	err = OscBmpWrite(&pic, fileName);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to write %s! (%d)\n", __func__, fileName, err);
+		return err;
+	}
+	printf("%s\n", fileName);
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Program entry.
+ * 
+ * @param argc Command line argument count.
+ * @param argv Command line argument string.
+ * @return 0 on success
+ *//*********************************************************************/
+int main(const int argc, const char * argv[])
+{
+	void *hFramework;
+	struct RING_FILE ring;
+	struct RING_FILE_ENTRY entry;
+	struct timeval time;
+	uint32 i, n = 0;
+	OSC_ERR err;
+	
+	const char *opt_seq = NULL, *opt_time = NULL, *opt_prefix = "", *opt_file = NULL;
+	int opt_all = FALSE;
+	
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: ringextract [ -h ] [ -n <seq> | -t <time> | -a ] [ -o <prefix> ] <ring file>\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -n <seq>: Extracts the frame with this sequence number.\n");
+			printf("    -t <time>: Extracts the first frame at or after YYYYMMDD-HHMMSS[-mmm].\n");
+			printf("    -a: Extracts all frames.\n");
+			printf("    -o <prefix>: Prefix of the bitmap files, may contain a directory.\n");
+			printf("    Without -n, -t or -a, the frames are listed.\n");
+			return 0;
+		} else if (argv[i][0] == '-' && strchr("nto", argv[i][1]) != NULL && argv[i][2] == '\0') {
+			if (i + 1 >= argc) {
+				printf("Error: %s needs an argument.\n", argv[i]);
+				return 1;
+			}
+			switch (argv[i][1]) {
+			case 'n':
+				opt_seq = argv[i + 1];
+				break;
+			case 't':
+				opt_time = argv[i + 1];
+				break;
+			default:
+				opt_prefix = argv[i + 1];
+				break;
+			}
+			i++;
+		} else if (strcmp(argv[i], "-a") == 0) {
+			opt_all = TRUE;
+		} else if (argv[i][0] != '-' && opt_file == NULL) {
+			opt_file = argv[i];
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (opt_file == NULL) {
+		printf("Error: No ring file given.\n");
+		return 1;
+	}
+	if (opt_time != NULL && parseTime(opt_time, &time) != SUCCESS) {
+		printf("Error: Invalid time: %s\n", opt_time);
+		return 1;
+	}
+	
+	/* Create framework */
+	OscCreate(&hFramework);
+	
+	/* Load modules */
+	OscBmpCreate(hFramework);
+	
+	err = RingFileOpen(&ring, opt_file);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to read ring file %s! (%d)\n", __func__, opt_file, err);
+	} else {
+		if (opt_all) {
+			for (n = ring.tail; n != ring.head && err == SUCCESS; n++)
+				err = extractFrame(&ring, n, opt_prefix);
+		} else if (opt_seq != NULL) {
+			err = -EINVALID_PARAMETER;
+			for (n = ring.tail; n != ring.head; n++) {
+				RingFileEntry(&ring, n, &entry);
+				if (entry.seq == strtoul(opt_seq, NULL, 10)) {
+					err = SUCCESS;
+					break;
+				}
+			}
+			if (err != SUCCESS)
+				printf("Error: No frame %s in %s.\n", opt_seq, opt_file);
+			else
+				err = extractFrame(&ring, n, opt_prefix);
+		} else if (opt_time != NULL) {
+			err = RingFileFind(&ring, &time, &n);
+			if (err != SUCCESS)
+				printf("Error: No frame at or after %s in %s.\n", opt_time, opt_file);
+			else
+				err = extractFrame(&ring, n, opt_prefix);
+		} else {
+			listFrames(&ring);
+		}
+		RingFileClose(&ring);
+	}
+	
+	/* Unload modules */
+	OscBmpDestroy(hFramework);
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	return err == SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,660 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file ringfile.c
+ * @brief Fixed size ring file of greyscale frames, delta coded.
+ * A delta record is a list of runs over the blocks in row order: two 16
+ * bit counts of unchanged and changed blocks, followed by the pixels of
+ * the changed ones. A block is changed if a pixel differs by more than
+ * the threshold from the frame before as decoded, so the error never
+ * adds up. Frames with most blocks changed are stored as keyframes.
+ * A frame is written in place, its index entry after it and the head
+ * last, so the index never refers to a record not yet written.
+ * Frames which would be overwritten are dropped from the index first,
+ * with the deltas following them up to the next keyframe. The chain of
+ * deltas since the last keyframe is kept to a quarter of the data ring,
+ * so it is never overwritten itself. Where files cannot be mapped, as on
+ * a system without MMU, records are written with pwrite instead.
+ */
+
+#include "ringfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*! @brief File format identification, "RNGF", and version. */
+#define RING_FILE_MAGIC 0x464E4752UL
+#define RING_FILE_VERSION 1
+/*! @brief Sizes of the header and of an index entry. */
+#define RING_FILE_HEADER_SIZE 64
+#define RING_FILE_ENTRY_SIZE 24
+/*! @brief Offset of the head, tail and write position in the header. */
+#define RING_FILE_POSITIONS 32
+/*! @brief Flag of a keyframe in an index entry. */
+#define RING_FILE_KEY 1
+
+/*! @brief Read a little endian 16 bit value. */
+#define GET16(p) ((uint32) (p)[0] | ((uint32) (p)[1] << 8))
+/*! @brief Read a little endian 32 bit value. */
+#define GET32(p) (GET16(p) | (GET16((p) + 2) << 16))
+
+/*********************************************************************//*!
+ * @brief Store a little endian 16 bit value.
+ *
+ * @param p Destination.
+ * @param value Value.
+ *//*********************************************************************/
+static void put16(uint8 *p, const uint32 value)
+{
+	p[0] = (uint8) value;
+	p[1] = (uint8) (value >> 8);
+}
+
+/*********************************************************************//*!
+ * @brief Store a little endian 32 bit value.
+ *
+ * @param p Destination.
+ * @param value Value.
+ *//*********************************************************************/
+static void put32(uint8 *p, const uint32 value)
+{
+	put16(p, value & 0xFFFF);
+	put16(p + 2, (value >> 16) & 0xFFFF);
+}
+
+/*********************************************************************//*!
+ * @brief Largest record of a frame: all blocks, each in a run of its own.
+ *
+ * @param pRing Ring file.
+ * @return Size in bytes
+ *//*********************************************************************/
+static uint32 maxRecord(const struct RING_FILE *pRing)
+{
+	return ((uint32) pRing->width * pRing->height + 4 * (pRing->nBlocks + 1) + 3) & ~3UL;
+}
+
+/*********************************************************************//*!
+ * @brief Set the frame size and the block counts.
+ *
+ * @param pRing Ring file.
+ * @param width Frame width.
+ * @param height Frame height.
+ *//*********************************************************************/
+static void setFrameSize(struct RING_FILE *pRing, const uint16 width, const uint16 height)
+{
+	pRing->width = width;
+	pRing->height = height;
+	pRing->blocksX = (width + RING_FILE_BLOCK - 1) / RING_FILE_BLOCK;
+	pRing->blocksY = (height + RING_FILE_BLOCK - 1) / RING_FILE_BLOCK;
+	pRing->nBlocks = (uint32) pRing->blocksX * pRing->blocksY;
+	pRing->dataOffset = RING_FILE_HEADER_SIZE + RING_FILE_INDEX * RING_FILE_ENTRY_SIZE;
+}
+
+/*********************************************************************//*!
+ * @brief Check a header and take the positions from it.
+ *
+ * @param pRing Ring file.
+ * @param pHeader Header read from the file.
+ * @param size Size of the file.
+ * @return TRUE if the header describes a valid ring file of this size
+ *//*********************************************************************/
+static int readHeader(struct RING_FILE *pRing, const uint8 *pHeader, const uint32 size)
+{
+	if (GET32(pHeader) != RING_FILE_MAGIC || GET32(pHeader + 4) != RING_FILE_VERSION ||
+			GET32(pHeader + 16) != size || GET32(pHeader + 20) != RING_FILE_INDEX ||
+			GET32(pHeader + 28) != RING_FILE_BLOCK ||
+			GET32(pHeader + 8) == 0 || GET32(pHeader + 8) > 0xFFFF ||
+			GET32(pHeader + 12) == 0 || GET32(pHeader + 12) > 0xFFFF) {
+		return FALSE;
+	}
+	setFrameSize(pRing, GET32(pHeader + 8), GET32(pHeader + 12));
+	if (size < pRing->dataOffset + maxRecord(pRing))
+		return FALSE;
+	pRing->dataSize = size - pRing->dataOffset;
+
+	pRing->head = GET32(pHeader + RING_FILE_POSITIONS);
+	pRing->tail = GET32(pHeader + RING_FILE_POSITIONS + 4);
+	pRing->writePos = GET32(pHeader + RING_FILE_POSITIONS + 8);
+	return pRing->head - pRing->tail <= RING_FILE_INDEX && pRing->writePos <= pRing->dataSize;
+}
+
+/*********************************************************************//*!
+ * @brief Store the head, tail and write position in the file.
+ *
+ * @param pRing Ring file opened for adding.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR putPositions(struct RING_FILE *pRing)
+{
+	uint8 buffer[12];
+	uint8 *p = pRing->bMapped ? pRing->pMap + RING_FILE_POSITIONS : buffer;
+
+	put32(p, pRing->head);
+	put32(p + 4, pRing->tail);
+	put32(p + 8, pRing->writePos);
+	if (!pRing->bMapped && pwrite(pRing->fd, buffer, sizeof(buffer), RING_FILE_POSITIONS) != sizeof(buffer))
+		return -EFILE_ERROR;
+	return SUCCESS;
+}
+
+OSC_ERR RingFileEntry(const struct RING_FILE *pRing, const uint32 n, struct RING_FILE_ENTRY *pEntry)
+{
+	const uint8 *p;
+
+	if (n - pRing->tail >= pRing->head - pRing->tail)
+		return -EINVALID_PARAMETER;
+
+	p = pRing->pIndex + (n % RING_FILE_INDEX) * RING_FILE_ENTRY_SIZE;
+	pEntry->seq = GET32(p);
+	pEntry->time.tv_sec = GET32(p + 4);
+	pEntry->time.tv_usec = GET32(p + 8);
+	pEntry->offset = GET32(p + 12);
+	pEntry->length = GET32(p + 16);
+	pEntry->bKey = (GET32(p + 20) & RING_FILE_KEY) != 0;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Store an index entry at the head.
+ *
+ * @param pRing Ring file opened for adding.
+ * @param pEntry Entry.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR putEntry(struct RING_FILE *pRing, const struct RING_FILE_ENTRY *pEntry)
+{
+	uint32 offset = (pRing->head % RING_FILE_INDEX) * RING_FILE_ENTRY_SIZE;
+	uint8 *p = pRing->pIndex + offset;
+
+	put32(p, pEntry->seq);
+	put32(p + 4, pEntry->time.tv_sec);
+	put32(p + 8, pEntry->time.tv_usec);
+	put32(p + 12, pEntry->offset);
+	put32(p + 16, pEntry->length);
+	put32(p + 20, pEntry->bKey ? RING_FILE_KEY : 0);
+	if (!pRing->bMapped && pwrite(pRing->fd, p, RING_FILE_ENTRY_SIZE, RING_FILE_HEADER_SIZE + offset) != RING_FILE_ENTRY_SIZE)
+		return -EFILE_ERROR;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Drop the oldest frames whose records lie in a range of the data
+ * ring, and the deltas depending on them.
+ *
+ * The records are in the order of the frames, so the frames to drop are
+ * the oldest ones.
+ *
+ * @param pRing Ring file opened for adding.
+ * @param start Start of the range.
+ * @param end End of the range.
+ *//*********************************************************************/
+static void dropFrames(struct RING_FILE *pRing, const uint32 start, const uint32 end)
+{
+	struct RING_FILE_ENTRY entry;
+
+	while (RingFileEntry(pRing, pRing->tail, &entry) == SUCCESS &&
+			entry.offset < end && entry.offset + entry.length > start) {
+		pRing->tail++;
+	}
+	if (pRing->head - pRing->tail == RING_FILE_INDEX)
+		pRing->tail++;
+	while (RingFileEntry(pRing, pRing->tail, &entry) == SUCCESS && !entry.bKey)
+		pRing->tail++;
+}
+
+/*********************************************************************//*!
+ * @brief Get the position and size of a block.
+ *
+ * @param pRing Ring file.
+ * @param iBlock Block number in row order.
+ * @param pOffset Offset of the top left pixel in the frame.
+ * @param pWidth Width of the block.
+ * @param pHeight Height of the block.
+ *//*********************************************************************/
+static void blockRect(const struct RING_FILE *pRing, const uint32 iBlock, uint32 *pOffset, uint16 *pWidth, uint16 *pHeight)
+{
+	uint16 x = (iBlock % pRing->blocksX) * RING_FILE_BLOCK;
+	uint16 y = (iBlock / pRing->blocksX) * RING_FILE_BLOCK;
+
+	*pOffset = (uint32) y * pRing->width + x;
+	*pWidth = pRing->width - x < RING_FILE_BLOCK ? pRing->width - x : RING_FILE_BLOCK;
+	*pHeight = pRing->height - y < RING_FILE_BLOCK ? pRing->height - y : RING_FILE_BLOCK;
+}
+
+/*********************************************************************//*!
+ * @brief Flag the blocks which changed against the reference.
+ *
+ * @param pRing Ring file with a reference frame.
+ * @param pFrame Frame.
+ * @return Number of changed blocks
+ *//*********************************************************************/
+static uint32 findChanges(struct RING_FILE *pRing, const uint8 *pFrame)
+{
+	uint32 iBlock, offset, nChanged = 0;
+	uint16 width, height, x, y;
+	const uint8 *pNew, *pOld;
+	int diff, bChanged;
+
+	for (iBlock = 0; iBlock < pRing->nBlocks; iBlock++) {
+		blockRect(pRing, iBlock, &offset, &width, &height);
+		bChanged = FALSE;
+		for (y = 0; y < height && !bChanged; y++) {
+			pNew = pFrame + offset + (uint32) y * pRing->width;
+			pOld = pRing->pRef + offset + (uint32) y * pRing->width;
+			for (x = 0; x < width; x++) {
+				diff = (int) pNew[x] - pOld[x];
+				if (diff > pRing->threshold || -diff > pRing->threshold) {
+					bChanged = TRUE;
+					break;
+				}
+			}
+		}
+		pRing->pChanged[iBlock] = bChanged;
+		nChanged += bChanged;
+	}
+	return nChanged;
+}
+
+/*********************************************************************//*!
+ * @brief Copy a block between a frame and a record.
+ *
+ * @param pRing Ring file.
+ * @param iBlock Block number.
+ * @param pFrame Frame.
+ * @param pRecord Position in the record.
+ * @param bToRecord TRUE to copy from the frame to the record.
+ * @return Bytes copied
+ *//*********************************************************************/
+static uint32 copyBlock(const struct RING_FILE *pRing, const uint32 iBlock, uint8 *pFrame, uint8 *pRecord, const int bToRecord)
+{
+	uint32 offset;
+	uint16 width, height, y;
+
+	blockRect(pRing, iBlock, &offset, &width, &height);
+	for (y = 0; y < height; y++) {
+		if (bToRecord)
+			memcpy(pRecord, pFrame + offset, width);
+		else
+			memcpy(pFrame + offset, pRecord, width);
+		pRecord += width;
+		offset += pRing->width;
+	}
+	return (uint32) width * height;
+}
+
+/*********************************************************************//*!
+ * @brief Code the changed blocks as delta record and update the reference.
+ *
+ * @param pRing Ring file with changed flags.
+ * @param pFrame Frame.
+ * @param pRecord Record, of maxRecord bytes.
+ * @return Length of the record
+ *//*********************************************************************/
+static uint32 encodeDelta(struct RING_FILE *pRing, const uint8 *pFrame, uint8 *pRecord)
+{
+	uint32 iBlock = 0, first, skip, count, length = 0;
+
+	while (iBlock < pRing->nBlocks) {
+		for (skip = 0; iBlock < pRing->nBlocks && !pRing->pChanged[iBlock] && skip < 0xFFFF; skip++)
+			iBlock++;
+		first = iBlock;
+		for (count = 0; iBlock < pRing->nBlocks && pRing->pChanged[iBlock] && count < 0xFFFF; count++)
+			iBlock++;
+
+		put16(pRecord + length, skip);
+		put16(pRecord + length + 2, count);
+		length += 4;
+		for (; first < iBlock; first++) {
+			copyBlock(pRing, first, (uint8 *) pFrame, pRecord + length, TRUE);
+			length += copyBlock(pRing, first, pRing->pRef, pRecord + length, FALSE);
+		}
+	}
+	return length;
+}
+
+/*********************************************************************//*!
+ * @brief Apply a record to the reference frame.
+ *
+ * @param pRing Ring file.
+ * @param pEntry Index entry of the record.
+ * @return SUCCESS or -EFILE_ERROR if the record is corrupt
+ *//*********************************************************************/
+static OSC_ERR decode(struct RING_FILE *pRing, const struct RING_FILE_ENTRY *pEntry)
+{
+	const uint32 frameSize = (uint32) pRing->width * pRing->height;
+	uint8 *pRecord = pRing->pData + pEntry->offset;
+	uint32 iBlock = 0, skip, count, offset, length = 0;
+	uint16 width, height;
+
+	if (pEntry->offset > pRing->dataSize || pEntry->length > pRing->dataSize - pEntry->offset)
+		return -EFILE_ERROR;
+	if (pEntry->bKey) {
+		if (pEntry->length != frameSize)
+			return -EFILE_ERROR;
+		memcpy(pRing->pRef, pRecord, frameSize);
+		return SUCCESS;
+	}
+
+	while (iBlock < pRing->nBlocks) {
+		if (length + 4 > pEntry->length)
+			return -EFILE_ERROR;
+		skip = GET16(pRecord + length);
+		count = GET16(pRecord + length + 2);
+		length += 4;
+		if (skip + count > pRing->nBlocks - iBlock || (skip == 0 && count == 0))
+			return -EFILE_ERROR;
+		for (iBlock += skip; count > 0; count--, iBlock++) {
+			blockRect(pRing, iBlock, &offset, &width, &height);
+			if (length + (uint32) width * height > pEntry->length)
+				return -EFILE_ERROR;
+			length += copyBlock(pRing, iBlock, pRing->pRef, pRecord + length, FALSE);
+		}
+	}
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Allocate the reference frame and the changed flags.
+ *
+ * @param pRing Ring file.
+ * @return SUCCESS or -EOUT_OF_MEMORY
+ *//*********************************************************************/
+static OSC_ERR allocFrames(struct RING_FILE *pRing)
+{
+	pRing->pRef = malloc((uint32) pRing->width * pRing->height);
+	pRing->pChanged = malloc(pRing->nBlocks);
+	if (pRing->pRef == NULL || pRing->pChanged == NULL)
+		return -EOUT_OF_MEMORY;
+	return SUCCESS;
+}
+
+OSC_ERR RingFileCreate(struct RING_FILE *pRing,
+		const char *fileName,
+		const uint16 width,
+		const uint16 height,
+		const uint32 size,
+		const uint32 keyInterval,
+		const uint8 threshold)
+{
+	uint8 header[RING_FILE_HEADER_SIZE];
+	struct stat st;
+	OSC_ERR err;
+
+	memset(pRing, 0, sizeof(struct RING_FILE));
+	pRing->fd = -1;
+	if (width == 0 || height == 0 || keyInterval == 0 || keyInterval > RING_FILE_INDEX / 2)
+		return -EINVALID_PARAMETER;
+	setFrameSize(pRing, width, height);
+	if (size < pRing->dataOffset + 8 * maxRecord(pRing))
+		return -EINVALID_PARAMETER;
+	pRing->size = size;
+	pRing->dataSize = size - pRing->dataOffset;
+	pRing->keyInterval = keyInterval;
+	pRing->threshold = threshold;
+	pRing->bWritable = TRUE;
+
+	pRing->fd = open(fileName, O_RDWR | O_CREAT, 0644);
+	if (pRing->fd < 0)
+		return -EUNABLE_TO_OPEN_FILE;
+
+	/* Continue a ring file of the same geometry, otherwise start empty. */
+	if (fstat(pRing->fd, &st) != 0 || st.st_size != size ||
+			pread(pRing->fd, header, RING_FILE_HEADER_SIZE, 0) != RING_FILE_HEADER_SIZE ||
+			!readHeader(pRing, header, size) || pRing->width != width || pRing->height != height) {
+		setFrameSize(pRing, width, height);
+		pRing->head = pRing->tail = pRing->writePos = 0;
+
+		memset(header, 0, RING_FILE_HEADER_SIZE);
+		put32(header, RING_FILE_MAGIC);
+		put32(header + 4, RING_FILE_VERSION);
+		put32(header + 8, width);
+		put32(header + 12, height);
+		put32(header + 16, size);
+		put32(header + 20, RING_FILE_INDEX);
+		put32(header + 24, pRing->dataOffset);
+		put32(header + 28, RING_FILE_BLOCK);
+		if (ftruncate(pRing->fd, 0) != 0 || ftruncate(pRing->fd, size) != 0 ||
+				pwrite(pRing->fd, header, RING_FILE_HEADER_SIZE, 0) != RING_FILE_HEADER_SIZE) {
+			RingFileClose(pRing);
+			return -EFILE_ERROR;
+		}
+	}
+
+	err = allocFrames(pRing);
+	if (err == SUCCESS) {
+		pRing->pMap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, pRing->fd, 0);
+		if (pRing->pMap != MAP_FAILED) {
+			pRing->bMapped = TRUE;
+			pRing->pIndex = pRing->pMap + RING_FILE_HEADER_SIZE;
+			pRing->pData = pRing->pMap + pRing->dataOffset;
+		} else {
+			/* No shared mapping available, keep a copy of the index. */
+			pRing->pMap = NULL;
+			pRing->pIndex = malloc(RING_FILE_INDEX * RING_FILE_ENTRY_SIZE);
+			pRing->pRecord = malloc(maxRecord(pRing));
+			if (pRing->pIndex == NULL || pRing->pRecord == NULL) {
+				err = -EOUT_OF_MEMORY;
+			} else if (pread(pRing->fd, pRing->pIndex, RING_FILE_INDEX * RING_FILE_ENTRY_SIZE, RING_FILE_HEADER_SIZE) !=
+					RING_FILE_INDEX * RING_FILE_ENTRY_SIZE) {
+				err = -EFILE_ERROR;
+			}
+		}
+	}
+	if (err != SUCCESS) {
+		RingFileClose(pRing);
+		return err;
+	}
+	return SUCCESS;
+}
+
+OSC_ERR RingFileAdd(struct RING_FILE *pRing,
+		const uint8 *pFrame,
+		const struct timeval *pTime,
+		const uint32 seq)
+{
+	const uint32 frameSize = (uint32) pRing->width * pRing->height;
+	const uint32 max = maxRecord(pRing);
+	struct RING_FILE_ENTRY entry;
+	uint32 pos = pRing->writePos;
+	uint8 *pRecord;
+	int bKey;
+	OSC_ERR err;
+
+	if (!pRing->bWritable)
+		return -EINVALID_PARAMETER;
+
+	/* A keyframe starts a new chain of deltas when due or if most blocks changed. */
+	bKey = !pRing->bRef || pRing->sinceKey >= pRing->keyInterval || pRing->chainBytes > pRing->dataSize / 4;
+	if (!bKey)
+		bKey = findChanges(pRing, pFrame) * 2 > pRing->nBlocks;
+
+	/* Make room for the largest record, wrapping around at the end. */
+	if (pos + max > pRing->dataSize) {
+		dropFrames(pRing, pos, pRing->dataSize);
+		pRing->chainBytes += pRing->dataSize - pos;
+		pos = 0;
+	}
+	dropFrames(pRing, pos, pos + max);
+	err = putPositions(pRing);
+	if (err != SUCCESS)
+		return err;
+
+	pRecord = pRing->bMapped ? pRing->pData + pos : pRing->pRecord;
+	if (bKey) {
+		memcpy(pRecord, pFrame, frameSize);
+		memcpy(pRing->pRef, pFrame, frameSize);
+		entry.length = frameSize;
+	} else {
+		entry.length = encodeDelta(pRing, pFrame, pRecord);
+	}
+	entry.seq = seq;
+	entry.time = *pTime;
+	entry.offset = pos;
+	entry.bKey = bKey;
+
+	if (!pRing->bMapped && pwrite(pRing->fd, pRecord, entry.length, pRing->dataOffset + pos) != (ssize_t) entry.length)
+		err = -EFILE_ERROR;
+	if (err == SUCCESS)
+		err = putEntry(pRing, &entry);
+	if (err == SUCCESS) {
+		pRing->head++;
+		pRing->writePos = pos + ((entry.length + 3) & ~3UL);
+		err = putPositions(pRing);
+	}
+	if (err != SUCCESS) {
+		/* The reference may be ahead of the file, start over with a keyframe. */
+		pRing->bRef = FALSE;
+		return err;
+	}
+
+	pRing->bRef = TRUE;
+	pRing->sinceKey = bKey ? 1 : pRing->sinceKey + 1;
+	pRing->chainBytes = (bKey ? 0 : pRing->chainBytes) + ((entry.length + 3) & ~3UL);
+	pRing->nFrames++;
+	pRing->nKeys += bKey;
+	pRing->nBytes += entry.length;
+	return SUCCESS;
+}
+
+OSC_ERR RingFileOpen(struct RING_FILE *pRing, const char *fileName)
+{
+	struct stat st;
+	OSC_ERR err = SUCCESS;
+
+	memset(pRing, 0, sizeof(struct RING_FILE));
+	pRing->fd = open(fileName, O_RDONLY);
+	if (pRing->fd < 0)
+		return -EUNABLE_TO_OPEN_FILE;
+	if (fstat(pRing->fd, &st) != 0 || st.st_size < RING_FILE_HEADER_SIZE) {
+		RingFileClose(pRing);
+		return -EFILE_ERROR;
+	}
+	pRing->size = st.st_size;
+
+	pRing->pMap = mmap(NULL, pRing->size, PROT_READ, MAP_PRIVATE, pRing->fd, 0);
+	if (pRing->pMap != MAP_FAILED) {
+		pRing->bMapped = TRUE;
+	} else {
+		/* No mapping available, read the file in one piece. */
+		pRing->pMap = malloc(pRing->size);
+		if (pRing->pMap == NULL)
+			err = -EOUT_OF_MEMORY;
+		else if (read(pRing->fd, pRing->pMap, pRing->size) != (ssize_t) pRing->size)
+			err = -EFILE_ERROR;
+	}
+
+	if (err == SUCCESS && !readHeader(pRing, pRing->pMap, pRing->size))
+		err = -EFILE_ERROR;
+	if (err == SUCCESS) {
+		pRing->pIndex = pRing->pMap + RING_FILE_HEADER_SIZE;
+		pRing->pData = pRing->pMap + pRing->dataOffset;
+		err = allocFrames(pRing);
+	}
+	if (err != SUCCESS) {
+		RingFileClose(pRing);
+		return err;
+	}
+	return SUCCESS;
+}
+
+OSC_ERR RingFileFind(const struct RING_FILE *pRing, const struct timeval *pTime, uint32 *pN)
+{
+	struct RING_FILE_ENTRY entry;
+	uint32 first = pRing->tail, end = pRing->head, n;
+
+	/* The frames are in time order. */
+	while (first != end) {
+		n = first + (end - first) / 2;
+		RingFileEntry(pRing, n, &entry);
+		if (entry.time.tv_sec < pTime->tv_sec ||
+				(entry.time.tv_sec == pTime->tv_sec && entry.time.tv_usec < pTime->tv_usec)) {
+			first = n + 1;
+		} else {
+			end = n;
+		}
+	}
+	if (first == pRing->head)
+		return -EINVALID_PARAMETER;
+
+	*pN = first;
+	return SUCCESS;
+}
+
+OSC_ERR RingFileRead(struct RING_FILE *pRing, const uint32 n, const uint8 **ppFrame)
+{
+	struct RING_FILE_ENTRY entry;
+	uint32 first;
+	OSC_ERR err;
+
+	if (pRing->bWritable)
+		return -EINVALID_PARAMETER;
+
+	/* Go back to the keyframe, or to the frame read last. */
+	for (first = n; ; first--) {
+		if (pRing->bRef && pRing->refFrame == first) {
+			first++;
+			break;
+		}
+		err = RingFileEntry(pRing, first, &entry);
+		if (err != SUCCESS)
+			return err;
+		if (entry.bKey)
+			break;
+	}
+
+	pRing->bRef = FALSE;
+	for (; first != n + 1; first++) {
+		RingFileEntry(pRing, first, &entry);
+		err = decode(pRing, &entry);
+		if (err != SUCCESS)
+			return err;
+	}
+	pRing->bRef = TRUE;
+	pRing->refFrame = n;
+
+	*ppFrame = pRing->pRef;
+	return SUCCESS;
+}
+
+OSC_ERR RingFileClose(struct RING_FILE *pRing)
+{
+	OSC_ERR err = SUCCESS;
+
+	if (pRing->bMapped) {
+		if (pRing->bWritable && msync(pRing->pMap, pRing->size, MS_SYNC) != 0)
+			err = -EFILE_ERROR;
+		munmap(pRing->pMap, pRing->size);
+	} else if (pRing->pMap != NULL) {
+		free(pRing->pMap);
+	} else {
+		free(pRing->pIndex);
+	}
+	if (pRing->fd >= 0 && close(pRing->fd) != 0)
+		err = -EFILE_ERROR;
+
+	free(pRing->pRef);
+	free(pRing->pChanged);
+	free(pRing->pRecord);
+	memset(pRing, 0, sizeof(struct RING_FILE));
+	pRing->fd = -1;
+	return err;
+}
@@ -0,0 +1,179 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file ringfile.h
+ * @brief Fixed size ring file of greyscale frames, delta coded.
+ * The file holds a header, an index of the frames and a data ring. A frame
+ * is stored either whole (a keyframe) or as the blocks which changed since
+ * the frame before, so a static scene costs a few bytes per frame. When
+ * the data ring is full, the oldest frames are overwritten. The index
+ * gives the sequence number and time of each frame, for seeking by time.
+ */
+
+#ifndef RINGFILE_H_
+#define RINGFILE_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include <sys/time.h>
+
+/*! @brief Side of the blocks compared and stored, in pixels. */
+#define RING_FILE_BLOCK 16
+/*! @brief Frames in the index. */
+#define RING_FILE_INDEX 4096
+
+/*! @brief A frame of the index. */
+struct RING_FILE_ENTRY {
+	/*! @brief Sequence number and time of the frame. */
+	uint32 seq;
+	struct timeval time;
+	/*! @brief Record of the frame in the data ring. */
+	uint32 offset, length;
+	/*! @brief TRUE if the frame is stored whole. */
+	int bKey;
+};
+
+/*! @brief State of an open ring file. */
+struct RING_FILE {
+	/*! @brief File, mapped if possible. */
+	int fd;
+	uint8 *pMap;
+	uint32 size;
+	int bMapped;
+	/*! @brief TRUE if opened for adding frames. */
+	int bWritable;
+	/*! @brief Frame size. */
+	uint16 width, height;
+	/*! @brief Blocks per frame. */
+	uint16 blocksX, blocksY;
+	uint32 nBlocks;
+	/*! @brief Index, in the mapping or a copy. */
+	uint8 *pIndex;
+	/*! @brief Data ring, in the mapping (NULL if not mapped). */
+	uint8 *pData;
+	uint32 dataOffset, dataSize;
+	/*! @brief Frames tail to head - 1 are in the index, tail is a keyframe. */
+	uint32 head, tail;
+	/*! @brief Offset in the data ring of the next record. */
+	uint32 writePos;
+	/*! @brief Largest pixel change of an unchanged block. */
+	uint8 threshold;
+	/*! @brief Frames between keyframes. */
+	uint32 keyInterval;
+	/*! @brief Frames and data ring bytes since the last keyframe. */
+	uint32 sinceKey, chainBytes;
+	/*! @brief Frame last added or read, the reference of the next delta. */
+	uint8 *pRef;
+	int bRef;
+	uint32 refFrame;
+	/*! @brief Changed flags of the blocks. */
+	uint8 *pChanged;
+	/*! @brief Record buffer if the file is not mapped. */
+	uint8 *pRecord;
+	/*! @brief Statistics. */
+	uint32 nFrames, nKeys;
+	unsigned long long nBytes;
+};
+
+/*********************************************************************//*!
+ * @brief Open a ring file to add frames to.
+ *
+ * A ring file of the same size and frame size is continued, otherwise the
+ * file is created empty.
+ *
+ * @param pRing Ring file to open.
+ * @param fileName File name.
+ * @param width Frame width.
+ * @param height Frame height.
+ * @param size File size in bytes, room for at least 8 frames.
+ * @param keyInterval Frames between keyframes (1 .. RING_FILE_INDEX / 2).
+ * @param threshold Largest pixel change of a block left unchanged.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RingFileCreate(struct RING_FILE *pRing,
+		const char *fileName,
+		const uint16 width,
+		const uint16 height,
+		const uint32 size,
+		const uint32 keyInterval,
+		const uint8 threshold);
+
+/*********************************************************************//*!
+ * @brief Add a frame, overwriting the oldest ones if the ring is full.
+ *
+ * @param pRing Ring file opened by RingFileCreate.
+ * @param pFrame Greyscale frame.
+ * @param pTime Time of the frame.
+ * @param seq Sequence number of the frame.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RingFileAdd(struct RING_FILE *pRing,
+		const uint8 *pFrame,
+		const struct timeval *pTime,
+		const uint32 seq);
+
+/*********************************************************************//*!
+ * @brief Open a ring file to read its frames.
+ *
+ * @param pRing Ring file to open.
+ * @param fileName File name.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RingFileOpen(struct RING_FILE *pRing, const char *fileName);
+
+/*********************************************************************//*!
+ * @brief Get a frame of the index.
+ *
+ * @param pRing Ring file.
+ * @param n Frame number, from tail to head - 1.
+ * @param pEntry The frame.
+ * @return SUCCESS or -EINVALID_PARAMETER if the frame is not in the index
+ *//*********************************************************************/
+OSC_ERR RingFileEntry(const struct RING_FILE *pRing, const uint32 n, struct RING_FILE_ENTRY *pEntry);
+
+/*********************************************************************//*!
+ * @brief Find the first frame taken at or after a time.
+ *
+ * @param pRing Ring file.
+ * @param pTime Time.
+ * @param pN Frame number.
+ * @return SUCCESS or -EINVALID_PARAMETER if all frames are older
+ *//*********************************************************************/
+OSC_ERR RingFileFind(const struct RING_FILE *pRing, const struct timeval *pTime, uint32 *pN);
+
+/*********************************************************************//*!
+ * @brief Decode a frame.
+ *
+ * The frame is decoded from the keyframe before it, or from the frame
+ * read last if that is on the way.
+ *
+ * @param pRing Ring file.
+ * @param n Frame number, from tail to head - 1.
+ * @param ppFrame The frame, valid until the next call.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RingFileRead(struct RING_FILE *pRing, const uint32 n, const uint8 **ppFrame);
+
+/*********************************************************************//*!
+ * @brief Close a ring file.
+ *
+ * @param pRing Ring file.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR RingFileClose(struct RING_FILE *pRing);
+
+#endif /* RINGFILE_H_ */
@@ -0,0 +1,183 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file simcam.c
+ * @brief Simulated cameras, any number of them in one process.
+ * Nothing is shared between the instances but the source frames, which
+ * are never written, so no locking is needed.
+ * The grey levels are taken as proportional to the exposure time, up to
+ * saturation, and scaled through a table rebuilt when the exposure time
+ * changes.
+ */
+
+#include "simcam.h"
+#include <string.h>
+
+OSC_ERR SimCamInit(struct SIM_CAMERA *pCam, const struct REPLAY *pSource, const uint32 firstFrame)
+{
+	if (pSource->nFrames == 0)
+		return -EINVALID_PARAMETER;
+
+	memset(pCam, 0, sizeof(struct SIM_CAMERA));
+	pCam->pSource = pSource;
+	pCam->iNext = firstFrame % pSource->nFrames;
+	pCam->width = pSource->width;
+	pCam->height = pSource->height;
+	pCam->pending = -1;
+	return SUCCESS;
+}
+
+OSC_ERR SimCamSetAreaOfInterest(struct SIM_CAMERA *pCam,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height)
+{
+	if (width == 0 || height == 0 ||
+			(uint32) x + width > pCam->pSource->width || (uint32) y + height > pCam->pSource->height)
+		return -EINVALID_PARAMETER;
+	if (pCam->pending >= 0)
+		return -EDEVICE;
+
+	pCam->x = x;
+	pCam->y = y;
+	pCam->width = width;
+	pCam->height = height;
+	return SUCCESS;
+}
+
+OSC_ERR SimCamSetShutterWidth(struct SIM_CAMERA *pCam, const uint32 shutterWidth)
+{
+	pCam->shutterWidth = shutterWidth;
+	return SUCCESS;
+}
+
+OSC_ERR SimCamSetSourceShutter(struct SIM_CAMERA *pCam, const uint32 sourceShutter)
+{
+	pCam->sourceShutter = sourceShutter;
+	memset(pCam->lut, 0, sizeof(pCam->lut));
+	pCam->lutShutter = 0;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Scale a picture read out to the exposure time.
+ *
+ * @param pCam Camera with an emulated exposure.
+ * @param pData Picture of the area of interest.
+ *//*********************************************************************/
+static void expose(struct SIM_CAMERA *pCam, uint8 *pData)
+{
+	uint32 i, n = (uint32) pCam->width * pCam->height;
+	unsigned long long level;
+
+	if (pCam->lutShutter != pCam->activeShutter) {
+		for (i = 0; i < 256; i++) {
+			level = ((unsigned long long) i * pCam->activeShutter + pCam->sourceShutter / 2) / pCam->sourceShutter;
+			pCam->lut[i] = level > 255 ? 255 : (uint8) level;
+		}
+		pCam->lutShutter = pCam->activeShutter;
+	}
+	for (i = 0; i < n; i++)
+		pData[i] = pCam->lut[pData[i]];
+}
+
+OSC_ERR SimCamSetFrameBuffer(struct SIM_CAMERA *pCam,
+		const uint8 id,
+		const uint32 size,
+		uint8 *pData)
+{
+	if (id >= SIM_CAM_MAX_BUFFERS || pData == NULL)
+		return -EINVALID_PARAMETER;
+
+	pCam->pBuffers[id] = pData;
+	pCam->bufferSizes[id] = size;
+	return SUCCESS;
+}
+
+OSC_ERR SimCamSetupCapture(struct SIM_CAMERA *pCam, const uint8 id)
+{
+	if (id >= SIM_CAM_MAX_BUFFERS || pCam->pBuffers[id] == NULL ||
+			pCam->bufferSizes[id] < (uint32) pCam->width * pCam->height)
+		return -EINVALID_PARAMETER;
+	if (pCam->pending >= 0)
+		return -EDEVICE;
+
+	pCam->pending = id;
+	pCam->bTriggered = FALSE;
+	return SUCCESS;
+}
+
+OSC_ERR SimGpioTriggerImage(struct SIM_CAMERA *pCam)
+{
+	if (pCam->pending < 0)
+		return -EDEVICE;
+
+	pCam->bTriggered = TRUE;
+	return SUCCESS;
+}
+
+OSC_ERR SimCamReadPicture(struct SIM_CAMERA *pCam, const uint8 id, uint8 **ppData)
+{
+	const struct REPLAY *pSource = pCam->pSource;
+	const uint8 *pSrc;
+	uint8 *pDst;
+	uint16 y;
+
+	if (pCam->pending != id || !pCam->bTriggered)
+		return -EDEVICE;
+
+	/* Read out the area of interest of the next frame */
+	pSrc = pSource->pFrames[pCam->iNext].pData + (uint32) pCam->y * pSource->width + pCam->x;
+	pDst = pCam->pBuffers[id];
+	if (pCam->width == pSource->width) {
+		memcpy(pDst, pSrc, (uint32) pCam->width * pCam->height);
+	} else {
+		for (y = 0; y < pCam->height; y++)
+			memcpy(pDst + (uint32) y * pCam->width, pSrc + (uint32) y * pSource->width, pCam->width);
+	}
+	if (pCam->sourceShutter != 0)
+		expose(pCam, pDst);
+	pCam->iNext = (pCam->iNext + 1) % pSource->nFrames;
+	pCam->nCaptured++;
+
+	/* The shutter width set meanwhile applies from the next picture. */
+	pCam->activeShutter = pCam->shutterWidth;
+
+	pCam->pending = -1;
+	*ppData = pDst;
+	return SUCCESS;
+}
+
+OSC_ERR SimGpioWrite(struct SIM_CAMERA *pCam, const enum EnGpios pin, const int bState)
+{
+	if ((uint32) pin >= SIM_CAM_GPIOS)
+		return -EINVALID_PARAMETER;
+
+	pCam->gpios[pin] = bState;
+	return SUCCESS;
+}
+
+OSC_ERR SimGpioRead(struct SIM_CAMERA *pCam, const enum EnGpios pin, int *pbState)
+{
+	if ((uint32) pin >= SIM_CAM_GPIOS)
+		return -EINVALID_PARAMETER;
+
+	*pbState = pCam->gpios[pin];
+	return SUCCESS;
+}
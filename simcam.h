@@ -0,0 +1,188 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file simcam.h
+ * @brief Simulated cameras, any number of them in one process.
+ * The oscar cam and gpio modules drive one camera through global state.
+ * A simulated camera keeps the same state per instance instead: its frame
+ * buffers, area of interest, shutter width, pending capture and GPIO
+ * outputs. The functions mirror those of the modules, taking the camera
+ * as first argument, so a pipeline written against them runs unchanged
+ * for one camera per thread. The pictures come from a replay shared by
+ * all cameras, which is only read. Bitmaps are read and written per
+ * instance with bmpmap.h.
+ * Given the shutter width the source frames were taken with, the pictures
+ * are brightened or darkened by the shutter width set. As on the sensor,
+ * a new shutter width takes effect from the second picture read out after
+ * it is set, so the first picture of all is exposed with none and black.
+ */
+
+#ifndef SIMCAM_H_
+#define SIMCAM_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "replay.h"
+
+/*! @brief Maximum number of frame buffers of a camera. */
+#define SIM_CAM_MAX_BUFFERS 8
+/*! @brief Number of GPIO pins (EnGpios). */
+#define SIM_CAM_GPIOS 4
+
+/*! @brief State of a simulated camera. */
+struct SIM_CAMERA {
+	/*! @brief Source of the pictures, shared and read only. */
+	const struct REPLAY *pSource;
+	/*! @brief Next source frame to capture. */
+	uint32 iNext;
+	/*! @brief Frame buffers and their sizes. */
+	uint8 *pBuffers[SIM_CAM_MAX_BUFFERS];
+	uint32 bufferSizes[SIM_CAM_MAX_BUFFERS];
+	/*! @brief Area of interest. */
+	uint16 x, y, width, height;
+	/*! @brief Exposure time [us]. */
+	uint32 shutterWidth;
+	/*! @brief Exposure time of the source frames [us], 0 if they are
+	 * taken as they are. */
+	uint32 sourceShutter;
+	/*! @brief Exposure time of the next picture [us]. */
+	uint32 activeShutter;
+	/*! @brief Grey levels of the source scaled to activeShutter. */
+	uint8 lut[256];
+	uint32 lutShutter;
+	/*! @brief Buffer of the capture set up, -1 if none, and TRUE once it
+	 * is triggered. */
+	int pending;
+	int bTriggered;
+	/*! @brief Levels of the GPIO pins. */
+	int gpios[SIM_CAM_GPIOS];
+	/*! @brief Pictures captured. */
+	uint32 nCaptured;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a camera with the full sensor as area of interest.
+ *
+ * @param pCam Camera to initialize.
+ * @param pSource Opened replay the pictures are taken from.
+ * @param firstFrame First source frame, so that cameras sharing a source
+ * see different scenes.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamInit(struct SIM_CAMERA *pCam, const struct REPLAY *pSource, const uint32 firstFrame);
+
+/*********************************************************************//*!
+ * @brief Set the area of interest (as OscCamSetAreaOfInterest).
+ *
+ * @param pCam Camera.
+ * @param x Left column.
+ * @param y Top row.
+ * @param width Width.
+ * @param height Height.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamSetAreaOfInterest(struct SIM_CAMERA *pCam,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height);
+
+/*********************************************************************//*!
+ * @brief Set the exposure time (as OscCamSetShutterWidth).
+ *
+ * @param pCam Camera.
+ * @param shutterWidth Exposure time [us].
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamSetShutterWidth(struct SIM_CAMERA *pCam, const uint32 shutterWidth);
+
+/*********************************************************************//*!
+ * @brief Emulate the exposure of the pictures.
+ *
+ * @param pCam Camera.
+ * @param sourceShutter Exposure time the source frames were taken with
+ * [us], 0 to take them as they are.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamSetSourceShutter(struct SIM_CAMERA *pCam, const uint32 sourceShutter);
+
+/*********************************************************************//*!
+ * @brief Register a frame buffer (as OscCamSetFrameBuffer).
+ *
+ * @param pCam Camera.
+ * @param id Frame buffer ID (0 .. SIM_CAM_MAX_BUFFERS - 1).
+ * @param size Size of the buffer in bytes.
+ * @param pData Buffer.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamSetFrameBuffer(struct SIM_CAMERA *pCam,
+		const uint8 id,
+		const uint32 size,
+		uint8 *pData);
+
+/*********************************************************************//*!
+ * @brief Set up the capture into a frame buffer (as OscCamSetupCapture).
+ *
+ * @param pCam Camera.
+ * @param id Frame buffer ID.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamSetupCapture(struct SIM_CAMERA *pCam, const uint8 id);
+
+/*********************************************************************//*!
+ * @brief Trigger the capture set up (as OscGpioTriggerImage).
+ *
+ * @param pCam Camera.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimGpioTriggerImage(struct SIM_CAMERA *pCam);
+
+/*********************************************************************//*!
+ * @brief Read a triggered picture (as OscCamReadPicture).
+ *
+ * The area of interest of the next source frame is copied to the frame
+ * buffer, rows without gaps, and scaled to the exposure time if emulated.
+ *
+ * @param pCam Camera.
+ * @param id Frame buffer ID of the capture.
+ * @param ppData The picture.
+ * @return SUCCESS, -EDEVICE if no capture into the buffer was triggered,
+ * or another appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimCamReadPicture(struct SIM_CAMERA *pCam, const uint8 id, uint8 **ppData);
+
+/*********************************************************************//*!
+ * @brief Set a GPIO pin (as OscGpioWrite).
+ *
+ * @param pCam Camera.
+ * @param pin Pin.
+ * @param bState Level.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimGpioWrite(struct SIM_CAMERA *pCam, const enum EnGpios pin, const int bState);
+
+/*********************************************************************//*!
+ * @brief Read a GPIO pin (as OscGpioRead).
+ *
+ * @param pCam Camera.
+ * @param pin Pin.
+ * @param pbState Level.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR SimGpioRead(struct SIM_CAMERA *pCam, const enum EnGpios pin, int *pbState);
+
+#endif /* SIMCAM_H_ */
@@ -0,0 +1,105 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file thumb.c
+ * @brief Thumbnails of greyscale and raw pictures gathered by DMA.
+ * The thumbnail is a single planned move reading every step-th byte of
+ * every step-th picture row. Requires the sup and dma modules to be loaded.
+ */
+
+#include "thumb.h"
+#include <string.h>
+
+#if defined(OSC_TARGET)
+#include <sys/cachectl.h>
+#endif
+
+OSC_ERR ThumbInit(struct THUMB *pThumb,
+		const uint16 srcWidth,
+		const uint16 srcHeight,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0,
+		uint8 *pData)
+{
+	if (step == 0 || x0 >= srcWidth || y0 >= srcHeight)
+		return -EINVALID_PARAMETER;
+
+	memset(pThumb, 0, sizeof(struct THUMB));
+	pThumb->srcWidth = srcWidth;
+	pThumb->srcHeight = srcHeight;
+	pThumb->step = step;
+	pThumb->x0 = x0;
+	pThumb->y0 = y0;
+	pThumb->width = (srcWidth - x0 + step - 1) / step;
+	pThumb->height = (srcHeight - y0 + step - 1) / step;
+	pThumb->pData = pData;
+
+	pThumb->move.pDst = pData;
+	pThumb->move.dstStride = pThumb->width;
+	pThumb->move.srcStride = (long) step * srcWidth;
+	pThumb->move.srcStep = step;
+	pThumb->move.width = pThumb->width;
+	pThumb->move.height = pThumb->height;
+
+	return DmaPlanInit(&pThumb->plan);
+}
+
+void ThumbGreenOrigin(const enum EnBayerOrder enBayerOrder, uint16 *pX, uint16 *pY)
+{
+	*pY = 0;
+	*pX = enBayerOrder == ROW_GBGB || enBayerOrder == ROW_GRGR ? 0 : 1;
+}
+
+OSC_ERR ThumbStart(struct THUMB *pThumb, const uint8 *pSrc)
+{
+	pThumb->move.pSrc = pSrc + (uint32) pThumb->y0 * pThumb->srcWidth + pThumb->x0;
+
+#if defined(OSC_TARGET)
+	/* The DMA bypasses the data cache: write back cached picture pixels
+	 * and drop cached thumbnail lines which the transfer overwrites. */
+	cacheflush((void *) pSrc, (uint32) pThumb->srcWidth * pThumb->srcHeight, DCACHE);
+	cacheflush(pThumb->pData, (uint32) pThumb->width * pThumb->height, DCACHE);
+#endif
+
+	return DmaPlanStart(&pThumb->plan, &pThumb->move, 1);
+}
+
+OSC_ERR ThumbSync(struct THUMB *pThumb)
+{
+	uint32 cycles = OscSupCycGet();
+	OSC_ERR err;
+
+	err = DmaPlanSync(&pThumb->plan);
+	pThumb->waitCycles += OscSupCycGet() - cycles;
+
+	return err;
+}
+
+void ThumbGather(const struct THUMB *pThumb, const uint8 *pSrc, uint8 *pDst)
+{
+	const uint8 *pRow = pSrc + (uint32) pThumb->y0 * pThumb->srcWidth + pThumb->x0;
+	uint16 x, y;
+
+	for (y = 0; y < pThumb->height; y++) {
+		for (x = 0; x < pThumb->width; x++)
+			pDst[x] = pRow[x * pThumb->step];
+		pDst += pThumb->width;
+		pRow += pThumb->move.srcStride;
+	}
+}
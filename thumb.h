@@ -0,0 +1,116 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file thumb.h
+ * @brief Thumbnails of greyscale and raw pictures gathered by DMA.
+ * Every step-th pixel of every step-th row is gathered into a compact
+ * thumbnail by a strided 2D DMA transfer, while the CPU does something
+ * else. With an even step and a green origin, the thumbnail of a Bayer
+ * mosaic holds green pixels only. On the host, the transfer is emulated.
+ */
+
+#ifndef THUMB_H_
+#define THUMB_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "dmaplan.h"
+
+/*! @brief State of a thumbnail. */
+struct THUMB {
+	/*! @brief Thumbnail dimensions. */
+	uint16 width, height;
+	/*! @brief Picture dimensions. */
+	uint16 srcWidth, srcHeight;
+	/*! @brief Distance of the gathered pixels and rows. */
+	uint16 step;
+	/*! @brief Picture position of the first gathered pixel. */
+	uint16 x0, y0;
+	/*! @brief Thumbnail pixels, owned by the caller. */
+	uint8 *pData;
+	/*! @brief DMA plan and move gathering the pixels. */
+	struct DMA_PLAN plan;
+	struct DMA_MOVE move;
+	/*! @brief Cycles the CPU waited for the transfers. */
+	uint32 waitCycles;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a thumbnail of pictures of a given size.
+ *
+ * The thumbnail is (srcWidth - x0) / step by (srcHeight - y0) / step
+ * pixels, rounded up. Requires the dma module to be loaded.
+ *
+ * @param pThumb Thumbnail to initialize.
+ * @param srcWidth Picture width.
+ * @param srcHeight Picture height.
+ * @param step Distance of the gathered pixels and rows.
+ * @param x0 Column of the first gathered pixel.
+ * @param y0 Row of the first gathered pixel.
+ * @param pData Buffer of width * height bytes for the thumbnail.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ThumbInit(struct THUMB *pThumb,
+		const uint16 srcWidth,
+		const uint16 srcHeight,
+		const uint16 step,
+		const uint16 x0,
+		const uint16 y0,
+		uint8 *pData);
+
+/*********************************************************************//*!
+ * @brief Get the position of a green pixel of a Bayer mosaic.
+ *
+ * Used as origin of a thumbnail with an even step.
+ *
+ * @param enBayerOrder Bayer order of the first row.
+ * @param pX Column of the green pixel in the first row.
+ * @param pY Row of the green pixel.
+ *//*********************************************************************/
+void ThumbGreenOrigin(const enum EnBayerOrder enBayerOrder, uint16 *pX, uint16 *pY);
+
+/*********************************************************************//*!
+ * @brief Start gathering the thumbnail of a picture.
+ *
+ * Neither the picture nor the thumbnail may be accessed until synced.
+ *
+ * @param pThumb Thumbnail, synced if it was started before.
+ * @param pSrc Picture.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ThumbStart(struct THUMB *pThumb, const uint8 *pSrc);
+
+/*********************************************************************//*!
+ * @brief Wait until the thumbnail is gathered.
+ *
+ * @param pThumb Started thumbnail.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR ThumbSync(struct THUMB *pThumb);
+
+/*********************************************************************//*!
+ * @brief Gather the thumbnail of a picture with the CPU.
+ *
+ * Gives the same thumbnail as ThumbStart and ThumbSync.
+ *
+ * @param pThumb Thumbnail.
+ * @param pSrc Picture.
+ * @param pDst Buffer of width * height bytes for the thumbnail.
+ *//*********************************************************************/
+void ThumbGather(const struct THUMB *pThumb, const uint8 *pSrc, uint8 *pDst);
+
+#endif /* THUMB_H_ */
@@ -0,0 +1,255 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file tilestream.c
+ * @brief DMA streamed tile processing of greyscale images.
+ * Tile t is processed in buffer t % 2. The chain started before processing
+ * it writes back the result of tile t - 1 and fetches tile t + 1, both
+ * from and to the other buffers, so only one step is in flight at a time.
+ * The emulated DMA of the host carries out the moves only when synced,
+ * which exposes a kernel touching a buffer before its transfer is done.
+ * Requires the sup and dma modules to be loaded.
+ */
+
+#include "tilestream.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(OSC_TARGET)
+#include <bfin_sram.h>
+#include <sys/cachectl.h>
+#endif
+
+OSC_ERR TileStreamInit(struct TILE_STREAM *pStream,
+		const uint16 width,
+		const uint16 height,
+		const uint16 tileWidth,
+		const uint16 tileHeight)
+{
+	/* Keep the tile buffers word aligned. */
+	uint32 tileSize = ((uint32) tileWidth * tileHeight + 3) & ~3UL;
+	OSC_ERR err;
+	uint8 i;
+
+	if (width == 0 || height == 0 || tileWidth == 0 || tileHeight == 0)
+		return -EINVALID_PARAMETER;
+
+	memset(pStream, 0, sizeof(struct TILE_STREAM));
+	pStream->width = width;
+	pStream->height = height;
+	pStream->tileWidth = tileWidth < width ? tileWidth : width;
+	pStream->tileHeight = tileHeight < height ? tileHeight : height;
+
+#if defined(OSC_TARGET)
+	pStream->pScratch = sram_alloc(4 * tileSize, L1_DATA_SRAM);
+	pStream->bOnChip = pStream->pScratch != NULL;
+#endif
+	if (pStream->pScratch == NULL)
+		pStream->pScratch = malloc(4 * tileSize);
+	if (pStream->pScratch == NULL)
+		return -EOUT_OF_MEMORY;
+
+	for (i = 0; i < 2; i++) {
+		pStream->pIn[i] = pStream->pScratch + i * tileSize;
+		pStream->pOut[i] = pStream->pScratch + (2 + i) * tileSize;
+	}
+
+	err = DmaPlanInit(&pStream->plan);
+	if (err != SUCCESS) {
+		TileStreamDestroy(pStream);
+		return err;
+	}
+
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Start the moves collected for a step.
+ *
+ * @param pStream Stream.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR startMoves(struct TILE_STREAM *pStream)
+{
+	if (pStream->nMoves == 0)
+		return SUCCESS;
+
+	return DmaPlanStart(&pStream->plan, pStream->moves, pStream->nMoves);
+}
+
+/*********************************************************************//*!
+ * @brief Wait for the moves of a step, so that new ones can be collected.
+ *
+ * @param pStream Stream.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR syncMoves(struct TILE_STREAM *pStream)
+{
+	uint32 cycles = OscSupCycGet();
+	OSC_ERR err;
+
+	err = DmaPlanSync(&pStream->plan);
+	pStream->waitCycles += OscSupCycGet() - cycles;
+	pStream->nMoves = 0;
+
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Get the position and size of a tile.
+ *
+ * @param pStream Stream.
+ * @param t Tile number.
+ * @param pRect Move between the image and the tile buffer to complete.
+ * @param pX Left column of the tile.
+ * @param pY Top row of the tile.
+ *//*********************************************************************/
+static void tileRect(const struct TILE_STREAM *pStream,
+		const uint32 t,
+		struct DMA_MOVE *pRect,
+		uint16 *pX,
+		uint16 *pY)
+{
+	uint32 nX = (pStream->width + pStream->tileWidth - 1) / pStream->tileWidth;
+
+	*pX = (t % nX) * pStream->tileWidth;
+	*pY = (t / nX) * pStream->tileHeight;
+	pRect->width = pStream->width - *pX < pStream->tileWidth ?
+			pStream->width - *pX : pStream->tileWidth;
+	pRect->height = pStream->height - *pY < pStream->tileHeight ?
+			pStream->height - *pY : pStream->tileHeight;
+}
+
+/*********************************************************************//*!
+ * @brief Add the fetch of a tile to the moves of a step.
+ *
+ * @param pStream Stream.
+ * @param pSrc Input image.
+ * @param t Tile number.
+ *//*********************************************************************/
+static void fetchTile(struct TILE_STREAM *pStream, const uint8 *pSrc, const uint32 t)
+{
+	struct DMA_MOVE *pMove = &pStream->moves[pStream->nMoves++];
+	uint16 x, y;
+
+	tileRect(pStream, t, pMove, &x, &y);
+	pMove->pSrc = pSrc + (uint32) y * pStream->width + x;
+	pMove->srcStride = pStream->width;
+	pMove->srcStep = 1;
+	pMove->pDst = pStream->pIn[t % 2];
+	pMove->dstStride = pMove->width;
+}
+
+/*********************************************************************//*!
+ * @brief Add the write back of a processed tile to the moves of a step.
+ *
+ * @param pStream Stream.
+ * @param pDst Output image.
+ * @param t Tile number.
+ *//*********************************************************************/
+static void writeTile(struct TILE_STREAM *pStream, uint8 *pDst, const uint32 t)
+{
+	struct DMA_MOVE *pMove = &pStream->moves[pStream->nMoves++];
+	uint16 x, y;
+
+	tileRect(pStream, t, pMove, &x, &y);
+	pMove->pSrc = pStream->pOut[t % 2];
+	pMove->srcStride = pMove->width;
+	pMove->srcStep = 1;
+	pMove->pDst = pDst + (uint32) y * pStream->width + x;
+	pMove->dstStride = pStream->width;
+}
+
+OSC_ERR TileStreamRun(struct TILE_STREAM *pStream,
+		const uint8 *pSrc,
+		uint8 *pDst,
+		TILE_KERNEL kernel,
+		void *pArg)
+{
+	uint32 nX = (pStream->width + pStream->tileWidth - 1) / pStream->tileWidth;
+	uint32 nY = (pStream->height + pStream->tileHeight - 1) / pStream->tileHeight;
+	uint32 n = nX * nY, t;
+	struct DMA_MOVE rect;
+	uint16 x, y;
+	OSC_ERR err;
+
+#if defined(OSC_TARGET)
+	/* The DMA bypasses the data cache: write back cached source pixels
+	 * and drop cached output lines which the transfers overwrite. */
+	cacheflush((void *) pSrc, (uint32) pStream->width * pStream->height, DCACHE);
+	if (pDst != NULL)
+		cacheflush(pDst, (uint32) pStream->width * pStream->height, DCACHE);
+#endif
+
+	fetchTile(pStream, pSrc, 0);
+	err = startMoves(pStream);
+
+	for (t = 0; t < n && err == SUCCESS; t++) {
+		/* Tile t is fetched and the result of tile t - 2 written back. */
+		err = syncMoves(pStream);
+		if (err != SUCCESS)
+			break;
+
+		/* Write back tile t - 1 and fetch tile t + 1 meanwhile. */
+		if (pDst != NULL && t > 0)
+			writeTile(pStream, pDst, t - 1);
+		if (t + 1 < n)
+			fetchTile(pStream, pSrc, t + 1);
+		err = startMoves(pStream);
+		if (err != SUCCESS)
+			break;
+
+		tileRect(pStream, t, &rect, &x, &y);
+		kernel(pArg, pStream->pIn[t % 2], pDst != NULL ? pStream->pOut[t % 2] : NULL,
+				x, y, rect.width, rect.height);
+		pStream->nTiles++;
+	}
+
+	/* Write back the last tile. */
+	if (err == SUCCESS)
+		err = syncMoves(pStream);
+	if (err == SUCCESS && pDst != NULL) {
+		writeTile(pStream, pDst, n - 1);
+		err = startMoves(pStream);
+		if (err == SUCCESS)
+			err = syncMoves(pStream);
+	}
+
+	if (err != SUCCESS) {
+		/* Leave no transfer running into the buffers. */
+		syncMoves(pStream);
+	}
+
+	return err;
+}
+
+void TileStreamDestroy(struct TILE_STREAM *pStream)
+{
+	if (pStream->pScratch == NULL)
+		return;
+
+#if defined(OSC_TARGET)
+	if (pStream->bOnChip) {
+		sram_free(pStream->pScratch);
+		pStream->pScratch = NULL;
+		return;
+	}
+#endif
+	free(pStream->pScratch);
+	pStream->pScratch = NULL;
+}
@@ -0,0 +1,122 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file tilestream.h
+ * @brief DMA streamed tile processing of greyscale images.
+ * The image is cut into tiles which are moved into on-chip memory by 2D
+ * DMA transfers. While a kernel processes one tile, the next one is
+ * fetched and the result of the previous one is written back. On the host,
+ * the transfers are emulated with memcpy.
+ */
+
+#ifndef TILESTREAM_H_
+#define TILESTREAM_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "dmaplan.h"
+
+/*********************************************************************//*!
+ * @brief Kernel processing a tile.
+ *
+ * The tile rows are stored without gaps, i.e. the row stride is the tile
+ * width. Tiles at the right and bottom border may be smaller.
+ *
+ * @param pArg Argument passed to TileStreamRun.
+ * @param pIn Input tile.
+ * @param pOut Output tile of the same size (NULL without output image).
+ * @param x Left column of the tile in the image.
+ * @param y Top row of the tile in the image.
+ * @param width Tile width.
+ * @param height Tile height.
+ *//*********************************************************************/
+typedef void (*TILE_KERNEL)(void *pArg,
+		const uint8 *pIn,
+		uint8 *pOut,
+		const uint16 x,
+		const uint16 y,
+		const uint16 width,
+		const uint16 height);
+
+/*! @brief State of a tile stream. */
+struct TILE_STREAM {
+	/*! @brief Image dimensions. */
+	uint16 width, height;
+	/*! @brief Maximum tile dimensions. */
+	uint16 tileWidth, tileHeight;
+	/*! @brief Tile buffers: two for input and two for output. */
+	uint8 *pIn[2], *pOut[2];
+	/*! @brief Start of the tile buffers and TRUE if they are on-chip. */
+	uint8 *pScratch;
+	int bOnChip;
+	/*! @brief DMA plan carrying out the moves of a step. */
+	struct DMA_PLAN plan;
+	/*! @brief Moves of the running step. */
+	struct DMA_MOVE moves[2];
+	uint8 nMoves;
+	/*! @brief Number of tiles processed. */
+	uint32 nTiles;
+	/*! @brief Cycles the CPU waited for transfers. */
+	uint32 waitCycles;
+};
+
+/*********************************************************************//*!
+ * @brief Set up a tile stream and allocate its tile buffers.
+ *
+ * The four tile buffers are allocated in L1 data SRAM if available,
+ * otherwise in external memory. Requires the dma module to be loaded.
+ *
+ * @param pStream Stream to initialize.
+ * @param width Image width.
+ * @param height Image height.
+ * @param tileWidth Maximum tile width.
+ * @param tileHeight Maximum tile height.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR TileStreamInit(struct TILE_STREAM *pStream,
+		const uint16 width,
+		const uint16 height,
+		const uint16 tileWidth,
+		const uint16 tileHeight);
+
+/*********************************************************************//*!
+ * @brief Run a kernel on all tiles of an image.
+ *
+ * The tiles are processed row by row. The output tiles are written to
+ * the corresponding positions of the output image.
+ *
+ * @param pStream Stream.
+ * @param pSrc Input image.
+ * @param pDst Output image (may be NULL if the kernel has no output).
+ * @param kernel Kernel called for each tile.
+ * @param pArg Argument passed to the kernel.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR TileStreamRun(struct TILE_STREAM *pStream,
+		const uint8 *pSrc,
+		uint8 *pDst,
+		TILE_KERNEL kernel,
+		void *pArg);
+
+/*********************************************************************//*!
+ * @brief Free the tile buffers of a stream.
+ *
+ * @param pStream Stream.
+ *//*********************************************************************/
+void TileStreamDestroy(struct TILE_STREAM *pStream);
+
+#endif /* TILESTREAM_H_ */
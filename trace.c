@@ -0,0 +1,273 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file trace.c
+ * @brief Per-thread trace of the program stages, for Chrome or Perfetto.
+ * The end of a stage is stamped with the 32 bit cycle counter, extended to
+ * 64 bit by the ring: a count below the last one is an overflow. A thread
+ * idle for longer than a counter period misses overflows, so it takes up
+ * the ones the profile has counted meanwhile, read lock-free as a single
+ * word. The threads thus share the time base of the profile. Only a stage
+ * ending after such an idle time and before the profile has seen the
+ * latest overflow is placed a counter period early. The head of a ring is
+ * advanced after its event is written; a dump reads the head before and
+ * after copying the events and drops those which may have been overwritten
+ * in between.
+ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(OSC_HOST)
+/*! @brief Orders the memory accesses around the ring heads. */
+#define BARRIER() __sync_synchronize()
+#else
+/*! @brief The Blackfin is a single core, a compiler barrier suffices. */
+#define BARRIER() __asm__ __volatile__ ("" : : : "memory")
+#endif
+
+OSC_ERR TraceInit(struct TRACE *pTrace, struct PROF *pProf)
+{
+	memset(pTrace, 0, sizeof(struct TRACE));
+	pTrace->pProf = pProf;
+	pTrace->startCycles = ProfCyclesRead(pProf);
+	if (pthread_mutex_init(&pTrace->lock, NULL) != 0)
+		return -EDEVICE;
+
+	return SUCCESS;
+}
+
+struct TRACE_RING *TraceRing(struct TRACE *pTrace, const char *name)
+{
+	struct TRACE_RING *pRing = NULL;
+	struct TRACE_EVENT *pEvents;
+
+	pEvents = malloc(TRACE_RING_EVENTS * sizeof(struct TRACE_EVENT));
+	if (pEvents == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&pTrace->lock);
+	if (pTrace->nRings < TRACE_MAX_RINGS) {
+		pRing = &pTrace->rings[pTrace->nRings];
+		pRing->pTrace = pTrace;
+		strncpy(pRing->name, name, TRACE_MAX_NAME - 1);
+		pRing->name[TRACE_MAX_NAME - 1] = '\0';
+		pRing->pEvents = pEvents;
+		pRing->head = 0;
+		pRing->cycles = ProfCyclesRead(pTrace->pProf);
+		BARRIER();
+		pTrace->nRings++;
+	}
+	pthread_mutex_unlock(&pTrace->lock);
+
+	if (pRing == NULL)
+		free(pEvents);
+	return pRing;
+}
+
+void TraceEnable(struct TRACE *pTrace, const int bEnable)
+{
+	pTrace->bEnabled = bEnable;
+}
+
+void TraceAdd(struct TRACE_RING *pRing, const char *name, const uint32 start)
+{
+	struct TRACE_EVENT *pEvent = &pRing->pEvents[pRing->head % TRACE_RING_EVENTS];
+	uint32 now = OscSupCycGet() & 0xFFFFFFFFUL;
+	uint32 high = (uint32) (pRing->cycles >> 32);
+	uint32 nOverflows = pRing->pTrace->pProf->nOverflows;
+
+	if (now < (uint32) (pRing->cycles & 0xFFFFFFFFUL))
+		high++;
+	if (high < nOverflows)
+		high = nOverflows;
+	pRing->cycles = ((unsigned long long) high << 32) + now;
+
+	pEvent->name = name;
+	pEvent->end = pRing->cycles;
+	/* The difference of the 32 bit counts, also where uint32 is wider. */
+	pEvent->cycles = (now - start) & 0xFFFFFFFFUL;
+	BARRIER();
+	pRing->head++;
+}
+
+/*********************************************************************//*!
+ * @brief Copy the events of a ring which are not being overwritten.
+ *
+ * @param pRing Ring.
+ * @param pCopy Buffer of TRACE_RING_EVENTS events.
+ * @return Number of events copied, oldest first
+ *//*********************************************************************/
+static uint32 copyRing(const struct TRACE_RING *pRing, struct TRACE_EVENT *pCopy)
+{
+	uint32 first, head, i, n;
+
+	head = pRing->head;
+	BARRIER();
+	first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+	for (i = first; i < head; i++)
+		pCopy[i - first] = pRing->pEvents[i % TRACE_RING_EVENTS];
+	BARRIER();
+
+	/* Drop the events the thread may have overwritten while copying,
+	 * one more than it added, as it may be writing the next one. */
+	n = head - first;
+	i = pRing->head + 1 - head;
+	if (i >= n)
+		return 0;
+	memmove(pCopy, pCopy + i, (n - i) * sizeof(struct TRACE_EVENT));
+	return n - i;
+}
+
+/*********************************************************************//*!
+ * @brief Print a cycle count as microseconds with three decimals.
+ *
+ * @param pFile File to print to.
+ * @param cycles Cycles.
+ *//*********************************************************************/
+static void printMicroSecs(FILE *pFile, const unsigned long long cycles)
+{
+	unsigned long long ns = ProfMicroSecs(cycles * 1000);
+
+	fprintf(pFile, "%llu.%03llu", ns / 1000, ns % 1000);
+}
+
+OSC_ERR TraceDump(struct TRACE *pTrace, const char *fileName)
+{
+	struct TRACE_EVENT *pCopy;
+	unsigned long long start;
+	uint32 i, j, n;
+	uint8 nRings = pTrace->nRings;
+	int pid = getpid(), bFirst = TRUE;
+	FILE *pFile;
+
+	BARRIER();
+	pCopy = malloc(TRACE_RING_EVENTS * sizeof(struct TRACE_EVENT));
+	if (pCopy == NULL)
+		return -EOUT_OF_MEMORY;
+
+	pFile = fopen(fileName, "w");
+	if (pFile == NULL) {
+		fprintf(stderr, "%s: ERROR: Unable to write %s!\n", __func__, fileName);
+		free(pCopy);
+		return -EUNABLE_TO_OPEN_FILE;
+	}
+
+	fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (i = 0; i < nRings; i++) {
+		fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+				bFirst ? "" : ",\n", pid, (unsigned long) i + 1, pTrace->rings[i].name);
+		bFirst = FALSE;
+
+		n = copyRing(&pTrace->rings[i], pCopy);
+		for (j = 0; j < n; j++) {
+			start = pCopy[j].end - pCopy[j].cycles;
+			fprintf(pFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":",
+					pCopy[j].name, pid, (unsigned long) i + 1);
+			printMicroSecs(pFile, start > pTrace->startCycles ? start - pTrace->startCycles : 0);
+			fprintf(pFile, ",\"dur\":");
+			printMicroSecs(pFile, pCopy[j].cycles);
+			fprintf(pFile, "}");
+		}
+	}
+	fprintf(pFile, "\n]}\n");
+
+	free(pCopy);
+	if (fclose(pFile) != 0)
+		return -EFILE_ERROR;
+	return SUCCESS;
+}
+
+/*********************************************************************//*!
+ * @brief Writer thread: write the stages kept on each request until
+ * stopped.
+ *
+ * @param pArg Trace.
+ * @return NULL
+ *//*********************************************************************/
+static void * writer(void *pArg)
+{
+	struct TRACE *pTrace = (struct TRACE *) pArg;
+
+	while (1) {
+		sem_wait(&pTrace->requested);
+		if (pTrace->bStop)
+			break;
+
+		pTrace->bPending = FALSE;
+		BARRIER();
+		if (TraceDump(pTrace, pTrace->fileName) == SUCCESS)
+			printf("Trace written to %s.\n", pTrace->fileName);
+	}
+
+	return NULL;
+}
+
+OSC_ERR TraceStartWriter(struct TRACE *pTrace, const char *fileName)
+{
+	if (pTrace->bWriter)
+		return -EALREADY_INITIALIZED;
+
+	pTrace->fileName = fileName;
+	pTrace->bPending = FALSE;
+	pTrace->bStop = FALSE;
+	if (sem_init(&pTrace->requested, 0, 0) != 0)
+		return -EDEVICE;
+	if (pthread_create(&pTrace->writer, NULL, writer, pTrace) != 0) {
+		fprintf(stderr, "%s: ERROR: Unable to start writer thread!\n", __func__);
+		sem_destroy(&pTrace->requested);
+		return -EDEVICE;
+	}
+	pTrace->bWriter = TRUE;
+
+	return SUCCESS;
+}
+
+void TraceRequestDump(struct TRACE *pTrace)
+{
+	if (!pTrace->bWriter || pTrace->bPending)
+		return;
+
+	pTrace->bPending = TRUE;
+	BARRIER();
+	sem_post(&pTrace->requested);
+}
+
+void TraceDestroy(struct TRACE *pTrace)
+{
+	uint8 i;
+
+	pTrace->bEnabled = FALSE;
+	if (pTrace->bWriter) {
+		pTrace->bStop = TRUE;
+		BARRIER();
+		sem_post(&pTrace->requested);
+		pthread_join(pTrace->writer, NULL);
+		sem_destroy(&pTrace->requested);
+		pTrace->bWriter = FALSE;
+	}
+	for (i = 0; i < pTrace->nRings; i++) {
+		free(pTrace->rings[i].pEvents);
+		pTrace->rings[i].pEvents = NULL;
+	}
+	pTrace->nRings = 0;
+	pthread_mutex_destroy(&pTrace->lock);
+}
@@ -0,0 +1,186 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file trace.h
+ * @brief Per-thread trace of the program stages, for Chrome or Perfetto.
+ * Each thread adds the stages it runs, with their end and duration in
+ * cycles, to a ring of its own, which only it writes. Adding reads the
+ * cycle counter directly and extends it to 64 bit per ring, so it takes no
+ * lock at all. The rings keep the last TRACE_RING_EVENTS stages of each
+ * thread and are written on request as trace event JSON, which
+ * chrome://tracing and ui.perfetto.dev display, by a writer thread of the
+ * trace so that the traced loop does not wait for the file. While the
+ * trace is disabled, TRACE_STOP costs a test of a flag.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "oscar/staging/inc/oscar.h"
+#include "prof.h"
+#include <pthread.h>
+#include <semaphore.h>
+
+/*! @brief Maximum number of traced threads. */
+#define TRACE_MAX_RINGS 8
+/*! @brief Stages kept per thread, a power of two. */
+#define TRACE_RING_EVENTS 4096
+/*! @brief Maximum length of a thread name. */
+#define TRACE_MAX_NAME 16
+
+/*********************************************************************//*!
+ * @brief Add a stage to the ring of the calling thread if tracing.
+ *
+ * @param pRing Ring of the thread (may be NULL).
+ * @param name Name of the stage, a string constant.
+ * @param start Cycle count at the start of the stage (ProfStart).
+ *//*********************************************************************/
+#define TRACE_STOP(pRing, name, start) \
+	do { \
+		if ((pRing) != NULL && (pRing)->pTrace->bEnabled) \
+			TraceAdd((pRing), (name), (start)); \
+	} while (0)
+
+/*! @brief A stage run by a thread. */
+struct TRACE_EVENT {
+	/*! @brief Name of the stage. */
+	const char *name;
+	/*! @brief 64 bit cycle count at the end of the stage and cycles taken. */
+	unsigned long long end;
+	uint32 cycles;
+};
+
+/*! @brief The stages of a thread. */
+struct TRACE_RING {
+	/*! @brief Trace the ring belongs to. */
+	struct TRACE *pTrace;
+	/*! @brief Name of the thread. */
+	char name[TRACE_MAX_NAME];
+	/*! @brief Events, the next one is written at head % TRACE_RING_EVENTS. */
+	struct TRACE_EVENT *pEvents;
+	/*! @brief Number of events added, only written by the thread. */
+	volatile uint32 head;
+	/*! @brief 64 bit cycle count at the last event, only written by the
+	 * thread. */
+	unsigned long long cycles;
+};
+
+/*! @brief State of a trace. */
+struct TRACE {
+	/*! @brief Rings of the threads. */
+	struct TRACE_RING rings[TRACE_MAX_RINGS];
+	uint8 nRings;
+	/*! @brief TRUE while stages are added. */
+	volatile int bEnabled;
+	/*! @brief Profile whose count of overflows places the rings of idle
+	 * threads. */
+	struct PROF *pProf;
+	/*! @brief Cycle count at initialization, the time origin. */
+	unsigned long long startCycles;
+	/*! @brief Protects adding rings. */
+	pthread_mutex_t lock;
+	/*! @brief Writer thread of the requested dumps, if started, and the
+	 * file it writes. */
+	pthread_t writer;
+	int bWriter;
+	const char *fileName;
+	/*! @brief Posted on a request, the writer waits on it. */
+	sem_t requested;
+	/*! @brief TRUE from a request until its dump starts. */
+	volatile int bPending;
+	volatile int bStop;
+};
+
+/*********************************************************************//*!
+ * @brief Initialize a disabled trace without rings.
+ *
+ * @param pTrace Trace to initialize.
+ * @param pProf Initialized profile, its 64 bit cycle count is the time
+ * base of the stages.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR TraceInit(struct TRACE *pTrace, struct PROF *pProf);
+
+/*********************************************************************//*!
+ * @brief Get a ring for a thread.
+ *
+ * Meant for setting up. Each thread adds to its own ring only.
+ *
+ * @param pTrace Trace.
+ * @param name Name of the thread.
+ * @return The ring, NULL if there are too many or no memory is left
+ *//*********************************************************************/
+struct TRACE_RING *TraceRing(struct TRACE *pTrace, const char *name);
+
+/*********************************************************************//*!
+ * @brief Start or stop adding stages.
+ *
+ * @param pTrace Trace.
+ * @param bEnable TRUE to add stages.
+ *//*********************************************************************/
+void TraceEnable(struct TRACE *pTrace, const int bEnable);
+
+/*********************************************************************//*!
+ * @brief Add a stage to a ring, use TRACE_STOP instead.
+ *
+ * @param pRing Ring of the calling thread.
+ * @param name Name of the stage, a string constant.
+ * @param start Cycle count at the start of the stage (ProfStart).
+ *//*********************************************************************/
+void TraceAdd(struct TRACE_RING *pRing, const char *name, const uint32 start);
+
+/*********************************************************************//*!
+ * @brief Write the stages kept as Chrome trace event JSON.
+ *
+ * May be called while the threads go on adding stages; stages
+ * overwritten meanwhile are left out.
+ *
+ * @param pTrace Trace.
+ * @param fileName File to write.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR TraceDump(struct TRACE *pTrace, const char *fileName);
+
+/*********************************************************************//*!
+ * @brief Start a thread writing the stages kept whenever requested.
+ *
+ * @param pTrace Trace.
+ * @param fileName File to write, a string constant.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+OSC_ERR TraceStartWriter(struct TRACE *pTrace, const char *fileName);
+
+/*********************************************************************//*!
+ * @brief Request the writer thread to write the stages kept; never
+ * blocks.
+ *
+ * Requests made while one is pending are merged into it.
+ *
+ * @param pTrace Trace with a started writer.
+ *//*********************************************************************/
+void TraceRequestDump(struct TRACE *pTrace);
+
+/*********************************************************************//*!
+ * @brief Stop the writer thread, if started, and free the rings of a
+ * trace.
+ *
+ * @param pTrace Trace.
+ *//*********************************************************************/
+void TraceDestroy(struct TRACE *pTrace);
+
+#endif /* TRACE_H_ */
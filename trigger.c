@@ -0,0 +1,349 @@
+/*	A collection of example applications for the LeanXcam platform.
+	Copyright (C) 2008 Supercomputing Systems AG
+
+	This library is free software; you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation; either version 2.1 of the License, or (at
+	your option) any later version.
+
+	This library is distributed in the hope that it will be useful, but
+	WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+	General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this library; if not, write to the Free Software Foundation,
+	Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*!@file trigger.c
+ * @brief Capture triggered by a GPIO input.
+ * A rising edge on TRIGGER_PIN (e.g. a door contact or a light barrier)
+ * triggers a capture at once. The picture is compared with the
+ * background, and GPIO_OUT2 is set if it shows motion, cleared otherwise.
+ * The main loop waits for the edges of a watching thread (gpioedge.c)
+ * and does not read the pins itself. Each stage is timed from the moment
+ * the edge is seen: trigger, readout, decision and output pin. The
+ * distributions are reported on SIGUSR1 and at the end, with the
+ * intervals the inputs were sampled at, by which the edges may have
+ * happened earlier. On the host, the edges are replayed from gpio_in.txt
+ * and the frames with -r, so the latency from the edge to the decision
+ * can be measured without a camera.
+ */
+
+#include "oscar/staging/inc/oscar.h"
+#include "gpioedge.h"
+#include "replay.h"
+#include "debayer.h"
+#include "thumb.h"
+#include "picstat.h"
+#include "detect.h"
+#include "prof.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#define IMAGE_WIDTH 752
+#define IMAGE_HEIGHT 480
+#define BAYER_INPUT 1 /* Pictures are a Bayer mosaic (colour sensor), 0 on a monochrome sensor */
+#define TRIGGER_PIN GPIO_IN1 /* Input whose rising edges trigger a capture */
+#define GPIO_REPLAY "gpio_in.txt" /* Edges replayed on the host */
+#define CAPTURE_TIMEOUT 500 /* ms to wait for a picture */
+#define EDGE_TIMEOUT 1000 /* ms to wait for an edge before checking for a report */
+#define SHUTTER_WIDTH 10000 /* Exposure time in us */
+#define THUMB_STEP 4 /* Distance of the pixels and rows averaged for the mean */
+#define COOLDOWN_FRAMES 1 /* Each trigger decides on its own, unlike the detection defaults of detect.h */
+#define LEARN_INTERLEAVE 1 /* All background rows are updated, the triggers are far apart */
+
+/*! @brief Framework module dependencies. */
+struct OSC_DEPENDENCY deps[] = {
+	{ "sup", OscSupCreate, OscSupDestroy },
+	{ "cam", OscCamCreate, OscCamDestroy },
+	{ "gpio", OscGpioCreate, OscGpioDestroy },
+};
+
+/*! @brief Stage profile, reported when bReport is set by SIGUSR1. */
+static struct PROF prof;
+static volatile sig_atomic_t bReport = 0;
+
+/*! @brief Timers of the stages, from the edge on. */
+static struct PROF_TIMER *pTriggerTimer, *pReadoutTimer, *pDecisionTimer, *pOutputTimer, *pTotalTimer;
+
+/*! @brief Frame buffer (word aligned). */
+static unsigned long frameBuffer[IMAGE_WIDTH * IMAGE_HEIGHT / sizeof(unsigned long)];
+
+#if BAYER_INPUT
+/*! @brief Luma of the current picture (word aligned). */
+static unsigned long luma[IMAGE_WIDTH * IMAGE_HEIGHT / sizeof(unsigned long)];
+#endif
+
+/*! @brief Background model (word aligned). */
+static unsigned long background[IMAGE_WIDTH * IMAGE_HEIGHT / sizeof(unsigned long)];
+static unsigned long backgroundFraction[IMAGE_WIDTH * IMAGE_HEIGHT / sizeof(unsigned long)];
+
+/*********************************************************************//*!
+ * @brief Signal handler: request a report of the stage latencies.
+ * 
+ * @param sig Signal number.
+ *//*********************************************************************/
+static void requestReport(int sig)
+{
+	bReport = 1;
+}
+
+/*********************************************************************//*!
+ * @brief Capture a picture at once.
+ * 
+ * @param pReplay Replayed frames, NULL to capture with the camera.
+ * @param ppRaw The picture.
+ * @param pTriggered Cycle count when the capture was triggered.
+ * @return SUCCESS or an appropriate error code otherwise
+ *//*********************************************************************/
+static OSC_ERR capture(struct REPLAY *pReplay, uint8 **ppRaw, uint32 *pTriggered)
+{
+	OSC_ERR err;
+
+	if (pReplay != NULL) {
+		*pTriggered = OscSupCycGet();
+		*ppRaw = (uint8 *) ReplayNext(pReplay);
+		return SUCCESS;
+	}
+
+	err = OscCamSetupCapture(0);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable setup capture! (%d)\n", __func__, err);
+		return err;
+	}
+	err = OscGpioTriggerImage();
+	*pTriggered = OscSupCycGet();
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to trigger! (%d)\n", __func__, err);
+		return err;
+	}
+	err = OscCamReadPicture(0, ppRaw, 0, CAPTURE_TIMEOUT);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable read picture! (%d)\n", __func__, err);
+	}
+	return err;
+}
+
+/*********************************************************************//*!
+ * @brief Analyse a picture.
+ * 
+ * @param pDetector Detection engine.
+ * @param pDebayer Luma conversion of the raw pictures.
+ * @param pRaw Picture as captured.
+ * @param thumbX First column of the mean.
+ * @param thumbY First row of the mean.
+ * @return Events of the picture (EnDetectEvents)
+ *//*********************************************************************/
+static uint32 analyse(struct DETECTOR *pDetector, const struct DEBAYER *pDebayer, uint8 *pRaw, const uint16 thumbX, const uint16 thumbY)
+{
+	struct OSC_PICTURE raw;
+	uint8 *pLuma = pRaw;
+
+	raw.width = IMAGE_WIDTH;
+	raw.height = IMAGE_HEIGHT;
+	raw.type = OSC_PICTURE_GREYSCALE;
+	raw.data = pRaw;
+
+#if BAYER_INPUT
+	pLuma = (uint8*)luma;
+	DebayerLuma(pDebayer, pRaw, pLuma);
+#endif
+	return DetectorFrame(pDetector, pLuma, PicStatMeanSampled(&raw, THUMB_STEP, thumbX, thumbY), 1);
+}
+
+int main(const int argc, const char * argv[])
+{
+	OSC_ERR err = SUCCESS;
+	void* hFramework;
+	struct GPIO_EDGES edges;
+	struct GPIO_EDGE edge;
+	struct REPLAY replay, *pReplay = NULL;
+	struct DEBAYER debayer;
+	enum EnBayerOrder enBayerOrder;
+	struct DETECTOR detector;
+	struct DETECT_SETTINGS settings;
+	uint16 thumbX = 0, thumbY = 0;
+	uint32 i, events, triggered, readout, decided, output, nTriggers = 0;
+	uint8 *pRaw;
+	const char *opt_replay = NULL, *opt_gpio = NULL;
+	uint32 opt_triggers = 0;
+	
+#if defined(OSC_HOST)
+	opt_gpio = GPIO_REPLAY;
+#endif
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			opt_replay = argv[++i];
+		} else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+			opt_gpio = argv[++i];
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			opt_triggers = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-h") == 0) {
+			printf("Usage: trigger [ -h ] [ -r <frames> ] [ -g <file> ] [ -n <n> ]\n");
+			printf("    -h: Prints this help.\n");
+			printf("    -r <frames>: Replays the bitmaps of a directory or list file instead of capturing.\n");
+			printf("    -g <file>: Replays the GPIO inputs of this file (default " GPIO_REPLAY " on the host).\n");
+			printf("    -n <n>: Stops after this many triggers (default never).\n");
+			return 0;
+		} else {
+			printf("Error: Unknown option: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	/* Create framework */
+	err = OscCreate(&hFramework);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: Unable to create framework.\n", __func__);
+		return err;
+	}
+	
+	/* Load the framework module dependencies. */
+	err = OscLoadDependencies(hFramework, deps, sizeof(deps)/sizeof(struct OSC_DEPENDENCY));
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to load dependencies! (%d)\n", __func__, err);
+		return err;
+	}
+
+	/* Configure the output active high */
+	err = OscGpioSetupPolarity(GPIO_OUT2, FALSE);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to set GPIO! (%d)\n", __func__, err);
+		return err;
+	}
+	OscGpioWrite(GPIO_OUT2, FALSE);
+
+	/* Setup the timers of the stages */
+	err = ProfInit(&prof);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup profile! (%d)\n", __func__, err);
+		return err;
+	}
+	pTriggerTimer = ProfTimer(&prof, "seen to trigger");
+	pReadoutTimer = ProfTimer(&prof, "trigger to readout");
+	pDecisionTimer = ProfTimer(&prof, "readout to decision");
+	pOutputTimer = ProfTimer(&prof, "decision to output");
+	pTotalTimer = ProfTimer(&prof, "seen to output");
+	signal(SIGUSR1, requestReport);
+
+	/* Configure camera */
+	OscCamPresetRegs();
+	OscCamSetAreaOfInterest(0,0,IMAGE_WIDTH,IMAGE_HEIGHT);
+	OscCamSetShutterWidth(SHUTTER_WIDTH);
+	OscCamSetFrameBuffer(0, IMAGE_WIDTH * IMAGE_HEIGHT, frameBuffer, TRUE);
+
+	/* Setup luma conversion and the mean of green pixels */
+	OscCamGetBayerOrder(&enBayerOrder, 0, 0);
+	err = DebayerInit(&debayer, IMAGE_WIDTH, IMAGE_HEIGHT, enBayerOrder, FALSE);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to setup luma conversion! (%d)\n", __func__, err);
+		return err;
+	}
+#if BAYER_INPUT
+	ThumbGreenOrigin(enBayerOrder, &thumbX, &thumbY);
+#endif
+
+	/* Load the frames to replay */
+	if (opt_replay != NULL) {
+		err = ReplayOpen(&replay, opt_replay, 0);
+		if (err == SUCCESS && (replay.width != IMAGE_WIDTH || replay.height != IMAGE_HEIGHT)) {
+			fprintf(stderr, "%s: ERROR: Replayed frames must be %ux%u pixels!\n", __func__, IMAGE_WIDTH, IMAGE_HEIGHT);
+			err = -EINVALID_PARAMETER;
+		}
+		if (err != SUCCESS) {
+			return err;
+		}
+		pReplay = &replay;
+	}
+
+	/* Learn the background from pictures triggered by software */
+	DetectDefaults(&settings, IMAGE_WIDTH, IMAGE_HEIGHT);
+	settings.cooldownFrames = COOLDOWN_FRAMES;
+	settings.learnInterleave = LEARN_INTERLEAVE;
+	err = DetectorInit(&detector, IMAGE_WIDTH, IMAGE_HEIGHT, (uint8*)background, (uint8*)backgroundFraction, &settings);
+	for (i = 0; i < settings.historyLength && err == SUCCESS; i++) {
+		err = capture(pReplay, &pRaw, &triggered);
+		if (err == SUCCESS) {
+			analyse(&detector, &debayer, pRaw, thumbX, thumbY);
+		}
+	}
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to learn the background! (%d)\n", __func__, err);
+		return err;
+	}
+
+	/* Wait for the edges */
+	err = GpioEdgesStart(&edges, opt_gpio);
+	if (err != SUCCESS) {
+		fprintf(stderr, "%s: ERROR: Unable to watch the inputs! (%d)\n", __func__, err);
+		return err;
+	}
+	printf("Waiting for rising edges on input %d.\n", TRIGGER_PIN == GPIO_IN1 ? 1 : 2);
+
+	while (opt_triggers == 0 || nTriggers < opt_triggers) {
+		if (bReport) {
+			bReport = 0;
+			ProfReport(&prof, stdout);
+			GpioEdgesPrintStats(&edges);
+		}
+		/* Keep the 64 bit cycle count of the profile going */
+		ProfCycles(&prof);
+
+		err = GpioEdgesWait(&edges, &edge, EDGE_TIMEOUT);
+		if (err == -ETIMEOUT) {
+			continue;
+		}
+		if (edge.pin != TRIGGER_PIN || !edge.bLevel) {
+			continue;
+		}
+
+		/* Capture, analyse and set the output at once */
+		err = capture(pReplay, &pRaw, &triggered);
+		if (err != SUCCESS) {
+			break;
+		}
+		readout = OscSupCycGet();
+		events = analyse(&detector, &debayer, pRaw, thumbX, thumbY);
+		decided = OscSupCycGet();
+		err = OscGpioWrite(GPIO_OUT2, (events & DETECT_MOTION) != 0);
+		output = OscSupCycGet();
+		if (err != SUCCESS) {
+			fprintf(stderr, "%s: ERROR: GPIO write error! (%d)\n", __func__, err);
+			break;
+		}
+
+		ProfRecord(pTriggerTimer, (triggered - edge.cycles) & 0xFFFFFFFFUL);
+		ProfRecord(pReadoutTimer, (readout - triggered) & 0xFFFFFFFFUL);
+		ProfRecord(pDecisionTimer, (decided - readout) & 0xFFFFFFFFUL);
+		ProfRecord(pOutputTimer, (output - decided) & 0xFFFFFFFFUL);
+		ProfRecord(pTotalTimer, (output - edge.cycles) & 0xFFFFFFFFUL);
+		nTriggers++;
+
+		printf("Trigger %lu: %s (%lu pixels), %lu us from seen edge to output, edge up to %lu us earlier\n", nTriggers,
+				(events & DETECT_MOTION) ? "motion" : "no motion", detector.changed,
+				OscSupCycToMicroSecs((output - edge.cycles) & 0xFFFFFFFFUL), OscSupCycToMicroSecs(edge.window));
+	}
+
+	GpioEdgesPrintStats(&edges);
+	GpioEdgesStop(&edges);
+	if (edges.nLost > 0) {
+		printf("%lu edges lost while busy.\n", edges.nLost);
+	}
+	ProfReport(&prof, stdout);
+	ProfDestroy(&prof);
+	if (pReplay != NULL) {
+		ReplayClose(pReplay);
+	}
+
+	/* Destroy modules */
+	OscUnloadDependencies(hFramework, deps, sizeof(deps)/sizeof(struct OSC_DEPENDENCY));
+	
+	/* Destroy framework */
+	OscDestroy(hFramework);
+	
+	return err == SUCCESS ? 0 : 1;
+}